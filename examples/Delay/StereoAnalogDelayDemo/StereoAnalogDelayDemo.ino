@@ -0,0 +1,165 @@
+/*************************************************************************
+ * This demo uses the BALibrary library to provide enhanced control of
+ * the TGA Pro board.
+ *
+ * The latest copy of the BA Guitar library can be obtained from
+ * https://github.com/Blackaddr/BALibrary
+ *
+ * This example demonstrates the AudioEffectAnalogDelayStereo effect. The
+ * left and right channels have independent delay times and can be set to
+ * ping-pong between the outputs. Both channels share one memory buffer.
+ * It can be controlled using USB MIDI. You can get a free USB MIDI Controller
+ * appliation at
+ * http://www.blackaddr.com/downloads/BAMidiTester/
+ * or the source code at
+ * https://github.com/Blackaddr/BAMidiTester
+ *
+ * Even if you don't control the guitar effect with USB MIDI, you must set
+ * the Arduino IDE USB-Type under Tools to "Serial + MIDI"
+ */
+#include <Audio.h>
+#include <MIDI.h>
+#include "BALibrary.h"
+#include "BAEffects.h"
+
+using namespace midi;
+MIDI_CREATE_DEFAULT_INSTANCE();
+
+using namespace BAEffects;
+using namespace BALibrary;
+
+AudioInputI2S i2sIn;
+AudioOutputI2S i2sOut;
+BAAudioControlWM8731 codec;
+
+/// IMPORTANT /////
+// YOU MUST COMPILE THIS DEMO USING Serial + Midi
+
+//#define USE_EXT // uncomment this line to use External MEM0
+#define MIDI_DEBUG // uncomment to see raw MIDI info in terminal
+
+#ifdef USE_EXT
+// If using external SPI memory, we will instantiance an SRAM
+// manager and create an external memory slot to use as the memory
+// for our audio delay
+ExternalSramManager externalSram;
+ExtMemSlot delaySlot; // Declare an external memory slot.
+
+// Instantiate the AudioEffectAnalogDelayStereo to use external memory by
+/// passing it the delay slot.
+AudioEffectAnalogDelayStereo stereoDelay(&delaySlot);
+#else
+// If using internal memory, we will instantiate the AudioEffectAnalogDelayStereo
+// by passing it the maximum amount of delay we will use in millseconds. Stereo
+// delays use twice the memory of mono delays.
+AudioEffectAnalogDelayStereo stereoDelay(150.0f); // max delay of 150 ms for internal.
+#endif
+
+// The guitar is mono, so feed it to both inputs of the stereo delay
+AudioConnection inputLeft(i2sIn,0, stereoDelay,0);
+AudioConnection inputRight(i2sIn,0, stereoDelay,1);
+AudioConnection leftOut(stereoDelay,0, i2sOut, 0);
+AudioConnection rightOut(stereoDelay,1, i2sOut, 1);
+
+elapsedMillis timer;
+
+void OnControlChange(byte channel, byte control, byte value) {
+  stereoDelay.processMidi(channel-1, control, value);
+  #ifdef MIDI_DEBUG
+  if (Serial) {
+    Serial.print("Control Change, ch=");
+    Serial.print(channel, DEC);
+    Serial.print(", control=");
+    Serial.print(control, DEC);
+    Serial.print(", value=");
+    Serial.print(value, DEC);
+    Serial.println();
+  }
+  #endif
+}
+
+void setup() {
+  TGA_PRO_MKII_REV1(); // Declare the version of the TGA Pro you are using.
+  //TGA_PRO_REVB(x);
+  //TGA_PRO_REVA(x);
+
+  #ifdef USE_EXT
+  SPI_MEM0_64M();   // Optional 64Mbit SPI RAM
+  //SPI_MEM0_4M();  // Older REVA and REVB boards came with 4M or 1M
+  //SPI_MEM0_1M();
+  #endif
+
+  delay(100);
+  Serial.begin(57600); // Start the serial port
+
+  // Disable the codec first
+  codec.disable();
+  delay(100);
+  AudioMemory(128);
+  delay(5);
+
+  // Enable the codec
+  if (Serial) { Serial.println("Enabling codec...\n"); }
+  codec.enable();
+  delay(100);
+
+  // If using external memory request request memory from the manager
+  // for the slot
+  #ifdef USE_EXT
+  if (Serial) { Serial.println("Using EXTERNAL memory"); }
+  // We have to request memory be allocated to our slot. The size must be a multiple
+  // of 4 bytes (one stereo frame). 500 ms on each channel is roughly 88 KB.
+  externalSram.requestMemory(&delaySlot, static_cast<size_t>(4*calcAudioSamples(500.0f)), MemSelect::MEM0, true);
+  delaySlot.clear();
+  #else
+  if (Serial) { Serial.println("Using INTERNAL memory"); }
+  #endif
+
+  // Setup MIDI
+  MIDI.begin(MIDI_CHANNEL_OMNI);
+  MIDI.setHandleControlChange(OnControlChange);
+
+  usbMIDI.setHandleControlChange(OnControlChange);
+
+  // Configure which MIDI CC's will control the effect parameters
+  stereoDelay.mapMidiControl(AudioEffectAnalogDelayStereo::BYPASS,16);
+  stereoDelay.mapMidiControl(AudioEffectAnalogDelayStereo::DELAY_LEFT,20);
+  stereoDelay.mapMidiControl(AudioEffectAnalogDelayStereo::DELAY_RIGHT,21);
+  stereoDelay.mapMidiControl(AudioEffectAnalogDelayStereo::FEEDBACK,22);
+  stereoDelay.mapMidiControl(AudioEffectAnalogDelayStereo::CROSS_FEEDBACK,23);
+  stereoDelay.mapMidiControl(AudioEffectAnalogDelayStereo::PING_PONG,24);
+  stereoDelay.mapMidiControl(AudioEffectAnalogDelayStereo::MIX,25);
+  stereoDelay.mapMidiControl(AudioEffectAnalogDelayStereo::VOLUME,26);
+
+  // Besure to enable the delay. When disabled, audio is is completely blocked
+  // to minimize resources to nearly zero.
+  stereoDelay.enable();
+
+  // Set some default values.
+  // These can be changed by sending MIDI CC messages over the USB using
+  // the BAMidiTester application.
+  stereoDelay.delayLeft(150.0f);
+  stereoDelay.delayRight(100.0f);
+  stereoDelay.bypass(false);
+  stereoDelay.mix(0.5f);
+  stereoDelay.feedback(0.3f);
+  stereoDelay.pingPong(true);
+}
+
+void loop() {
+  // usbMIDI.read() needs to be called rapidly from loop().
+
+  if (timer > 1000) {
+    timer = 0;
+    if (Serial) {
+      Serial.print("Processor Usage, Total: "); Serial.print(AudioProcessorUsage());
+      Serial.print("% ");
+      Serial.print(" stereoDelay: "); Serial.print(stereoDelay.processorUsage());
+      Serial.println("%");
+    }
+  }
+
+  MIDI.read();
+  usbMIDI.read();
+
+}
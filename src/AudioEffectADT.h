@@ -0,0 +1,152 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  AudioEffectADT is an automatic double tracker.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BAEFFECTS_AUDIOEFFECTADT_H
+#define __BAEFFECTS_AUDIOEFFECTADT_H
+
+#include <Audio.h>
+#include "LibBasicFunctions.h"
+
+namespace BAEffects {
+
+/**************************************************************************//**
+ * AudioEffectADT imitates a double-tracked part by mixing the input with a
+ * copy that drifts slightly in time and pitch, like a second performance.
+ * @details The copy is read from a short internal delay line. The delay wanders
+ * around delay() with the smoothed RANDOM LFO waveform, the amount is set so the
+ * pitch of the copy deviates by at most detune() cents. Each block costs one
+ * interpolated read per sample so the effect can be left in the signal chain.
+ *****************************************************************************/
+class AudioEffectADT : public AudioStream {
+public:
+
+	///< List of AudioEffectADT MIDI controllable parameters
+	enum {
+		BYPASS = 0,  ///< controls effect bypass
+		DELAY,       ///< controls the average delay of the double
+		DETUNE,      ///< controls the maximum pitch deviation of the double
+		RATE,        ///< controls how quickly the double wanders
+		MIX,         ///< controls the the mix of input and double
+		VOLUME,      ///< controls the output volume level
+		NUM_CONTROLS ///< this can be used as an alias for the number of MIDI controls
+	};
+
+	// *** CONSTRUCTORS ***
+	/// Construct the effect with an internal delay line.
+	/// @param maxDelayMs the longest delay() needed in milliseconds, plus the modulation
+	AudioEffectADT(float maxDelayMs = 80.0f);
+
+	virtual ~AudioEffectADT(); ///< Destructor
+
+	// *** PARAMETERS ***
+
+	/// Set the average delay of the double. 20 to 50 ms is typical.
+	/// @param milliseconds the delay in milliseconds
+	void delay(float milliseconds);
+
+	/// Set the maximum pitch deviation of the double
+	/// @param cents the detune in cents, 1/100 of a semitone
+	void detune(float cents);
+
+	/// Set how quickly the double wanders, in random changes per second
+	/// @param rateHz the modulation rate in Hertz
+	void rate(float rateHz);
+
+	/// Set the amount of blending between dry and double at the output.
+	/// @param mix When 0.0, output is 100% dry, when 1.0, output is 100% double.
+	void mix(float mix) { m_mix = mix; }
+
+	/// Bypass the effect.
+	/// @param byp when true, bypass wil disable the effect, when false, effect is enabled.
+	/// Note that audio still passes through when bypass is enabled.
+	void bypass(bool byp) { m_bypass = byp; }
+
+	/// Get if the effect is bypassed
+	/// @returns true if bypassed, false if not bypassed
+	bool isBypass() { return m_bypass; }
+
+	/// Toggle the bypass effect
+	void toggleBypass() { m_bypass = !m_bypass; }
+
+	/// Set the output volume. This affect both the wet and dry signals.
+	/// @details The default is 1.0.
+	/// @param vol Sets the output volume between -1.0 and +1.0
+	void volume(float vol) {m_volume = vol; }
+
+	// ** ENABLE  / DISABLE **
+
+	/// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
+	void enable() { m_enable = true; }
+
+	/// Disables audio process. When disabled, CPU load is nearly zero.
+	void disable() { m_enable = false; }
+
+	// ** MIDI **
+
+	/// Sets whether MIDI OMNI channel is processig on or off. When on,
+	/// all midi channels are used for matching CCs.
+	/// @param isOmni when true, all channels are processed, when false, channel
+	/// must match configured value.
+	void setMidiOmni(bool isOmni) { m_isOmni = isOmni; }
+
+	/// Configure an effect parameter to be controlled by a MIDI CC
+	/// number on a particular channel.
+	/// @param parameter one of the parameter names in the class enum
+	/// @param midiCC the CC number from 0 to 127
+	/// @param midiChannel the effect will only response to the CC on this channel
+	/// when OMNI mode is off.
+	void mapMidiControl(int parameter, int midiCC, int midiChannel = 0);
+
+	/// process a MIDI Continous-Controller (CC) message
+	/// @param channel the MIDI channel from 0 to 15)
+	/// @param midiCC the CC number from 0 to 127
+	/// @param value the CC value from 0 to 127
+	void processMidi(int channel, int midiCC, int value);
+
+	virtual void update(void); ///< update automatically called by the Teesny Audio Library
+
+private:
+	using DelayLine = BALibrary::AudioDelayT<BALibrary::AudioDelayBackend::INTERNAL_FLAT>;
+
+	audio_block_t *m_inputQueueArray[1];
+	DelayLine *m_memory = nullptr;
+	BALibrary::LowFrequencyOscillatorVector<int16_t> m_osc; ///< Q15 smoothed random modulator
+	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
+	bool m_isOmni = false;
+	bool m_bypass = true;
+	bool m_enable = false;
+
+	// Controls
+	uint32_t m_maxDelayQ16 = 0;  ///< longest delay in Q16.16 samples
+	uint32_t m_delayQ16 = 0;     ///< average delay in Q16.16 samples
+	uint32_t m_swingQ16 = 0;     ///< maximum change from the average delay in Q16.16 samples
+	float m_delayMs = 0.0f;
+	float m_detuneCents = 0.0f;
+	float m_rate = 0.0f;
+	float m_mix = 0.5f;
+	float m_volume = 1.0f;
+
+	void m_updateModulation();
+};
+
+}
+
+#endif /* __BAEFFECTS_AUDIOEFFECTADT_H */
@@ -47,6 +47,7 @@ public:
 		FEEDBACK,    ///< controls the amount of echo feedback (regen)
 		MIX,         ///< controls the the mix of input and echo signals
 		VOLUME,      ///< controls the output volume level
+		REVERSE,     ///< enables or disables reverse playback of the echoes
 		NUM_CONTROLS ///< this can be used as an alias for the number of MIDI controls
 	};
 
@@ -69,6 +70,11 @@ public:
 	/// @param numSamples maximum delay in audio samples. Larger delays use more memory.
 	AudioEffectAnalogDelay(size_t numSamples);
 
+	/// Construct an analog delay using internal memory with the specified backend.
+	/// @param backend either AudioDelayBackend::INTERNAL_RING or AudioDelayBackend::INTERNAL_FLAT
+	/// @param numSamples maximum delay in audio samples. Larger delays use more memory.
+	AudioEffectAnalogDelay(BALibrary::AudioDelayBackend backend, size_t numSamples);
+
 	/// Construct an analog delay using external SPI via an ExtMemSlot. The amount of
 	/// delay will be determined by the amount of memory in the slot.
 	/// @param slot A pointer to the ExtMemSlot to use for the delay.
@@ -116,6 +122,11 @@ public:
 	/// @param vol Sets the output volume between -1.0 and +1.0
 	void volume(float vol) {m_volume = vol; }
 
+	/// Enable reverse playback. Windows of audio the length of the delay are played backwards.
+	/// @details the delay is limited to half the max delay while in reverse.
+	/// @param enable when true, echoes are played in reverse
+	void reverse(bool enable);
+
 	// ** ENABLE  / DISABLE **
 
 	/// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
@@ -150,7 +161,8 @@ public:
 
 	/// Set the filter coefficients to one of the presets. See AudioEffectAnalogDelay::Filter
 	/// for options.
-	/// @details See AudioEffectAnalogDelayFIlters.h for more details.
+	/// @details See AudioEffectAnalogDelayFIlters.h for more details. The new filter is
+	/// crossfaded in over the next audio block so this can be called while audio is running.
 	/// @param filter the preset filter. E.g. AudioEffectAnalogDelay::Filter::WARM
 	void setFilter(Filter filter);
 
@@ -166,6 +178,16 @@ public:
 	/// @param coeffShift Coefficient scaling factor = 2^coeffShift.
 	void setFilterCoeffs(int numStages, const int32_t *coeffs, int coeffShift);
 
+	/// Replace the filter with a single biquad designed at runtime, e.g. for a tone control.
+	/// @details Call this from your loop() code, not from inside an audio update. Repeated calls
+	/// smoothly interpolate the filter so it can be swept without clicks. See BALibrary::designBiquad().
+	/// @param type the filter response, e.g. BALibrary::BiquadType::LOW_PASS
+	/// @param fc the cutoff or center frequency in Hz
+	/// @param q the filter Q
+	/// @param gainDb the boost or cut in dB for peaking and shelving filters
+	/// @returns false if the filter could not be designed
+	bool setFilterDesign(BALibrary::BiquadType type, float fc, float q = 0.7071f, float gainDb = 0.0f);
+
 	virtual void update(void); ///< update automatically called by the Teesny Audio Library
 
 private:
@@ -179,6 +201,8 @@ private:
 	audio_block_t *m_previousBlock = nullptr;
 	audio_block_t *m_blockToRelease  = nullptr;
 	BALibrary::IirBiQuadFilterHQ *m_iir = nullptr;
+	bool m_filterDesigned = false; ///< true when the filter was set with setFilterDesign()
+	static constexpr int DESIGN_COEFF_SHIFT = 3; ///< allows shelves and peaks with up to +12dB of boost
 
 	// Controls
 	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
@@ -186,6 +210,7 @@ private:
 	float m_feedback = 0.0f;
 	float m_mix = 0.0f;
 	float m_volume = 1.0f;
+	bool  m_reverse = false;
 
 	void m_preProcessing(audio_block_t *out, audio_block_t *dry, audio_block_t *wet);
 	void m_postProcessing(audio_block_t *out, audio_block_t *dry, audio_block_t *wet);
@@ -0,0 +1,214 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  AudioEffectAnalogDelayF32 is the single-precision floating-point version of
+ *  AudioEffectAnalogDelay for use with the OpenAudio_ArduinoLibrary F32 audio
+ *  blocks. It is only available when LibAudioF32.h finds the OpenAudio library.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BAEFFECTS_BAAUDIOEFFECTANALOGDELAYF32_H
+#define __BAEFFECTS_BAAUDIOEFFECTANALOGDELAYF32_H
+
+#include <Audio.h>
+#include "LibAudioF32.h"
+#include "LibBasicFunctions.h"
+#include "AudioEffectAnalogDelay.h"
+
+#if BALIBRARY_F32
+
+namespace BAEffects {
+
+/**************************************************************************//**
+ * AudioEffectAnalogDelayF32 has the same controls as AudioEffectAnalogDelay.
+ * @details The feedback loop, filter and mix are all processed in float so the
+ * echoes have headroom above full scale until the output. With internal memory
+ * the delay line stores float samples. With an ExtMemSlot the samples are stored
+ * as Q15, which is the only place they are converted.
+ *****************************************************************************/
+class AudioEffectAnalogDelayF32 : public AudioStream_F32 {
+public:
+
+	///< List of AudioEffectAnalogDelayF32 MIDI controllable parameters
+	enum {
+		BYPASS = 0,  ///<  controls effect bypass
+		DELAY,       ///< controls the amount of delay
+		FEEDBACK,    ///< controls the amount of echo feedback (regen)
+		MIX,         ///< controls the the mix of input and echo signals
+		VOLUME,      ///< controls the output volume level
+		REVERSE,     ///< enables or disables reverse playback of the echoes
+		NUM_CONTROLS ///< this can be used as an alias for the number of MIDI controls
+	};
+
+	/// The filter presets, see AudioEffectAnalogDelay::Filter
+	using Filter = AudioEffectAnalogDelay::Filter;
+
+	// *** CONSTRUCTORS ***
+	AudioEffectAnalogDelayF32() = delete;
+
+	/// Construct an analog delay using internal memory by specifying the maximum
+	/// delay in milliseconds.
+	/// @param maxDelayMs maximum delay in milliseconds. Larger delays use more memory.
+	AudioEffectAnalogDelayF32(float maxDelayMs);
+
+	/// Construct an analog delay using internal memory by specifying the maximum
+	/// delay in audio samples.
+	/// @param numSamples maximum delay in audio samples. Larger delays use more memory.
+	AudioEffectAnalogDelayF32(size_t numSamples);
+
+	/// Construct an analog delay using external SPI via an ExtMemSlot. The amount of
+	/// delay will be determined by the amount of memory in the slot.
+	/// @param slot A pointer to the ExtMemSlot to use for the delay.
+	AudioEffectAnalogDelayF32(BALibrary::ExtMemSlot *slot); // requires sufficiently sized pre-allocated memory
+
+	virtual ~AudioEffectAnalogDelayF32(); ///< Destructor
+
+	// *** PARAMETERS ***
+
+	/// Set the delay in milliseconds.
+	/// @param milliseconds the request delay in milliseconds. Must be less than max delay.
+	void delay(float milliseconds);
+
+	/// Set the delay in number of audio samples.
+	/// @param delaySamples the request delay in audio samples. Must be less than max delay.
+	void delay(size_t delaySamples);
+
+	/// Set the delay as a fraction of the maximum delay.
+	/// The value should be between 0.0f and 1.0f
+	void delayFractionMax(float delayFraction);
+
+	/// Bypass the effect.
+	/// @param byp when true, bypass wil disable the effect, when false, effect is enabled.
+	/// Note that audio still passes through when bypass is enabled.
+	void bypass(bool byp) { m_bypass = byp; }
+
+	/// Get if the effect is bypassed
+	/// @returns true if bypassed, false if not bypassed
+	bool isBypass() { return m_bypass; }
+
+	/// Toggle the bypass effect
+	void toggleBypass() { m_bypass = !m_bypass; }
+
+	/// Set the amount of echo feedback (a.k.a regeneration).
+	/// @param feedback a floating point number between 0.0 and 1.0.
+	void feedback(float feedback) { m_feedback = feedback; }
+
+	/// Set the amount of blending between dry and wet (echo) at the output.
+	/// @param mix When 0.0, output is 100% dry, when 1.0, output is 100% wet. When
+	/// 0.5, output is 50% Dry, 50% Wet.
+	void mix(float mix) { m_mix = mix; }
+
+	/// Set the output volume. This affect both the wet and dry signals.
+	/// @details The default is 1.0.
+	/// @param vol Sets the output volume between -1.0 and +1.0
+	void volume(float vol) {m_volume = vol; }
+
+	/// Enable reverse playback. Windows of audio the length of the delay are played backwards.
+	/// @details the delay is limited to half the max delay while in reverse.
+	/// @param enable when true, echoes are played in reverse
+	void reverse(bool enable);
+
+	// ** ENABLE  / DISABLE **
+
+	/// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
+	void enable() { m_enable = true; }
+
+	/// Disables audio process. When disabled, CPU load is nearly zero.
+	void disable() { m_enable = false; }
+
+	// ** MIDI **
+
+	/// Sets whether MIDI OMNI channel is processig on or off. When on,
+	/// all midi channels are used for matching CCs.
+	/// @param isOmni when true, all channels are processed, when false, channel
+	/// must match configured value.
+	void setMidiOmni(bool isOmni) { m_isOmni = isOmni; }
+
+	/// Configure an effect parameter to be controlled by a MIDI CC
+	/// number on a particular channel.
+	/// @param parameter one of the parameter names in the class enum
+	/// @param midiCC the CC number from 0 to 127
+	/// @param midiChannel the effect will only response to the CC on this channel
+	/// when OMNI mode is off.
+	void mapMidiControl(int parameter, int midiCC, int midiChannel = 0);
+
+	/// process a MIDI Continous-Controller (CC) message
+	/// @param channel the MIDI channel from 0 to 15)
+	/// @param midiCC the CC number from 0 to 127
+	/// @param value the CC value from 0 to 127
+	void processMidi(int channel, int midiCC, int value);
+
+	// ** FILTER COEFFICIENTS **
+
+	/// Set the filter coefficients to one of the presets. The new filter is crossfaded
+	/// in over the next audio block so this can be called while audio is running.
+	/// @param filter the preset filter. E.g. AudioEffectAnalogDelayF32::Filter::WARM
+	void setFilter(Filter filter);
+
+	/// Override the default coefficients with your own, see AudioEffectAnalogDelay::setFilterCoeffs().
+	/// The Q31 coefficients are converted to float.
+	/// @param numStages the actual number of filter stages you want to use. Must be <= MAX_NUM_FILTER_STAGES.
+	/// @param coeffs pointer to an integer array of coefficients in q31 format.
+	/// @param coeffShift Coefficient scaling factor = 2^coeffShift.
+	void setFilterCoeffs(int numStages, const int32_t *coeffs, int coeffShift);
+
+	/// Replace the filter with a single biquad designed at runtime, e.g. for a tone control.
+	/// @details Call this from your loop() code, not from inside an audio update. Repeated calls
+	/// smoothly interpolate the filter so it can be swept without clicks. See BALibrary::designBiquad().
+	/// @param type the filter response, e.g. BALibrary::BiquadType::LOW_PASS
+	/// @param fc the cutoff or center frequency in Hz
+	/// @param q the filter Q
+	/// @param gainDb the boost or cut in dB for peaking and shelving filters
+	/// @returns false if the filter could not be designed
+	bool setFilterDesign(BALibrary::BiquadType type, float fc, float q = 0.7071f, float gainDb = 0.0f);
+
+	virtual void update(void); ///< update automatically called by the Teesny Audio Library
+
+private:
+	audio_block_f32_t *m_inputQueueArray[1];
+	bool m_isOmni = false;
+	bool m_bypass = true;
+	bool m_enable = false;
+	bool m_externalMemory = false;
+	BALibrary::AudioDelayF32 *m_memory = nullptr;
+	size_t m_maxDelaySamples = 0;
+	BALibrary::IirBiQuadFilterFloat *m_iir = nullptr;
+	bool m_filterDesigned = false; ///< true when the filter was set with setFilterDesign()
+	float m_previousOutput[AUDIO_BLOCK_SAMPLES] = {}; ///< output from the last block, for the feedback
+	float m_preProcessed[AUDIO_BLOCK_SAMPLES];     ///< input and feedback to write to the delay
+
+	// Controls
+	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
+	size_t m_delaySamples = 0;
+	float m_feedback = 0.0f;
+	float m_mix = 0.0f;
+	float m_volume = 1.0f;
+	bool  m_reverse = false;
+
+	void m_preProcessing(float *out, const float *dry, const float *wet);
+	void m_postProcessing(float *out, const float *dry, const float *wet);
+	void m_setDelaySamples(size_t delaySamples);
+
+	// Coefficients
+	void m_constructFilter(void);
+};
+
+}
+
+#endif /* BALIBRARY_F32 */
+
+#endif /* __BAEFFECTS_BAAUDIOEFFECTANALOGDELAYF32_H */
@@ -0,0 +1,246 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  AudioEffectAnalogDelayStereo is a stereo version of AudioEffectAnalogDelay
+ *  with independent left/right delay times and cross-feedback for ping-pong
+ *  style echoes. Both channels share a single interleaved memory buffer, either
+ *  internal RAM or an external SPI RAM slot.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BAEFFECTS_BAAUDIOEFFECTANALOGDELAYSTEREO_H
+#define __BAEFFECTS_BAAUDIOEFFECTANALOGDELAYSTEREO_H
+
+#include <Audio.h>
+#include "LibBasicFunctions.h"
+#include "AudioEffectAnalogDelay.h"
+
+namespace BAEffects {
+
+/**************************************************************************//**
+ * AudioEffectAnalogDelayStereo models a pair of BBD based analog delays that
+ * share one memory. Inputs and outputs 0 and 1 are left and right.
+ * @details Samples are stored as interleaved L/R frames so each audio block
+ * requires only one memory write. When the left and right delay times are equal
+ * only one read is required, otherwise two. The feedback filters for both
+ * channels are run in a single pass over the interleaved frames so the filter
+ * coefficients are only loaded once per block.<br>
+ * When using an ExtMemSlot, its size in bytes must be a multiple of 4 (one
+ * stereo frame) so the channels do not swap when the circular buffer wraps.
+ *****************************************************************************/
+class AudioEffectAnalogDelayStereo : public AudioStream {
+public:
+
+	///< List of AudioEffectAnalogDelayStereo MIDI controllable parameters
+	enum {
+		BYPASS = 0,     ///< controls effect bypass
+		DELAY_LEFT,     ///< controls the amount of delay on the left channel
+		DELAY_RIGHT,    ///< controls the amount of delay on the right channel
+		FEEDBACK,       ///< controls the amount of echo feedback (regen)
+		CROSS_FEEDBACK, ///< controls how much of the feedback crosses to the opposite channel
+		PING_PONG,      ///< enables or disables ping-pong mode
+		MIX,            ///< controls the the mix of input and echo signals
+		VOLUME,         ///< controls the output volume level
+		NUM_CONTROLS    ///< this can be used as an alias for the number of MIDI controls
+	};
+
+	/// The filter presets are shared with the mono AudioEffectAnalogDelay
+	using Filter = AudioEffectAnalogDelay::Filter;
+
+	// *** CONSTRUCTORS ***
+	AudioEffectAnalogDelayStereo() = delete;
+
+	/// Construct a stereo analog delay using internal memory by specifying the maximum
+	/// delay in milliseconds.
+	/// @param maxDelayMs maximum delay in milliseconds. Larger delays use more memory.
+	AudioEffectAnalogDelayStereo(float maxDelayMs);
+
+	/// Construct a stereo analog delay using internal memory by specifying the maximum
+	/// delay in audio samples.
+	/// @param numSamples maximum delay in audio samples. Larger delays use more memory.
+	AudioEffectAnalogDelayStereo(size_t numSamples);
+
+	/// Construct a stereo analog delay using external SPI via an ExtMemSlot. The amount of
+	/// delay will be determined by the amount of memory in the slot. Since both channels
+	/// share the slot, the maximum delay is half that of a mono delay with the same slot.
+	/// @param slot A pointer to the ExtMemSlot to use for the delay.
+	AudioEffectAnalogDelayStereo(BALibrary::ExtMemSlot *slot); // requires sufficiently sized pre-allocated memory
+
+	virtual ~AudioEffectAnalogDelayStereo(); ///< Destructor
+
+	// *** PARAMETERS ***
+
+	/// Set the delay of both channels in milliseconds.
+	/// @param milliseconds the request delay in milliseconds. Must be less than max delay.
+	void delay(float milliseconds);
+
+	/// Set the delay of both channels in number of audio samples.
+	/// @param delaySamples the request delay in audio samples. Must be less than max delay.
+	void delay(size_t delaySamples);
+
+	/// Set the delay of the left channel in milliseconds.
+	/// @param milliseconds the request delay in milliseconds. Must be less than max delay.
+	void delayLeft(float milliseconds) { delayLeft(BALibrary::calcAudioSamples(milliseconds)); }
+
+	/// Set the delay of the left channel in number of audio samples.
+	/// @param delaySamples the request delay in audio samples. Must be less than max delay.
+	void delayLeft(size_t delaySamples);
+
+	/// Set the delay of the right channel in milliseconds.
+	/// @param milliseconds the request delay in milliseconds. Must be less than max delay.
+	void delayRight(float milliseconds) { delayRight(BALibrary::calcAudioSamples(milliseconds)); }
+
+	/// Set the delay of the right channel in number of audio samples.
+	/// @param delaySamples the request delay in audio samples. Must be less than max delay.
+	void delayRight(size_t delaySamples);
+
+	/// Set the delay of both channels as a fraction of the maximum delay.
+	/// The value should be between 0.0f and 1.0f
+	void delayFractionMax(float delayFraction);
+
+	/// Get the maximum delay available on each channel
+	/// @returns the maximum delay in audio samples
+	size_t getMaxDelaySamples() const { return m_maxDelaySamples; }
+
+	/// Bypass the effect.
+	/// @param byp when true, bypass wil disable the effect, when false, effect is enabled.
+	/// Note that audio still passes through when bypass is enabled.
+	void bypass(bool byp) { m_bypass = byp; }
+
+	/// Get if the effect is bypassed
+	/// @returns true if bypassed, false if not bypassed
+	bool isBypass() { return m_bypass; }
+
+	/// Toggle the bypass effect
+	void toggleBypass() { m_bypass = !m_bypass; }
+
+	/// Set the amount of echo feedback (a.k.a regeneration).
+	/// @param feedback a floating point number between 0.0 and 1.0.
+	void feedback(float feedback) { m_feedback = feedback; }
+
+	/// Set how much of each channel's feedback is sent to the opposite channel.
+	/// @param crossFeedback When 0.0, each channel feeds back to itself. When 1.0,
+	/// each channel feeds back only to the opposite channel.
+	void crossFeedback(float crossFeedback) { m_crossFeedback = crossFeedback; }
+
+	/// Enable ping-pong mode. The input is summed to mono and fed only into the left
+	/// delay line, and the feedback is fully crossed so echoes alternate between channels.
+	/// @param enable when true, ping-pong mode is on
+	void pingPong(bool enable) { m_pingPong = enable; }
+
+	/// Set the amount of blending between dry and wet (echo) at the output.
+	/// @param mix When 0.0, output is 100% dry, when 1.0, output is 100% wet. When
+	/// 0.5, output is 50% Dry, 50% Wet.
+	void mix(float mix) { m_mix = mix; }
+
+	/// Set the output volume. This affect both the wet and dry signals.
+	/// @details The default is 1.0.
+	/// @param vol Sets the output volume between -1.0 and +1.0
+	void volume(float vol) {m_volume = vol; }
+
+	// ** ENABLE  / DISABLE **
+
+	/// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
+	void enable() { m_enable = true; }
+
+	/// Disables audio process. When disabled, CPU load is nearly zero.
+	void disable() { m_enable = false; }
+
+	// ** MIDI **
+
+	/// Sets whether MIDI OMNI channel is processig on or off. When on,
+	/// all midi channels are used for matching CCs.
+	/// @param isOmni when true, all channels are processed, when false, channel
+	/// must match configured value.
+	void setMidiOmni(bool isOmni) { m_isOmni = isOmni; }
+
+	/// Configure an effect parameter to be controlled by a MIDI CC
+	/// number on a particular channel.
+	/// @param parameter one of the parameter names in the class enum
+	/// @param midiCC the CC number from 0 to 127
+	/// @param midiChannel the effect will only response to the CC on this channel
+	/// when OMNI mode is off.
+	void mapMidiControl(int parameter, int midiCC, int midiChannel = 0);
+
+	/// process a MIDI Continous-Controller (CC) message
+	/// @param channel the MIDI channel from 0 to 15)
+	/// @param midiCC the CC number from 0 to 127
+	/// @param value the CC value from 0 to 127
+	void processMidi(int channel, int midiCC, int value);
+
+	// ** FILTER COEFFICIENTS **
+
+	/// Set the filter coefficients to one of the presets. See AudioEffectAnalogDelay::Filter
+	/// for options.
+	/// @param filter the preset filter. E.g. AudioEffectAnalogDelay::Filter::WARM
+	void setFilter(Filter filter);
+
+	/// Override the default coefficients with your own. See AudioEffectAnalogDelay::setFilterCoeffs()
+	/// for the coefficient format.
+	/// @param numStages the actual number of filter stages you want to use. Must be <= MAX_NUM_FILTER_STAGES.
+	/// @param coeffs pointer to an integer array of coefficients in q31 format.
+	/// @param coeffShift Coefficient scaling factor = 2^coeffShift.
+	void setFilterCoeffs(int numStages, const int32_t *coeffs, int coeffShift);
+
+	virtual void update(void); ///< update automatically called by the Teesny Audio Library
+
+private:
+	static constexpr unsigned NUM_CHANNELS = 2;
+	static constexpr unsigned FRAME_SAMPLES = NUM_CHANNELS*AUDIO_BLOCK_SAMPLES;
+	static constexpr unsigned MAX_STAGES = 4;
+
+	audio_block_t *m_inputQueueArray[NUM_CHANNELS];
+	bool m_isOmni = false;
+	bool m_bypass = true;
+	bool m_enable = false;
+	bool m_externalMemory = false;
+
+	// Memory
+	BALibrary::ExtMemSlot *m_slot = nullptr; ///< when using EXTERNAL memory, the interleaved slot
+	int16_t *m_buffer = nullptr;             ///< when using INTERNAL memory, the interleaved frame buffer
+	size_t m_bufferFrames = 0;               ///< size of the internal buffer in stereo frames
+	size_t m_writeFrame = 0;                 ///< internal buffer write position in stereo frames
+	size_t m_maxDelaySamples = 0;
+
+	int16_t m_readFrames[NUM_CHANNELS][FRAME_SAMPLES]; ///< delayed frames read back for the left and right taps
+	int16_t m_writeFrames[FRAME_SAMPLES];              ///< interleaved frames to be written to the memory
+	int16_t m_wet[NUM_CHANNELS][AUDIO_BLOCK_SAMPLES];  ///< previous wet output used for the feedback path
+
+	BALibrary::IirBiQuadFilterMultiHQ<NUM_CHANNELS> *m_iir = nullptr; ///< interleaved feedback filter
+
+	// Controls
+	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
+	size_t m_delaySamples[NUM_CHANNELS] = {0, 0};
+	float m_feedback = 0.0f;
+	float m_crossFeedback = 0.0f;
+	bool  m_pingPong = false;
+	float m_mix = 0.0f;
+	float m_volume = 1.0f;
+
+	void m_readDelayed(int16_t *dest, size_t delaySamples);
+	void m_writeFramesToMemory(void);
+	void m_updateMaxDelay(void);
+	void m_preProcessing(audio_block_t *inLeft, audio_block_t *inRight);
+	void m_postProcessing(audio_block_t *out, audio_block_t *dry, const int16_t *wet);
+	void m_constructMemory(size_t numSamples);
+	void m_constructFilter(void);
+	void m_setDelay(unsigned channel, size_t delaySamples);
+};
+
+}
+
+#endif /* __BAEFFECTS_BAAUDIOEFFECTANALOGDELAYSTEREO_H */
@@ -0,0 +1,146 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  AudioEffectConvolution convolves the input with an impulse response, e.g.
+ *  for speaker cabinet simulation.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BAEFFECTS_AUDIOEFFECTCONVOLUTION_H
+#define __BAEFFECTS_AUDIOEFFECTCONVOLUTION_H
+
+#include <Audio.h>
+#include "LibBasicFunctions.h"
+
+namespace BAEffects {
+
+/**************************************************************************//**
+ * AudioEffectConvolution applies an impulse response (IR) to the input, such as a
+ * captured guitar speaker cabinet, with no added latency.
+ * @details The convolution is computed in the frequency domain by
+ * BALibrary::UniformConvolution, so a 40 ms IR costs about as much as a 200 tap FIR
+ * would directly. It uses the FPU so a Teensy 3.5, 3.6 or 4 is required. Memory is
+ * allocated for the longest IR by the constructor.
+ *****************************************************************************/
+class AudioEffectConvolution : public AudioStream {
+public:
+
+	///< List of AudioEffectConvolution MIDI controllable parameters
+	enum {
+		BYPASS = 0,  ///< controls effect bypass
+		MIX,         ///< controls the the mix of input and convolved signals
+		VOLUME,      ///< controls the output volume level
+		NUM_CONTROLS ///< this can be used as an alias for the number of MIDI controls
+	};
+
+	// *** CONSTRUCTORS ***
+	AudioEffectConvolution() = delete;
+
+	/// Construct a convolution effect by specifying the longest impulse response.
+	/// @param maxImpulseMs the longest impulse response in milliseconds. Longer IRs use
+	/// more memory and CPU.
+	AudioEffectConvolution(float maxImpulseMs);
+
+	virtual ~AudioEffectConvolution(); ///< Destructor
+
+	// *** PARAMETERS ***
+
+	/// Load an impulse response. Call this from your setup() or loop() code, the output
+	/// is silent until the load finishes.
+	/// @param ir pointer to the impulse response where full scale is +/-1.0
+	/// @param numSamples number of samples in the IR, extra samples past the maximum are ignored
+	/// @param gain scales the IR, e.g. to compensate for a loud cabinet capture
+	/// @returns false if the IR could not be loaded
+	bool setImpulseResponse(const float *ir, size_t numSamples, float gain = 1.0f);
+
+	/// Load a Q15 impulse response, e.g. converted from a 16-bit WAV file.
+	/// @param ir pointer to the Q15 impulse response
+	/// @param numSamples number of samples in the IR, extra samples past the maximum are ignored
+	/// @param gain scales the IR, e.g. to compensate for a loud cabinet capture
+	/// @returns false if the IR could not be loaded
+	bool setImpulseResponse(const int16_t *ir, size_t numSamples, float gain = 1.0f);
+
+	/// Bypass the effect.
+	/// @param byp when true, bypass wil disable the effect, when false, effect is enabled.
+	/// Note that audio still passes through when bypass is enabled.
+	void bypass(bool byp) { m_bypass = byp; }
+
+	/// Get if the effect is bypassed
+	/// @returns true if bypassed, false if not bypassed
+	bool isBypass() { return m_bypass; }
+
+	/// Toggle the bypass effect
+	void toggleBypass() { m_bypass = !m_bypass; }
+
+	/// Set the amount of blending between dry and convolved at the output.
+	/// @param mix When 0.0, output is 100% dry, when 1.0, output is 100% wet. The
+	/// default is 1.0 for cabinet simulation.
+	void mix(float mix) { m_mix = mix; }
+
+	/// Set the output volume. This affect both the wet and dry signals.
+	/// @details The default is 1.0.
+	/// @param vol Sets the output volume between -1.0 and +1.0
+	void volume(float vol) {m_volume = vol; }
+
+	// ** ENABLE  / DISABLE **
+
+	/// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
+	void enable() { m_enable = true; }
+
+	/// Disables audio process. When disabled, CPU load is nearly zero.
+	void disable() { m_enable = false; }
+
+	// ** MIDI **
+
+	/// Sets whether MIDI OMNI channel is processig on or off. When on,
+	/// all midi channels are used for matching CCs.
+	/// @param isOmni when true, all channels are processed, when false, channel
+	/// must match configured value.
+	void setMidiOmni(bool isOmni) { m_isOmni = isOmni; }
+
+	/// Configure an effect parameter to be controlled by a MIDI CC
+	/// number on a particular channel.
+	/// @param parameter one of the parameter names in the class enum
+	/// @param midiCC the CC number from 0 to 127
+	/// @param midiChannel the effect will only response to the CC on this channel
+	/// when OMNI mode is off.
+	void mapMidiControl(int parameter, int midiCC, int midiChannel = 0);
+
+	/// process a MIDI Continous-Controller (CC) message
+	/// @param channel the MIDI channel from 0 to 15)
+	/// @param midiCC the CC number from 0 to 127
+	/// @param value the CC value from 0 to 127
+	void processMidi(int channel, int midiCC, int value);
+
+	virtual void update(void); ///< update automatically called by the Teesny Audio Library
+
+private:
+	audio_block_t *m_inputQueueArray[1];
+	BALibrary::UniformConvolution *m_convolution = nullptr;
+	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
+	bool m_isOmni = false;
+	bool m_bypass = true;
+	bool m_enable = false;
+
+	// Controls
+	float m_mix = 1.0f;
+	float m_volume = 1.0f;
+};
+
+}
+
+#endif /* __BAEFFECTS_AUDIOEFFECTCONVOLUTION_H */
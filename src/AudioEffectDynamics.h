@@ -0,0 +1,205 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  AudioEffectDynamics is a compressor, limiter and noise gate with optional
+ *  lookahead.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BAEFFECTS_AUDIOEFFECTDYNAMICS_H
+#define __BAEFFECTS_AUDIOEFFECTDYNAMICS_H
+
+#include <atomic>
+#include <Audio.h>
+#include "LibBasicFunctions.h"
+
+namespace BAEffects {
+
+/**************************************************************************//**
+ * AudioEffectDynamics controls the level of the input with a compressor, a limiter
+ * or a noise gate. E.g. a gate before a drive and a limiter after a delay.
+ * @details The detector follows either the peak or the RMS level. The gain is
+ * computed in the log domain with table lookups instead of log and exp, smoothed
+ * with the attack and release times, then applied to the samples in Q15. No float
+ * math is done per sample. With lookahead the audio is delayed so the gain can
+ * start to change before a transient arrives, which lets a limiter catch the
+ * attack of a note. Memory for the lookahead is allocated by the constructor.
+ *****************************************************************************/
+class AudioEffectDynamics : public AudioStream {
+public:
+
+	///< List of AudioEffectDynamics MIDI controllable parameters
+	enum {
+		BYPASS = 0,  ///< controls effect bypass
+		THRESHOLD,   ///< controls the threshold from -60 dB to 0 dB
+		RATIO,       ///< controls the ratio from 1:1 to 20:1
+		ATTACK,      ///< controls the attack time from 0 to 50 ms
+		RELEASE,     ///< controls the release time from 5 ms to 1 second
+		MAKEUP,      ///< controls the makeup gain from 0 to 24 dB
+		VOLUME,      ///< controls the output volume level
+		NUM_CONTROLS ///< this can be used as an alias for the number of MIDI controls
+	};
+
+	/// The gain curve applied to the detected level
+	enum class Mode {
+		COMPRESSOR, ///< above the threshold the level is divided by the ratio
+		LIMITER,    ///< above the threshold the level is held at the threshold
+		GATE        ///< below the threshold the level is multiplied by the ratio, i.e. an expander
+	};
+
+	/// The level followed by the detector
+	enum class Detector {
+		PEAK, ///< the absolute value of each sample
+		RMS   ///< the RMS level averaged over a few milliseconds
+	};
+
+	// *** CONSTRUCTORS ***
+
+	/// Construct a dynamics effect by specifying the longest lookahead.
+	/// @param maxLookaheadMs the longest lookahead in milliseconds. When 0.0, no memory
+	/// is allocated and lookahead is not available.
+	AudioEffectDynamics(float maxLookaheadMs = 5.0f);
+
+	virtual ~AudioEffectDynamics(); ///< Destructor
+
+	// *** PARAMETERS ***
+
+	/// Select the gain curve. The default is Mode::COMPRESSOR.
+	/// @param mode the gain curve, e.g. AudioEffectDynamics::Mode::GATE
+	void mode(Mode mode) { m_mode = mode; }
+
+	/// Select the level the detector follows. The default is Detector::PEAK.
+	/// @param detector e.g. AudioEffectDynamics::Detector::RMS
+	void detector(Detector detector) { m_detector = detector; }
+
+	/// Set the threshold in dB relative to full scale.
+	/// @details The default is -20 dB.
+	/// @param thresholdDb the threshold from -90.0 to 0.0
+	void threshold(float thresholdDb) { m_thresholdDb = thresholdDb; }
+
+	/// Set the ratio of the compressor or the gate. The limiter ignores the ratio.
+	/// @details The default is 4.0. A gate with a ratio of 10.0 or more acts as a
+	/// hard gate.
+	/// @param ratio the ratio from 1.0 to 100.0
+	void ratio(float ratio) { m_ratio = ratio; }
+
+	/// Set how quickly the gain responds to a rising level.
+	/// @details The default is 5 ms.
+	/// @param milliseconds the attack time constant, 0.0 is instant
+	void attackTime(float milliseconds) { m_attackCoeff = m_calcCoeff(milliseconds); }
+
+	/// Set how quickly the gain recovers when the level falls.
+	/// @details The default is 100 ms.
+	/// @param milliseconds the release time constant, 0.0 is instant
+	void releaseTime(float milliseconds) { m_releaseCoeff = m_calcCoeff(milliseconds); }
+
+	/// Set the makeup gain applied after the compression.
+	/// @details The default is 0 dB.
+	/// @param gainDb the makeup gain from 0.0 to 48.0 dB
+	void makeup(float gainDb);
+
+	/// Set the lookahead. The output is delayed by this amount.
+	/// @details About twice the attack time lets the gain reach the target before
+	/// a transient. The default is 0.
+	/// @param milliseconds the lookahead, limited to the maximum set by the constructor
+	void lookahead(float milliseconds);
+
+	/// Get the current gain reduction, e.g. for a meter.
+	/// @returns the gain reduction in dB, 0.0 or less
+	float getGainReduction() const;
+
+	/// Bypass the effect.
+	/// @param byp when true, bypass wil disable the effect, when false, effect is enabled.
+	/// Note that audio still passes through when bypass is enabled.
+	void bypass(bool byp) { m_bypass = byp; }
+
+	/// Get if the effect is bypassed
+	/// @returns true if bypassed, false if not bypassed
+	bool isBypass() { return m_bypass; }
+
+	/// Toggle the bypass effect
+	void toggleBypass() { m_bypass = !m_bypass; }
+
+	/// Set the output volume.
+	/// @details The default is 1.0.
+	/// @param vol Sets the output volume between -1.0 and +1.0
+	void volume(float vol) { m_volume = vol; }
+
+	// ** ENABLE  / DISABLE **
+
+	/// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
+	void enable() { m_enable = true; }
+
+	/// Disables audio process. When disabled, CPU load is nearly zero.
+	void disable() { m_enable = false; }
+
+	// ** MIDI **
+
+	/// Sets whether MIDI OMNI channel is processig on or off. When on,
+	/// all midi channels are used for matching CCs.
+	/// @param isOmni when true, all channels are processed, when false, channel
+	/// must match configured value.
+	void setMidiOmni(bool isOmni) { m_isOmni = isOmni; }
+
+	/// Configure an effect parameter to be controlled by a MIDI CC
+	/// number on a particular channel.
+	/// @param parameter one of the parameter names in the class enum
+	/// @param midiCC the CC number from 0 to 127
+	/// @param midiChannel the effect will only response to the CC on this channel
+	/// when OMNI mode is off.
+	void mapMidiControl(int parameter, int midiCC, int midiChannel = 0);
+
+	/// process a MIDI Continous-Controller (CC) message
+	/// @param channel the MIDI channel from 0 to 15)
+	/// @param midiCC the CC number from 0 to 127
+	/// @param value the CC value from 0 to 127
+	void processMidi(int channel, int midiCC, int value);
+
+	virtual void update(void); ///< update automatically called by the Teesny Audio Library
+
+private:
+	audio_block_t *m_inputQueueArray[1];
+	BALibrary::AudioDelayT<BALibrary::AudioDelayBackend::INTERNAL_FLAT> *m_lookahead = nullptr;
+	size_t m_maxLookaheadSamples = 0;
+	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
+	bool m_isOmni = false;
+	bool m_bypass = true;
+	bool m_enable = false;
+
+	// Controls
+	Mode m_mode = Mode::COMPRESSOR;
+	Detector m_detector = Detector::PEAK;
+	float m_thresholdDb = -20.0f;
+	float m_ratio = 4.0f;
+	int32_t m_attackCoeff;        ///< Q31 smoothing coefficient per pair of samples
+	int32_t m_releaseCoeff;       ///< Q31 smoothing coefficient per pair of samples
+	float m_makeup = 1.0f;        ///< linear makeup gain
+	float m_volume = 1.0f;
+	size_t m_lookaheadSamples = 0;
+
+	// Detector and gain state
+	int64_t m_meanSquare = 0;     ///< RMS detector state, squared samples in Q16
+	int32_t m_gain = 0;           ///< smoothed gain in log2 units, Q24
+	std::atomic<int32_t> m_gainReduction{0}; ///< m_gain at the end of the last block
+
+	int32_t m_calcCoeff(float milliseconds);
+	void m_process(int16_t *out, const int16_t *detect, const int16_t *in);
+};
+
+}
+
+#endif /* __BAEFFECTS_AUDIOEFFECTDYNAMICS_H */
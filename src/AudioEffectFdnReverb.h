@@ -0,0 +1,197 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  AudioEffectFdnReverb is a feedback delay network reverb using external SPI
+ *  memory for the delay lines.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BAEFFECTS_AUDIOEFFECTFDNREVERB_H
+#define __BAEFFECTS_AUDIOEFFECTFDNREVERB_H
+
+#include <Audio.h>
+#include "LibBasicFunctions.h"
+
+namespace BAEffects {
+
+/**************************************************************************//**
+ * AudioEffectFdnReverb is a feedback delay network (FDN) reverb. The long delay
+ * lines are stored in an ExtMemSlot so large, dense rooms don't use internal memory.
+ * @details The input is smeared by a chain of short allpass diffusers in internal
+ * memory, then fed to NUM_LINES delay lines whose outputs are damped, scaled for
+ * the decay time and mixed back into the lines with an orthogonal matrix.<br>
+ * All the delay lines are read with one batched read from the slot each audio
+ * block, while the input is being diffused. Each line has a one block guard after
+ * it so a read never wraps, which keeps the batch to one SPI read per line.<br>
+ * The slot should be at least 1300 ms for the largest room, e.g.
+ * externalSram.requestMemory(&slot, 1300.0f, MemSelect::MEM0, true). Smaller
+ * slots limit the room size.
+ *****************************************************************************/
+class AudioEffectFdnReverb : public AudioStream {
+public:
+
+	static constexpr unsigned NUM_LINES = 8;      ///< number of delay lines in the network
+	static constexpr unsigned NUM_DIFFUSERS = 4;  ///< number of input allpass diffusers
+
+	///< List of AudioEffectFdnReverb MIDI controllable parameters
+	enum {
+		BYPASS = 0,  ///< controls effect bypass
+		SIZE,        ///< controls the room size
+		DECAY,       ///< controls the reverb time
+		DAMPING,     ///< controls the high frequency damping
+		DIFFUSION,   ///< controls the input diffusion
+		MIX,         ///< controls the the mix of input and reverb
+		VOLUME,      ///< controls the output volume level
+		NUM_CONTROLS ///< this can be used as an alias for the number of MIDI controls
+	};
+
+	/// The feedback matrix used to mix the delay lines
+	enum class Mixing : unsigned {
+		HOUSEHOLDER = 0, ///< I - 2/N, every line feeds every other line equally. Cheapest.
+		HADAMARD,        ///< fast Walsh-Hadamard transform, builds echo density faster
+	};
+
+	// *** CONSTRUCTORS ***
+	AudioEffectFdnReverb() = delete;
+
+	/// Construct the reverb using external SPI via an ExtMemSlot.
+	/// @param slot A pointer to the ExtMemSlot to use for the delay lines.
+	AudioEffectFdnReverb(BALibrary::ExtMemSlot *slot);
+
+	virtual ~AudioEffectFdnReverb(); ///< Destructor
+
+	// *** PARAMETERS ***
+
+	/// Set the room size. Changing the size while audio is running will click.
+	/// @param size from 0.0 (small) to 1.0 (largest that fits in the slot)
+	void size(float size);
+
+	/// Set the reverb time
+	/// @param seconds the time for the reverb to decay by 60 dB
+	void decay(float seconds);
+
+	/// Set the high frequency damping inside the network
+	/// @param damping from 0.0 (bright) to 1.0 (dark)
+	void damping(float damping);
+
+	/// Set the amount of input diffusion
+	/// @param diffusion from 0.0 (discrete early echoes) to 1.0 (smooth)
+	void diffusion(float diffusion);
+
+	/// Select the feedback mixing matrix
+	/// @param mixing either Mixing::HOUSEHOLDER or Mixing::HADAMARD
+	void setMixing(Mixing mixing);
+
+	/// Set the amount of blending between dry and reverb at the output.
+	/// @param mix When 0.0, output is 100% dry, when 1.0, output is 100% reverb.
+	void mix(float mix) { m_mix = mix; }
+
+	/// Bypass the effect.
+	/// @param byp when true, bypass wil disable the effect, when false, effect is enabled.
+	/// Note that audio still passes through when bypass is enabled.
+	void bypass(bool byp) { m_bypass = byp; }
+
+	/// Get if the effect is bypassed
+	/// @returns true if bypassed, false if not bypassed
+	bool isBypass() { return m_bypass; }
+
+	/// Toggle the bypass effect
+	void toggleBypass() { m_bypass = !m_bypass; }
+
+	/// Set the output volume. This affect both the wet and dry signals.
+	/// @details The default is 1.0.
+	/// @param vol Sets the output volume between -1.0 and +1.0
+	void volume(float vol) {m_volume = vol; }
+
+	// ** ENABLE  / DISABLE **
+
+	/// Enables audio processing. The delay lines are cleared. Note: when not enabled, CPU load is nearly zero.
+	void enable();
+
+	/// Disables audio process. When disabled, CPU load is nearly zero.
+	void disable() { m_enable = false; }
+
+	// ** MIDI **
+
+	/// Sets whether MIDI OMNI channel is processig on or off. When on,
+	/// all midi channels are used for matching CCs.
+	/// @param isOmni when true, all channels are processed, when false, channel
+	/// must match configured value.
+	void setMidiOmni(bool isOmni) { m_isOmni = isOmni; }
+
+	/// Configure an effect parameter to be controlled by a MIDI CC
+	/// number on a particular channel.
+	/// @param parameter one of the parameter names in the class enum
+	/// @param midiCC the CC number from 0 to 127
+	/// @param midiChannel the effect will only response to the CC on this channel
+	/// when OMNI mode is off.
+	void mapMidiControl(int parameter, int midiCC, int midiChannel = 0);
+
+	/// process a MIDI Continous-Controller (CC) message
+	/// @param channel the MIDI channel from 0 to 15)
+	/// @param midiCC the CC number from 0 to 127
+	/// @param value the CC value from 0 to 127
+	void processMidi(int channel, int midiCC, int value);
+
+	virtual void update(void); ///< update automatically called by the Teesny Audio Library
+
+private:
+	audio_block_t *m_inputQueueArray[1];
+	BALibrary::ExtMemSlot *m_slot = nullptr;
+	bool m_valid = false;     ///< true when the slot is large enough for the smallest room
+	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
+	bool m_isOmni = false;
+	bool m_bypass = true;
+	bool m_enable = false;
+
+	// Delay lines, each is a circular buffer of m_lineBuffer[] samples plus a one block guard
+	float  m_maxScale = 0.0f;              ///< largest line length scale that fits in the slot
+	size_t m_lineBase[NUM_LINES];          ///< start of each line in the slot, in samples
+	size_t m_lineBuffer[NUM_LINES];        ///< size of each circular buffer, a multiple of the block size
+	size_t m_lineLength[NUM_LINES];        ///< delay of each line in samples
+	size_t m_lineWrite[NUM_LINES] = {};    ///< write position of each line
+	int16_t m_lineGain[NUM_LINES];         ///< Q15 decay gain of each line, includes the matrix scaling
+	int32_t m_lowpass[NUM_LINES] = {};     ///< damping filter state of each line
+	int16_t m_lineOut[NUM_LINES][AUDIO_BLOCK_SAMPLES]; ///< samples read from the lines
+	int16_t m_lineIn[NUM_LINES][AUDIO_BLOCK_SAMPLES];  ///< samples written to the lines
+	int32_t m_work[NUM_LINES][AUDIO_BLOCK_SAMPLES];    ///< the lines being mixed
+
+	// Diffusers
+	int16_t *m_diffuserBuffer = nullptr;
+	unsigned m_diffuserIndex[NUM_DIFFUSERS] = {};
+
+	// Controls
+	Mixing  m_mixing = Mixing::HADAMARD;
+	int32_t m_dampingCoeff = 32767;   ///< Q15 lowpass coefficient
+	int32_t m_diffusionCoeff = 0;     ///< Q15 allpass coefficient
+	float m_size = 0.0f;
+	float m_decay = 0.0f;
+	float m_damping = 0.0f;
+	float m_diffusion = 0.0f;
+	float m_mix = 0.3f;
+	float m_volume = 1.0f;
+
+	void m_updateLines();
+	void m_requestReads();
+	void m_diffuse(int16_t *out, const int16_t *in);
+	void m_processLines(const int16_t *in, int32_t *wet);
+	void m_writeLines();
+};
+
+}
+
+#endif /* __BAEFFECTS_AUDIOEFFECTFDNREVERB_H */
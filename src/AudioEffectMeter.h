@@ -0,0 +1,154 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  @brief Measure the peak, RMS and crest factor levels of a channel
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BAEFFECTS_AUDIOEFFECTMETER_H
+#define __BAEFFECTS_AUDIOEFFECTMETER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <Audio.h>
+
+namespace BAEffects {
+
+/**************************************************************************//**
+ * AudioEffectMeter measures the level of its input over several integration
+ * windows at once and passes the audio through unchanged. It is intended to be
+ * left running for displays and auto-gain.
+ * @details Each audio block is measured in a single pass, then three windows
+ * are updated:<br>
+ * FAST and SLOW are exponential (RC) windows, with 125 ms and 1 second time
+ * constants by default like a sound level meter. Their peaks decay with the
+ * same time constant.<br>
+ * SLIDING is a rectangular window over the most recent blocks, its peak is the
+ * largest peak within the window.<br>
+ * The audio interrupt only publishes the raw levels. Conversion to RMS, crest
+ * factor and dB happens when the main loop calls getReading(), which never
+ * blocks the audio interrupt.
+ *****************************************************************************/
+class AudioEffectMeter : public AudioStream {
+public:
+
+	/// The integration windows
+	enum class Window : unsigned {
+		FAST = 0,   ///< exponential window, default 125 ms
+		SLOW,       ///< exponential window, default 1000 ms
+		SLIDING,    ///< rectangular window, default 300 ms
+		NUM_WINDOWS ///< the number of windows
+	};
+
+	/// The levels measured over one window. Levels are linear where 1.0 is full scale.
+	struct Reading {
+		float peak  = 0.0f; ///< peak absolute level
+		float rms   = 0.0f; ///< RMS level
+		float crest = 0.0f; ///< crest factor, peak/rms. 0.0 when the RMS is 0.
+	};
+
+	// *** CONSTRUCTORS ***
+	/// Create the meter.
+	/// @param fastMs time constant of the FAST window in milliseconds
+	/// @param slowMs time constant of the SLOW window in milliseconds
+	/// @param slidingMs length of the SLIDING window in milliseconds, rounded to whole audio blocks
+	AudioEffectMeter(float fastMs = 125.0f, float slowMs = 1000.0f, float slidingMs = 300.0f);
+
+	virtual ~AudioEffectMeter(); ///< Destructor
+
+	/// Change the time constant of the FAST or SLOW window
+	/// @param window either Window::FAST or Window::SLOW
+	/// @param milliseconds the new time constant in milliseconds
+	void setTimeConstant(Window window, float milliseconds);
+
+	/// Get the most recent levels for one window. This is lock-free and safe to call from
+	/// the main loop while audio is running.
+	/// @param window the window to read
+	/// @returns the peak, RMS and crest factor
+	Reading getReading(Window window) const;
+
+	/// Get the most recent levels for every window, all from the same audio block.
+	/// @param readings array of Window::NUM_WINDOWS readings to fill
+	void getReadings(Reading *readings) const;
+
+	/// Get the number of audio blocks measured, useful to check for a new reading
+	/// @returns the number of blocks measured since construction
+	uint32_t getBlockCount() const { return m_sequence.load(std::memory_order_acquire) >> 1; }
+
+	/// Convert a linear level to dBFS
+	/// @param level the linear level where 1.0 is full scale
+	/// @returns 20*log10(level), or -200.0 for silence
+	static float toDb(float level);
+
+	/// Bypass the effect.
+	/// @param byp when true, bypass wil disable the effect, when false, effect is enabled.
+	/// Note that audio still passes through when bypass is enabled.
+	void bypass(bool byp) { m_bypass = byp; }
+
+	/// Get if the effect is bypassed
+	/// @returns true if bypassed, false if not bypassed
+	bool isBypass() { return m_bypass; }
+
+	/// Toggle the bypass effect
+	void toggleBypass() { m_bypass = !m_bypass; }
+
+	/// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
+	void enable() { m_enable = true; }
+
+	/// Disables audio process. When disabled, CPU load is nearly zero.
+	void disable() { m_enable = false; }
+
+	virtual void update(void); ///< update automatically called by the Teesny Audio Library
+
+private:
+	static constexpr unsigned NUM_WINDOWS = static_cast<unsigned>(Window::NUM_WINDOWS);
+	static constexpr unsigned NUM_EXP_WINDOWS = 2; ///< FAST and SLOW
+
+	/// The raw levels published by the audio interrupt
+	struct Levels {
+		float peak[NUM_WINDOWS];       ///< peak absolute level
+		float meanSquare[NUM_WINDOWS]; ///< mean of the squared level
+	};
+
+	audio_block_t *m_inputQueueArray[1];
+
+	bool m_bypass = true;
+	bool m_enable = false;
+
+	// Exponential windows
+	float m_expCoeff[NUM_EXP_WINDOWS];      ///< per block smoothing coefficient
+	float m_expPeak[NUM_EXP_WINDOWS]       = {0.0f, 0.0f};
+	float m_expMeanSquare[NUM_EXP_WINDOWS] = {0.0f, 0.0f};
+
+	// Sliding window
+	unsigned  m_slidingBlocks = 0;       ///< length of the window in blocks
+	unsigned  m_slidingIndex  = 0;       ///< next position to overwrite
+	int64_t  *m_slidingSums   = nullptr; ///< sum of squares of each block in the window
+	int32_t  *m_slidingPeaks  = nullptr; ///< peak of each block in the window
+	int64_t   m_slidingSum    = 0;       ///< running sum of m_slidingSums
+
+	// Snapshot, the sequence is odd while the audio interrupt is writing
+	Levels m_levels;
+	std::atomic<uint32_t> m_sequence{0};
+
+	void m_measure(const int16_t *samples);
+	void m_publish(const Levels &levels);
+};
+
+}
+
+#endif /* __BAEFFECTS_AUDIOEFFECTMETER_H */
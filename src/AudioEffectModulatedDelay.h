@@ -0,0 +1,188 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  AudioEffectModulatedDelay is a chorus, flanger and vibrato effect built on a
+ *  single short delay line.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BAEFFECTS_AUDIOEFFECTMODULATEDDELAY_H
+#define __BAEFFECTS_AUDIOEFFECTMODULATEDDELAY_H
+
+#include <Audio.h>
+#include "LibBasicFunctions.h"
+
+namespace BAEffects {
+
+/**************************************************************************//**
+ * AudioEffectModulatedDelay is a modulated delay with up to MAX_VOICES voices.
+ * Chorus, flanger and vibrato are presets of the same engine.
+ * @details Every voice reads the same internal delay line at a fractional delay
+ * that sweeps from delay() to delay()+depth(). One LFO drives all the voices,
+ * each voice has its phase offset evenly around the cycle, so adding voices only
+ * costs one interpolated read per sample. The first voice is fed back into the
+ * delay line with feedback(), which is exact per sample so short flanger delays
+ * resonate correctly.
+ *****************************************************************************/
+class AudioEffectModulatedDelay : public AudioStream {
+public:
+
+	static constexpr unsigned MAX_VOICES = 4; ///< the maximum number of voices
+
+	///< List of AudioEffectModulatedDelay MIDI controllable parameters
+	enum {
+		BYPASS = 0,  ///< controls effect bypass
+		RATE,        ///< controls the rate of the modulation
+		DEPTH,       ///< controls the depth of the modulation
+		DELAY,       ///< controls the minimum delay of the voices
+		FEEDBACK,    ///< controls the amount of feedback (regen)
+		MIX,         ///< controls the the mix of input and modulated signals
+		VOICES,      ///< selects the number of voices
+		WAVEFORM,    ///< select the modulation waveform
+		VOLUME,      ///< controls the output volume level
+		NUM_CONTROLS ///< this can be used as an alias for the number of MIDI controls
+	};
+
+	/// The effect presets, see setPreset()
+	enum class Preset : unsigned {
+		CHORUS = 0, ///< three voices, 15 ms delay with 4 ms of slow modulation
+		FLANGER,    ///< one voice, 1 ms delay with 3 ms of very slow modulation and feedback
+		VIBRATO,    ///< one voice, 5 ms delay with 2 ms of fast modulation, 100% wet
+	};
+
+	// *** CONSTRUCTORS ***
+	/// Construct the effect with an internal delay line.
+	/// @param maxDelayMs the longest delay()+depth() needed in milliseconds
+	AudioEffectModulatedDelay(float maxDelayMs = 40.0f);
+
+	virtual ~AudioEffectModulatedDelay(); ///< Destructor
+
+	// *** PARAMETERS ***
+
+	/// Set the parameters to one of the presets. Bypass, enable and volume are unchanged.
+	/// @param preset the preset. E.g. AudioEffectModulatedDelay::Preset::FLANGER
+	void setPreset(Preset preset);
+
+	/// Set the modulation rate in Hertz
+	/// @param rateHz the LFO rate
+	void rate(float rateHz);
+
+	/// Set the modulation depth, the delay sweeps from delay() to delay()+depth()
+	/// @param milliseconds the sweep in milliseconds
+	void depth(float milliseconds);
+
+	/// Set the minimum delay of the voices
+	/// @param milliseconds the delay in milliseconds
+	void delay(float milliseconds);
+
+	/// Set the amount of the first voice fed back into the delay line.
+	/// @param feedback a floating point number between 0.0 and 1.0.
+	void feedback(float feedback) { m_feedback = static_cast<int16_t>(feedback * 32767.0f); }
+
+	/// Set the amount of blending between dry and modulated at the output.
+	/// @param mix When 0.0, output is 100% dry, when 1.0, output is 100% wet.
+	void mix(float mix) { m_mix = mix; }
+
+	/// Set the number of voices. The LFO phase of the voices is spread evenly.
+	/// @param numVoices the number of voices from 1 to MAX_VOICES
+	void voices(unsigned numVoices);
+
+	/// Change the modulation waveform
+	/// @param waveform specifies the desired waveform
+	void setWaveform(BALibrary::Waveform waveform);
+
+	/// Bypass the effect.
+	/// @param byp when true, bypass wil disable the effect, when false, effect is enabled.
+	/// Note that audio still passes through when bypass is enabled.
+	void bypass(bool byp) { m_bypass = byp; }
+
+	/// Get if the effect is bypassed
+	/// @returns true if bypassed, false if not bypassed
+	bool isBypass() { return m_bypass; }
+
+	/// Toggle the bypass effect
+	void toggleBypass() { m_bypass = !m_bypass; }
+
+	/// Set the output volume. This affect both the wet and dry signals.
+	/// @details The default is 1.0.
+	/// @param vol Sets the output volume between -1.0 and +1.0
+	void volume(float vol) {m_volume = vol; }
+
+	// ** ENABLE  / DISABLE **
+
+	/// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
+	void enable() { m_enable = true; }
+
+	/// Disables audio process. When disabled, CPU load is nearly zero.
+	void disable() { m_enable = false; }
+
+	// ** MIDI **
+
+	/// Sets whether MIDI OMNI channel is processig on or off. When on,
+	/// all midi channels are used for matching CCs.
+	/// @param isOmni when true, all channels are processed, when false, channel
+	/// must match configured value.
+	void setMidiOmni(bool isOmni) { m_isOmni = isOmni; }
+
+	/// Configure an effect parameter to be controlled by a MIDI CC
+	/// number on a particular channel.
+	/// @param parameter one of the parameter names in the class enum
+	/// @param midiCC the CC number from 0 to 127
+	/// @param midiChannel the effect will only response to the CC on this channel
+	/// when OMNI mode is off.
+	void mapMidiControl(int parameter, int midiCC, int midiChannel = 0);
+
+	/// process a MIDI Continous-Controller (CC) message
+	/// @param channel the MIDI channel from 0 to 15)
+	/// @param midiCC the CC number from 0 to 127
+	/// @param value the CC value from 0 to 127
+	void processMidi(int channel, int midiCC, int value);
+
+	virtual void update(void); ///< update automatically called by the Teesny Audio Library
+
+private:
+	using DelayLine = BALibrary::AudioDelayT<BALibrary::AudioDelayBackend::INTERNAL_FLAT>;
+
+	audio_block_t *m_inputQueueArray[1];
+	DelayLine *m_memory = nullptr;
+	BALibrary::LowFrequencyOscillatorVector<int16_t> m_osc; ///< Q15 LFO shared by all the voices
+	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
+	bool m_isOmni = false;
+	bool m_bypass = true;
+	bool m_enable = false;
+
+	// Controls
+	uint32_t m_maxSweep = 0;      ///< longest delay()+depth() in Q16.16 samples
+	uint32_t m_delayQ16 = 0;      ///< minimum delay in Q16.16 samples
+	uint32_t m_depthQ16 = 0;      ///< delay sweep in Q16.16 samples
+	float m_rate = 0.0f;
+	float m_delayMs = 0.0f;
+	float m_depthMs = 0.0f;
+	int16_t m_feedback = 0;       ///< Q15 feedback of the first voice
+	float m_mix = 0.5f;
+	unsigned m_numVoices = 1;     ///< number of voices requested
+	unsigned m_activeVoices = 0;  ///< number of voices the LFO phases are set for
+	BALibrary::Waveform m_waveform = BALibrary::Waveform::SINE;
+	float m_volume = 1.0f;
+
+	void m_updateSweep();
+	void m_calcDelays(uint32_t *delays, const int16_t *lfo);
+};
+
+}
+
+#endif /* __BAEFFECTS_AUDIOEFFECTMODULATEDDELAY_H */
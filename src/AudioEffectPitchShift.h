@@ -0,0 +1,178 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  AudioEffectPitchShift is a pitch shifter and harmonizer.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BAEFFECTS_AUDIOEFFECTPITCHSHIFT_H
+#define __BAEFFECTS_AUDIOEFFECTPITCHSHIFT_H
+
+#include <Audio.h>
+#include "LibBasicFunctions.h"
+
+namespace BAEffects {
+
+/**************************************************************************//**
+ * AudioEffectPitchShift shifts the pitch of the input by up to an octave up or
+ * down. With a dry mix and two voices it is a harmonizer.
+ * @details Each voice plays the input from a short internal delay line through a
+ * read head whose delay changes every sample, which changes the pitch. When the
+ * head nears the end of the delay line it is spliced back by a jump that is a whole
+ * number of pitch periods, found by correlating the audio at the head with the
+ * audio at the candidate jumps, then the old and new heads are crossfaded. The
+ * splice search is spread over the blocks before it is needed, the reads use the
+ * vectorized fractional delay reads and the latency is about 20 ms.
+ *****************************************************************************/
+class AudioEffectPitchShift : public AudioStream {
+public:
+
+	static constexpr unsigned MAX_VOICES = 2; ///< the maximum number of voices
+
+	///< List of AudioEffectPitchShift MIDI controllable parameters
+	enum {
+		BYPASS = 0,  ///< controls effect bypass
+		SHIFT_1,     ///< controls the pitch shift of the first voice, +/- one octave
+		SHIFT_2,     ///< controls the pitch shift of the second voice, +/- one octave
+		VOICES,      ///< selects one or two voices
+		MIX,         ///< controls the the mix of input and shifted signals
+		VOLUME,      ///< controls the output volume level
+		NUM_CONTROLS ///< this can be used as an alias for the number of MIDI controls
+	};
+
+	// *** CONSTRUCTORS ***
+	AudioEffectPitchShift();
+
+	virtual ~AudioEffectPitchShift(); ///< Destructor
+
+	// *** PARAMETERS ***
+
+	/// Set the pitch shift of a voice
+	/// @param voice the voice, 0 or 1
+	/// @param semitones the shift from -12.0 to +12.0 semitones
+	void shift(unsigned voice, float semitones);
+
+	/// Set the number of voices
+	/// @param numVoices 1 for a pitch shifter, 2 for a two voice harmonizer
+	void voices(unsigned numVoices);
+
+	/// Set the amount of blending between dry and shifted at the output. Use 1.0 for a
+	/// pitch shifter, or less to hear the input with the harmony.
+	/// @param mix When 0.0, output is 100% dry, when 1.0, output is 100% shifted.
+	void mix(float mix) { m_mix = mix; }
+
+	/// Bypass the effect.
+	/// @param byp when true, bypass wil disable the effect, when false, effect is enabled.
+	/// Note that audio still passes through when bypass is enabled.
+	void bypass(bool byp) { m_bypass = byp; }
+
+	/// Get if the effect is bypassed
+	/// @returns true if bypassed, false if not bypassed
+	bool isBypass() { return m_bypass; }
+
+	/// Toggle the bypass effect
+	void toggleBypass() { m_bypass = !m_bypass; }
+
+	/// Set the output volume. This affect both the wet and dry signals.
+	/// @details The default is 1.0.
+	/// @param vol Sets the output volume between -1.0 and +1.0
+	void volume(float vol) {m_volume = vol; }
+
+	// ** ENABLE  / DISABLE **
+
+	/// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
+	void enable() { m_enable = true; }
+
+	/// Disables audio process. When disabled, CPU load is nearly zero.
+	void disable() { m_enable = false; }
+
+	// ** MIDI **
+
+	/// Sets whether MIDI OMNI channel is processig on or off. When on,
+	/// all midi channels are used for matching CCs.
+	/// @param isOmni when true, all channels are processed, when false, channel
+	/// must match configured value.
+	void setMidiOmni(bool isOmni) { m_isOmni = isOmni; }
+
+	/// Configure an effect parameter to be controlled by a MIDI CC
+	/// number on a particular channel.
+	/// @param parameter one of the parameter names in the class enum
+	/// @param midiCC the CC number from 0 to 127
+	/// @param midiChannel the effect will only response to the CC on this channel
+	/// when OMNI mode is off.
+	void mapMidiControl(int parameter, int midiCC, int midiChannel = 0);
+
+	/// process a MIDI Continous-Controller (CC) message
+	/// @param channel the MIDI channel from 0 to 15)
+	/// @param midiCC the CC number from 0 to 127
+	/// @param value the CC value from 0 to 127
+	void processMidi(int channel, int midiCC, int value);
+
+	virtual void update(void); ///< update automatically called by the Teesny Audio Library
+
+private:
+	using DelayLine = BALibrary::AudioDelayT<BALibrary::AudioDelayBackend::INTERNAL_FLAT>;
+
+	static constexpr unsigned CORR_SAMPLES = 128; ///< length of audio compared for a splice
+	static constexpr unsigned MAX_LAG = 512;      ///< range of jumps searched, the longest pitch period
+
+	/// The state of a read head
+	enum class State : unsigned {
+		RUNNING = 0, ///< playing from one head
+		SEARCH,      ///< searching for the splice point
+		CROSSFADE,   ///< fading from the old head to the new head
+	};
+
+	/// A pitch shifted voice
+	struct Voice {
+		float    semitones = 0.0f;     ///< the pitch shift
+		int32_t  step = 0;             ///< change in delay per sample in Q16.16, 1 - ratio
+		int64_t  delay = 0;            ///< delay of the active head in Q16.16 samples
+		int64_t  nextDelay = 0;        ///< delay of the new head while crossfading
+		State    state = State::RUNNING;
+		int      jumpLow = 0;          ///< the jump for lag 0, negative when the delay is increasing
+		unsigned lag = 0;              ///< next lag to evaluate
+		unsigned bestLag = 0;          ///< the best lag found so far
+		float    bestScore = 0.0f;     ///< normalized correlation of the best lag
+		int64_t  energy = 0;           ///< energy of the candidate audio at the next lag
+		unsigned fade = 0;             ///< samples into the crossfade
+		int16_t  reference[CORR_SAMPLES];          ///< audio at the active head
+		int16_t  candidates[CORR_SAMPLES+MAX_LAG]; ///< audio at every candidate jump
+	};
+
+	audio_block_t *m_inputQueueArray[1];
+	DelayLine *m_memory = nullptr;
+	Voice m_voices[MAX_VOICES];
+	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
+	bool m_isOmni = false;
+	bool m_bypass = true;
+	bool m_enable = false;
+
+	// Controls
+	unsigned m_numVoices = 1;
+	float m_mix = 1.0f;
+	float m_volume = 1.0f;
+
+	void m_processVoice(Voice &voice, int16_t *out);
+	int64_t m_calcDelays(uint32_t *delays, int64_t delay, int32_t step);
+	void m_startSearch(Voice &voice, int jumpLow);
+	void m_searchSplice(Voice &voice);
+};
+
+}
+
+#endif /* __BAEFFECTS_AUDIOEFFECTPITCHSHIFT_H */
@@ -29,6 +29,12 @@ namespace BAEffects {
 
 /**************************************************************************//**
  * AudioEffectSOS
+ * @details When using an ExtMemSlot, the effect can also operate as a layered
+ * looper (see setLayers()). Each overdub pass is recorded into its own region of
+ * the slot and playback mixes the active layers, so undo/redo simply deactivate or
+ * reactivate the newest layer. When all the regions are used, the oldest layer is
+ * flattened into a base region during the next loop pass. This reuses the reads
+ * already done for playback so it only costs one extra write per block.
  *****************************************************************************/
 class AudioEffectSOS : public AudioStream {
 public:
@@ -43,6 +49,9 @@ public:
         CLEAR_FEEDBACK_TRIGGER, ///< begins the sequence to clear out the looping feedback
         FEEDBACK,        ///< controls the amount of feedback, more gives longer SOS sustain
         VOLUME,          ///< controls the output volume level
+        RECORD,          ///< starts or stops recording a loop layer
+        UNDO,            ///< deactivates the newest loop layer
+        REDO,            ///< reactivates the last undone loop layer
         NUM_CONTROLS     ///< this can be used as an alias for the number of MIDI controls
     };
 
@@ -50,6 +59,7 @@ public:
     AudioEffectSOS() = delete;
     AudioEffectSOS(float maxDelayMs);
     AudioEffectSOS(size_t numSamples);
+    AudioEffectSOS(BALibrary::AudioDelayBackend backend, size_t numSamples); ///< select INTERNAL_RING or INTERNAL_FLAT memory
 
     /// Construct an analog delay using external SPI via an ExtMemSlot. The amount of
     /// delay will be determined by the amount of memory in the slot.
@@ -83,6 +93,39 @@ public:
     /// @param vol Sets the output volume between -1.0 and +1.0
     void volume(float vol) {m_volume = vol; }
 
+    // ** LAYERED LOOPER **
+
+    /// The maximum number of loop layers kept for undo/redo
+    static constexpr unsigned MAX_LAYERS = BALibrary::ExtMemSlot::MAX_SLOT_BATCH_READS-1;
+
+    /// Enable the layered looper. The slot is divided into a base region for flattened
+    /// layers and numLayers regions for the layers, which sets the max loop length. Call after
+    /// the memory has been allocated to the slot. Requires EXTERNAL memory.
+    /// @param numLayers number of layers from 2 to MAX_LAYERS, or 0 to return to normal SOS operation.
+    /// @returns true on success, false on error
+    bool setLayers(unsigned numLayers);
+
+    /// Start recording a new layer at the next block. The first layer sets the loop length when
+    /// recording stops. Later layers record until stopped or one full pass of the loop. Any undone
+    /// layers are discarded.
+    void record() { m_recordRequest = true; }
+
+    /// Stop recording the current layer at the next block.
+    void stopRecording() { m_stopRequest = true; }
+
+    /// Deactivate the newest active layer
+    void undo() { m_undoRequest = true; }
+
+    /// Reactivate the most recently undone layer
+    void redo() { m_redoRequest = true; }
+
+    /// Erase all the layers and the loop length
+    void clearLayers() { m_clearRequest = true; }
+
+    /// Get the number of active layers, not counting layers that have been flattened
+    /// @returns the number of active layers
+    unsigned getNumActiveLayers() const { return m_numActiveLayers; }
+
     // ** ENABLE  / DISABLE **
 
     /// Enables audio processing. Note: when not enabled, CPU load is nearly zero.
@@ -140,7 +183,32 @@ private:
     BALibrary::ParameterAutomationSequence<float> m_clearFeedbackAuto = BALibrary::ParameterAutomationSequence<float>(3);
 
     // Private functions
+    // Layered looper
+    unsigned m_numRegions = 0;              ///< base region plus the layer regions, 0 when disabled
+    size_t   m_regionSamples = 0;           ///< size of each region in samples
+    size_t   m_loopLength = 0;              ///< loop length in samples, 0 until the first layer is recorded
+    size_t   m_loopPosition = 0;            ///< current playback/record position in the loop
+    unsigned m_layerRegion[MAX_LAYERS];     ///< region used by each layer, from oldest to newest
+    size_t   m_layerStart[MAX_LAYERS];      ///< loop position where each layer started recording
+    size_t   m_layerLength[MAX_LAYERS];     ///< number of samples recorded in each layer
+    unsigned m_numLayers = 0;               ///< number of layers recorded, including undone layers
+    unsigned m_numActiveLayers = 0;         ///< number of layers being played
+    bool     m_recording = false;           ///< when true, the newest layer is being recorded
+    bool     m_baseValid = false;           ///< when true, the base region contains flattened layers
+    size_t   m_flattenRemaining = 0;        ///< samples left in the flatten pass of the oldest layer
+    int16_t *m_layerData = nullptr;         ///< read buffers for the base and each layer
+    int16_t  m_recordBuffer[AUDIO_BLOCK_SAMPLES];  ///< samples being written to the recording layer
+    int16_t  m_flattenBuffer[AUDIO_BLOCK_SAMPLES]; ///< samples being written to the base region
+    volatile bool m_recordRequest = false;
+    volatile bool m_stopRequest = false;
+    volatile bool m_undoRequest = false;
+    volatile bool m_redoRequest = false;
+    volatile bool m_clearRequest = false;
+
     void m_preProcessing (audio_block_t *out, audio_block_t *input, audio_block_t *delayedSignal);
+    void m_updateLayers(audio_block_t *input);
+    void m_processLayerRequests(void);
+    bool m_isLayerActiveAt(unsigned layer, size_t position) const;
     void m_postProcessing(audio_block_t *out, audio_block_t *input);
 };
 
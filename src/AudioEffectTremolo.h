@@ -108,7 +108,7 @@ public:
 
 private:
 	audio_block_t *m_inputQueueArray[1];
-	BALibrary::LowFrequencyOscillatorVector<float> m_osc;
+	BALibrary::LowFrequencyOscillatorVector<int16_t> m_osc; ///< Q15 LFO
 	int m_midiConfig[NUM_CONTROLS][2]; // stores the midi parameter mapping
 	bool m_isOmni = false;
 	bool m_bypass = true;
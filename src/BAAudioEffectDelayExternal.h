@@ -29,12 +29,17 @@
 #include "AudioStream.h"
 
 #include "BAHardware.h"
+#include "LibMemoryManagement.h"
 
 namespace BAEffects {
 
 /**************************************************************************//**
  * BAAudioEffectDelayExternal can use external SPI RAM for delay rather than
  * the limited RAM available on the Teensy itself.
+ * @details When constructed with an ExtMemSlot, the memory is accessed through
+ * the slot. Tap windows that overlap or touch are merged into a single read and
+ * all the reads for a block are issued as one batch. When the slot uses DMA, the
+ * input write and every tap read are queued together as a single DMA chain.
  *****************************************************************************/
 class BAAudioEffectDelayExternal : public AudioStream
 {
@@ -51,6 +56,11 @@ public:
 	/// @param type specify which memory to use
 	/// @param delayLengthMs maximum delay length in milliseconds
 	BAAudioEffectDelayExternal(BALibrary::MemSelect mem, float delayLengthMs);
+
+	/// Use an external memory slot for the delay. The maximum delay is determined by
+	/// the size of the slot. If the slot uses DMA, memory transfers are done with DMA.
+	/// @param slot A pointer to the ExtMemSlot to use for the delay.
+	BAAudioEffectDelayExternal(BALibrary::ExtMemSlot *slot); // requires sufficiently sized pre-allocated memory
 	virtual ~BAAudioEffectDelayExternal();
 
 	/// set the actual amount of delay on a given delay tap
@@ -82,6 +92,11 @@ private:
 	static unsigned m_allocated[2];
 	audio_block_t *m_inputQueueArray[1];
 
+	static constexpr unsigned NUM_TAPS = 8;
+	BALibrary::ExtMemSlot *m_slot = nullptr;    ///< when set, the memory is accessed through the slot
+	audio_block_t *m_blockToRelease = nullptr;  ///< input block held until its DMA write is complete
+	int16_t m_tapBuffer[NUM_TAPS*AUDIO_BLOCK_SAMPLES]; ///< destination for the merged tap reads
+
 	SPIClass *m_spi = nullptr;
 	int m_spiChannel = 0;
 	int m_misoPin = 0;
@@ -91,6 +106,8 @@ private:
 
 	void m_startUsingSPI(int spiBus);
 	void m_stopUsingSPI(int spiBus);
+	bool m_initializeSlot(void);
+	void m_updateSlot(audio_block_t *block);
 };
 
 
@@ -24,8 +24,22 @@
 
 #include "BAAudioEffectDelayExternal.h"
 #include "AudioEffectAnalogDelay.h"
+#include "AudioEffectAnalogDelayStereo.h"
 #include "AudioEffectSOS.h"
 #include "AudioEffectTremolo.h"
 #include "AudioEffectRmsMeasure.h"
+#include "AudioEffectMeter.h"
+#include "AudioEffectModulatedDelay.h"
+#include "AudioEffectADT.h"
+#include "AudioEffectFdnReverb.h"
+#include "AudioEffectPitchShift.h"
+#include "AudioEffectConvolution.h"
+#include "AudioEffectConvolutionReverb.h"
+#include "AudioEffectDynamics.h"
+
+// F32 variants, only compiled when the OpenAudio_ArduinoLibrary is available
+#include "AudioEffectAnalogDelayF32.h"
+#include "AudioEffectSOSF32.h"
+#include "AudioEffectTremoloF32.h"
 
 #endif /* __BAEFFECTS_H */
@@ -25,6 +25,10 @@
 #include "BATypes.h"
 #include "LibBasicFunctions.h"
 #include "LibMemoryManagement.h"
+#include "LibFilterDesign.h"
+#include "LibSimd.h"
+#include "LibBlockOps.h"
+#include "LibAudioF32.h"
 
 #include "BAAudioControlWM8731.h" // Codec Control
 #include "BASpiMemory.h"
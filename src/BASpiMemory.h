@@ -32,6 +32,18 @@
 
 namespace BALibrary {
 
+/// The maximum number of reads that can be requested in one batch
+constexpr unsigned MAX_SPI_MEM_BATCH_READS = 16;
+
+/**************************************************************************//**
+ * SpiMemReadRequest describes one read within a batch of SPI memory reads.
+ *****************************************************************************/
+struct SpiMemReadRequest {
+	size_t    address;  ///< the address in the SPI RAM to read from
+	uint16_t *dest;     ///< pointer to the destination for the read data
+	size_t    numWords; ///< the number of 16-bit words to transfer
+};
+
 /**************************************************************************//**
  *  This wrapper class uses the Arduino SPI (Wire) library to access the SPI ram.
  *  @details The purpose of this class is primarily for functional testing since
@@ -108,6 +120,13 @@ public:
 	/// @param numWords the number of 16-bit words to transfer
 	virtual void read16(size_t address, uint16_t *dest, size_t numWords);
 
+	/// Read several blocks of 16-bit data, each from its own address.
+	/// @details the reads are performed one after the other.
+	/// @param requests array of read requests
+	/// @param numRequests number of requests in the array, must be <= MAX_SPI_MEM_BATCH_READS
+	/// @returns true on success, false on error
+	virtual bool readBatch16(const SpiMemReadRequest *requests, unsigned numRequests);
+
 	/// Check if the class has been configured by a previous begin() call
 	/// @returns true if initialized, false if not yet initialized
     bool isStarted() const { return m_started; }
@@ -198,6 +217,14 @@ public:
 	/// @param numWords the number of 16-bit words to transfer
 	void read16(size_t address, uint16_t *dest, size_t numWords) override;
 
+	/// Queue several 16-bit reads, each from its own address, as a single DMA chain. The
+	/// reads proceed back-to-back without CPU involvement. Check isReadBusy() before
+	/// using the data or sending the next DMA transfer.
+	/// @param requests array of read requests
+	/// @param numRequests number of requests in the array, must be <= MAX_SPI_MEM_BATCH_READS
+	/// @returns true on success, false on error
+	bool readBatch16(const SpiMemReadRequest *requests, unsigned numRequests) override;
+
 	/// Check if a DMA write is in progress
 	/// @returns true if a write DMA is in progress, else false
 	bool isWriteBusy() const override;
@@ -249,6 +276,10 @@ private:
 	uint16_t m_txXferCount;
 	uint16_t m_rxXferCount;
 
+	uint8_t          *m_batchCommandBuffer = nullptr; ///< CMD/address for each transfer in a batch read
+	DmaSpi::Transfer *m_batchTransfer      = nullptr; ///< CMD and data transfer pairs for a batch read
+	unsigned          m_batchXferCount     = 0;       ///< number of transfer pairs in the current batch
+
 	size_t  m_dmaCopyBufferSize  = 0;
 	uint8_t   *m_dmaWriteCopyBuffer = nullptr;
 	volatile uint8_t   *m_dmaReadCopyBuffer  = nullptr;
@@ -0,0 +1,43 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  LibAudioF32 enables the single-precision floating-point (F32) effect variants
+ *  when the OpenAudio_ArduinoLibrary is available. The F32 effects connect to
+ *  other AudioStream_F32 objects with AudioConnection_F32 and process float
+ *  blocks end to end. Include OpenAudio_ArduinoLibrary.h in your sketch before
+ *  BAEffects.h so the Arduino build adds it to the include path.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BALIBRARY_LIBAUDIOF32_H
+#define __BALIBRARY_LIBAUDIOF32_H
+
+#if !defined(BALIBRARY_F32) && defined(__has_include)
+#if __has_include(<AudioStream_F32.h>)
+#define BALIBRARY_F32 1 ///< set when the F32 effect variants are compiled
+#endif
+#endif
+
+#ifndef BALIBRARY_F32
+#define BALIBRARY_F32 0
+#endif
+
+#if BALIBRARY_F32
+#include <AudioStream_F32.h>
+#endif
+
+#endif /* __BALIBRARY_LIBAUDIOF32_H */
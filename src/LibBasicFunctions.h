@@ -30,6 +30,7 @@
 
 #include "BATypes.h"
 #include "LibMemoryManagement.h"
+#include "LibSimd.h"
 
 #ifndef __BALIBRARY_LIBBASICFUNCTIONS_H
 #define __BALIBRARY_LIBBASICFUNCTIONS_H
@@ -103,10 +104,357 @@ void gainAdjust(audio_block_t *out, audio_block_t *in, float vol, int coeffShift
 /// @param in1 pointer to second input audio block to combine
 void combine(audio_block_t *out, audio_block_t *in0, audio_block_t *in1);
 
+/// Scale an array of samples by a Q15 gain with saturation, the same as arm_scale_q15().
+/// @details in-place operation is allowed.
+/// @param dest pointer to the destination samples
+/// @param src pointer to the source samples
+/// @param scale Q15 gain
+/// @param coeffShift number of bits to shift the gain
+/// @param numSamples number of samples to scale
+void scaleSamples(int16_t *dest, const int16_t *src, int16_t scale, int coeffShift, size_t numSamples);
+
+/// Add two arrays of samples with saturation, the same as arm_add_q15().
+/// @details in-place operation is allowed.
+/// @param dest pointer to the destination samples
+/// @param src0 pointer to the first array of samples
+/// @param src1 pointer to the second array of samples
+/// @param numSamples number of samples to add
+void addSamples(int16_t *dest, const int16_t *src0, const int16_t *src1, size_t numSamples);
+
+/// Multiply an array of samples by an array of Q15 gains with saturation, e.g. to
+/// apply an LFO or envelope.
+/// @details in-place operation is allowed.
+/// @param dest pointer to the destination samples
+/// @param src pointer to the source samples
+/// @param gains pointer to the Q15 gain for each sample
+/// @param numSamples number of samples to multiply
+void modulateSamples(int16_t *dest, const int16_t *src, const int16_t *gains, size_t numSamples);
+
+/// Measure the peak absolute value and the sum of squares of an array of samples in one pass.
+/// @param src pointer to the samples to measure
+/// @param numSamples number of samples to measure
+/// @param peak returns the largest absolute sample value, 0 to 32768
+/// @param sumOfSquares returns the sum of each sample squared
+void measureSamples(const int16_t *src, size_t numSamples, int32_t *peak, int64_t *sumOfSquares);
+
+/// Reverse the order of an array of samples
+/// @details two samples are moved per 32-bit load/store when both arrays are word aligned.
+/// dest and src must not overlap.
+/// @param dest pointer to the destination samples
+/// @param src pointer to the source samples
+/// @param numSamples number of samples to reverse
+void reverseSamples(int16_t *dest, const int16_t *src, size_t numSamples);
+
+/// Reverse the order of an array of float samples
+/// @details dest and src must not overlap.
+/// @param dest pointer to the destination samples
+/// @param src pointer to the source samples
+/// @param numSamples number of samples to reverse
+void reverseSamples(float *dest, const float *src, size_t numSamples);
+
+/// Convert Q15 samples to float, where full scale is +/-1.0
+/// @param dest pointer to the destination float samples
+/// @param src pointer to the source Q15 samples
+/// @param numSamples number of samples to convert
+void convertQ15ToFloat(float *dest, const int16_t *src, size_t numSamples);
+
+/// Convert float samples to Q15 with rounding and saturation, where full scale is +/-1.0
+/// @param dest pointer to the destination Q15 samples
+/// @param src pointer to the source float samples
+/// @param numSamples number of samples to convert
+void convertFloatToQ15(int16_t *dest, const float *src, size_t numSamples);
+
 template <class T>
 class RingBuffer; // forward declare so AudioDelay can use it.
 
 
+constexpr size_t AUDIO_BLOCK_SIZE = sizeof(int16_t)*AUDIO_BLOCK_SAMPLES;
+
+/// Ensures the SPI DMA for the slot has an intermediate copy buffer. This is needed on the
+/// T4 since the audio buffers are not guarenteed to be cache aligned.
+/// @details Every transfer must fit in the copy buffer so call this with the largest transfer
+/// before the first one. The buffer is only ever grown since other slots on the same memory
+/// may require a larger one. Growing it waits for any transfer in progress.
+/// @param slot the slot whose underlying SPI DMA will be configured
+/// @param numBytes the largest transfer in bytes
+/// @returns true if the copy buffer was created, false if not needed or already large enough
+bool setSpiDmaCopyBuffer(ExtMemSlot *slot, size_t numBytes = AUDIO_BLOCK_SIZE);
+
+/// Selects the type of memory used to store the audio in an AudioDelayT.
+enum class AudioDelayBackend : unsigned {
+    INTERNAL_RING = 0, ///< a RingBuffer of audio_block_t pointers from the Teensy Audio Library
+    INTERNAL_FLAT,     ///< a flat circular buffer of samples in internal RAM
+    EXTERNAL_PIO,      ///< external SPI RAM via an ExtMemSlot using blocking transfers
+    EXTERNAL_DMA       ///< external SPI RAM via an ExtMemSlot using DMA transfers
+};
+
+/**************************************************************************//**
+ * AudioDelayT is a compile-time specialized audio delay. Each memory backend
+ * only contains the state it needs and all the member functions are inline, so
+ * effect processing written as a template over the backend gets the memory
+ * accesses inlined without any per-block checks on the memory type.
+ * @details all specializations provide the same interface:<br>
+ * addBlock(), getSamples(), getMaxDelaySamples() and waitForRead(). See
+ * AudioDelay for a description of each.
+ *****************************************************************************/
+template <AudioDelayBackend BACKEND>
+class AudioDelayT;
+
+/// INTERNAL memory storing a queue of pointers to the shared audio_block_t buffers
+template <>
+class AudioDelayT<AudioDelayBackend::INTERNAL_RING> {
+public:
+    AudioDelayT() = delete;
+    AudioDelayT(const AudioDelayT &) = delete;
+    AudioDelayT &operator=(const AudioDelayT &) = delete;
+
+    /// @param maxSamples equal or greater than your longest delay requirement
+    AudioDelayT(size_t maxSamples)
+    : m_ringBuffer(calcQueuePosition(maxSamples).index+2), // If the delay is in queue x, we need to overflow into x+1, thus x+2 total buffers.
+      m_maxDelaySamples(maxSamples) {}
+
+    audio_block_t *addBlock(audio_block_t *blockIn) {
+        audio_block_t *blockToRelease = nullptr;
+        // purposefully don't check if block is valid, the ringBuffer can support nullptrs
+        if ( m_ringBuffer.size() >= m_ringBuffer.max_size() ) {
+            // pop before adding
+            blockToRelease = m_ringBuffer.front();
+            m_ringBuffer.pop_front();
+        }
+        m_ringBuffer.push_back(blockIn);
+        return blockToRelease;
+    }
+
+    bool getSamples(int16_t *dest, size_t offsetSamples, size_t numSamples = AUDIO_BLOCK_SAMPLES) {
+        QueuePosition position = calcQueuePosition(offsetSamples);
+        size_t index = position.index;
+
+        audio_block_t *currentQueue0 = m_ringBuffer.at(m_ringBuffer.get_index_from_back(index));
+        // The latest buffer is at the back. We need index+1 counting from the back.
+        audio_block_t *currentQueue1 = m_ringBuffer.at(m_ringBuffer.get_index_from_back(index+1));
+
+        // check if either queue is invalid, if so just zero the destination buffer
+        if ( (!currentQueue0) || (!currentQueue1) ) {
+            // a valid entry is not in all queue positions while it is filling, use zeros
+            memset(static_cast<void*>(dest), 0, numSamples * sizeof(int16_t));
+            return true;
+        }
+
+        if ( (position.offset == 0) && numSamples <= AUDIO_BLOCK_SAMPLES ) {
+            // single transfer
+            memcpy(static_cast<void*>(dest), static_cast<void*>(currentQueue0->data), numSamples * sizeof(int16_t));
+            return true;
+        }
+
+        // Otherwise we need to break the transfer into two memcpy because it will go across two source queues.
+        // Copy the 'older' data first then the 'newer' data with respect to current time.
+        size_t numData = position.offset;
+        memcpy(static_cast<void*>(dest), static_cast<void*>(currentQueue1->data + AUDIO_BLOCK_SAMPLES - numData), numData * sizeof(int16_t));
+        memcpy(static_cast<void*>(dest + numData), static_cast<void*>(currentQueue0->data), (numSamples - numData) * sizeof(int16_t));
+        return true;
+    }
+
+    size_t getMaxDelaySamples() const { return m_maxDelaySamples; }
+    void waitForRead() const {}
+
+    /// @returns the index audio block, where the most recent block is 0.
+    audio_block_t *getBlock(size_t index) { return m_ringBuffer.at(m_ringBuffer.get_index_from_back(index)); }
+
+    /// @returns pointer to the underlying RingBuffer
+    RingBuffer<audio_block_t*> *getRingBuffer() { return &m_ringBuffer; }
+
+private:
+    RingBuffer<audio_block_t *> m_ringBuffer;
+    size_t m_maxDelaySamples;
+};
+
+/// INTERNAL memory storing samples in a flat circular buffer. Unlike INTERNAL_RING, reads
+/// of any size and alignment are supported and no audio blocks are held by the delay.
+/// Reads may also be modulated, with a separate fractional delay for every sample.
+template <>
+class AudioDelayT<AudioDelayBackend::INTERNAL_FLAT> {
+public:
+    AudioDelayT() = delete;
+    AudioDelayT(const AudioDelayT &) = delete;
+    AudioDelayT &operator=(const AudioDelayT &) = delete;
+
+    /// @param maxSamples equal or greater than your longest delay requirement
+    AudioDelayT(size_t maxSamples)
+    : m_bufferSize(maxSamples + AUDIO_BLOCK_SAMPLES), m_maxDelaySamples(maxSamples) {
+        // the extra sample mirrors the first so an interpolated pair never wraps
+        m_buffer = new int16_t[m_bufferSize+1]();
+    }
+    ~AudioDelayT() { if (m_buffer) delete [] m_buffer; }
+
+    audio_block_t *addBlock(audio_block_t *blockIn) {
+        // a missing block is stored as silence
+        size_t numData = m_bufferSize - m_writePosition;
+        if (numData > AUDIO_BLOCK_SAMPLES) { numData = AUDIO_BLOCK_SAMPLES; }
+        if (blockIn) {
+            memcpy(m_buffer + m_writePosition, blockIn->data, numData * sizeof(int16_t));
+            memcpy(m_buffer, blockIn->data + numData, (AUDIO_BLOCK_SAMPLES - numData) * sizeof(int16_t));
+        } else {
+            memset(m_buffer + m_writePosition, 0, numData * sizeof(int16_t));
+            memset(m_buffer, 0, (AUDIO_BLOCK_SAMPLES - numData) * sizeof(int16_t));
+        }
+        m_buffer[m_bufferSize] = m_buffer[0];
+        m_writePosition += AUDIO_BLOCK_SAMPLES;
+        if (m_writePosition >= m_bufferSize) { m_writePosition -= m_bufferSize; }
+        return blockIn;
+    }
+
+    /// Add a block of samples with feedback from a modulated read, e.g. for a flanger.
+    /// Each sample is stored as input[i] + feedback*wet[i], where wet[i] is read from
+    /// the delay line by delays[i] as in getSamplesModulated(). The samples are processed
+    /// in order, so the feedback loop is exactly the modulated delay.
+    /// @param input the input samples, a nullptr is silence
+    /// @param delays the delay of each sample in Q16.16 samples, from 1.0 to getMaxDelaySamples()-1
+    /// @param feedback the feedback gain in Q15
+    /// @param wet the delayed samples that were fed back, may be nullptr
+    void addBlockModulated(const int16_t *input, const uint32_t *delays, int16_t feedback, int16_t *wet) {
+        size_t position = m_writePosition;
+        for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+            const int32_t delayed = m_readInterpolated(position, delays[i]);
+            const int32_t in = input ? (static_cast<int32_t>(input[i]) << 15) : 0;
+            m_buffer[position] = simd::saturate16((in + feedback*delayed) >> 15);
+            if (position == 0) { m_buffer[m_bufferSize] = m_buffer[0]; }
+            if (wet) { wet[i] = static_cast<int16_t>(delayed); }
+            if (++position >= m_bufferSize) { position = 0; }
+        }
+        m_writePosition = position;
+    }
+
+    bool getSamples(int16_t *dest, size_t offsetSamples, size_t numSamples = AUDIO_BLOCK_SAMPLES) {
+        if (offsetSamples + numSamples > m_bufferSize) { return false; }
+
+        // the newest numSamples are the smallest delay, back up from there by the offset
+        int readPosition = (int)m_writePosition - (int)(numSamples + offsetSamples);
+        if (readPosition < 0) { readPosition += m_bufferSize; }
+
+        size_t numData = m_bufferSize - readPosition;
+        if (numData > numSamples) { numData = numSamples; }
+        memcpy(dest, m_buffer + readPosition, numData * sizeof(int16_t));
+        memcpy(dest + numData, m_buffer, (numSamples - numData) * sizeof(int16_t));
+        return true;
+    }
+
+    /// Read the newest numSamples, each delayed by its own fractional amount with linear
+    /// interpolation. E.g. several chorus voices can read the same delay line with
+    /// different modulation.
+    /// @param dest pointer to the destination samples
+    /// @param delays the delay of each sample in Q16.16 samples, from 1.0 to getMaxDelaySamples()-1
+    /// @param numSamples number of samples to read
+    /// @returns false if more samples were requested than the delay holds
+    bool getSamplesModulated(int16_t *dest, const uint32_t *delays, size_t numSamples = AUDIO_BLOCK_SAMPLES) const {
+        if (numSamples > AUDIO_BLOCK_SAMPLES) { return false; }
+
+        int position = (int)m_writePosition - (int)numSamples;
+        if (position < 0) { position += m_bufferSize; }
+        for (size_t i=0; i<numSamples; i++) {
+            dest[i] = static_cast<int16_t>(m_readInterpolated(position, delays[i]));
+            if (++position >= (int)m_bufferSize) { position = 0; }
+        }
+        return true;
+    }
+
+    size_t getMaxDelaySamples() const { return m_maxDelaySamples; }
+    void waitForRead() const {}
+
+private:
+    /// Interpolate the sample delay samples before position, where delay is Q16.16
+    int32_t m_readInterpolated(size_t position, uint32_t delay) const {
+        // load the older and newer samples as a pair, the guard sample covers the wrap
+        int index = (int)position - (int)(delay >> 16) - 1;
+        if (index < 0) { index += m_bufferSize; }
+        const int32_t pair = simd::load2(m_buffer + index);
+
+        // newer + fraction*(older - newer) with a single SMLAD, rounded
+        const int32_t fraction = (delay >> 1) & 0x7FFF;
+        const int32_t acc = simd::smlad(pair, simd::pack16(fraction, -fraction), (simd::unpackHigh(pair) << 15) + (1 << 14));
+        return acc >> 15;
+    }
+
+    int16_t *m_buffer = nullptr;
+    size_t m_bufferSize;
+    size_t m_maxDelaySamples;
+    size_t m_writePosition = 0;
+};
+
+/// EXTERNAL memory base shared by the PIO and DMA backends
+template <bool USE_DMA>
+class AudioDelayExtMem {
+public:
+    AudioDelayExtMem() = delete;
+
+    /// @param slot a pointer to the slot representing the memory you wish to use for the buffer.
+    AudioDelayExtMem(ExtMemSlot *slot) : m_slot(slot) {}
+
+    audio_block_t *addBlock(audio_block_t *blockIn) {
+        if (blockIn) {
+#if defined(__IMXRT1062__)
+            // KLUGE! The Teensy Audio Library doesn't support DMA buffers correctly on the T4.0.
+            if (USE_DMA) { setSpiDmaCopyBuffer(m_slot); }
+#endif
+            m_slot->writeAdvance16(blockIn->data, AUDIO_BLOCK_SAMPLES);
+        }
+        // the block must not be released until the write completes
+        return blockIn;
+    }
+
+    bool getSamples(int16_t *dest, size_t offsetSamples, size_t numSamples = AUDIO_BLOCK_SAMPLES) {
+        if (numSamples*sizeof(int16_t) > m_slot->size()) {
+            // numSamples is > than total slot size
+            if (Serial) { Serial.println("getSamples(): ERROR numSamples > total slot size"); }
+            return false;
+        }
+
+        // current position is considered the write position subtracted by the number of samples we're going
+        // to read since this is the smallest delay we can get without reading past the write position into
+        // the "future".
+        int currentPositionBytes = (int)m_slot->getWritePosition() - (int)(numSamples*sizeof(int16_t));
+        size_t offsetBytes = offsetSamples * sizeof(int16_t);
+
+        if ((int)offsetBytes <= currentPositionBytes) {
+            // when we back up to read, we won't wrap over the beginning of the slot
+            m_slot->setReadPosition(currentPositionBytes - offsetBytes);
+        } else {
+            // It's going to wrap around to the from the beginning to the end of the slot.
+            m_slot->setReadPosition((size_t)((int)m_slot->size() + currentPositionBytes - (int)offsetBytes));
+        }
+
+        // Read the number of samples. When using DMA, dest won't be filled until waitForRead() returns.
+        m_slot->readAdvance16(dest, numSamples);
+        return true;
+    }
+
+    /// The max delay is one audio block less then the full size to prevent wrapping.
+    size_t getMaxDelaySamples() const { return (m_slot->size() / sizeof(int16_t)) - AUDIO_BLOCK_SAMPLES; }
+
+    /// Wait for the read requested by getSamples() to complete
+    void waitForRead() const {
+        if (USE_DMA) { while (m_slot->isReadBusy()) {} }
+    }
+
+    ExtMemSlot *getSlot() const { return m_slot; }
+
+private:
+    ExtMemSlot *m_slot;
+};
+
+/// EXTERNAL memory using blocking SPI transfers
+template <>
+class AudioDelayT<AudioDelayBackend::EXTERNAL_PIO> : public AudioDelayExtMem<false> {
+public:
+    using AudioDelayExtMem<false>::AudioDelayExtMem;
+};
+
+/// EXTERNAL memory using DMA SPI transfers
+template <>
+class AudioDelayT<AudioDelayBackend::EXTERNAL_DMA> : public AudioDelayExtMem<true> {
+public:
+    using AudioDelayExtMem<true>::AudioDelayExtMem;
+};
+
 /**************************************************************************//**
  * Audio delays are a very common function in audio processing. In addition to
  * being used for simply create a delay effect, it can also be used for buffering
@@ -118,9 +466,10 @@ class RingBuffer; // forward declare so AudioDelay can use it.
  * Note that using INTERNAL memory means the class will only store a queue
  * of pointers to audio_block_t buffers, since the Teensy Audio uses a shared memory
  * approach. When using EXTERNAL memory, data is actually copyied to/from an external
- * SRAM device.
+ * SRAM device.<br>
+ * AudioDelay is a runtime wrapper around the AudioDelayT backends. Use visit() to
+ * run per-block processing against the statically typed backend.
  *****************************************************************************/
-constexpr size_t AUDIO_BLOCK_SIZE = sizeof(int16_t)*AUDIO_BLOCK_SAMPLES;
 class AudioDelay {
 public:
     AudioDelay() = delete;
@@ -139,8 +488,42 @@ public:
     /// @param slot a pointer to the slot representing the memory you wish to use for the buffer.
     AudioDelay(ExtMemSlot *slot);
 
+    /// Construct an audio buffer using INTERNAL memory with the specified backend.
+    /// @param backend either AudioDelayBackend::INTERNAL_RING or AudioDelayBackend::INTERNAL_FLAT
+    /// @param maxSamples equal or greater than your longest delay requirement
+    AudioDelay(AudioDelayBackend backend, size_t maxSamples);
+
     ~AudioDelay();
 
+    /// Get the memory backend in use. For EXTERNAL memory, DMA use is determined by the slot.
+    /// @returns the backend type
+    AudioDelayBackend getBackendType() const {
+        if (m_backend == AudioDelayBackend::INTERNAL_RING || m_backend == AudioDelayBackend::INTERNAL_FLAT) { return m_backend; }
+        return m_slot->isUseDma() ? AudioDelayBackend::EXTERNAL_DMA : AudioDelayBackend::EXTERNAL_PIO;
+    }
+
+    /// Get the statically typed backend
+    /// @returns a pointer to the backend, or nullptr if BACKEND is not the one in use
+    template <AudioDelayBackend BACKEND>
+    AudioDelayT<BACKEND> *getBackend();
+
+    /// Call a function (typically a generic lambda) with a pointer to the statically typed
+    /// backend in use. This allows effect processing to be written once and compiled for each
+    /// backend, with only a single check on the memory type per call.
+    /// @param func the function to call, its return type must be the same for all backends.
+    /// @returns the value returned by func
+    template <class Func>
+    auto visit(Func &&func) -> decltype(func(static_cast<AudioDelayT<AudioDelayBackend::INTERNAL_RING>*>(nullptr))) {
+        switch (getBackendType()) {
+        case AudioDelayBackend::INTERNAL_FLAT : return func(m_flat);
+        case AudioDelayBackend::EXTERNAL_PIO  : return func(&m_extPio);
+        case AudioDelayBackend::EXTERNAL_DMA  : return func(&m_extDma);
+        case AudioDelayBackend::INTERNAL_RING :
+        default :
+            return func(m_ring);
+        }
+    }
+
     /// Add a new audio block into the buffer. When the buffer is filled,
     /// adding a new block will push out the oldest once which is returned.
     /// @param blockIn pointer to the most recent block of audio
@@ -191,6 +574,27 @@ public:
     /// @returns true on success, false on error.
     bool interpolateDelay(int16_t *extendedSourceBuffer, int16_t *destBuffer, float fraction, size_t numSamples = AUDIO_BLOCK_SAMPLES);
 
+    /// Set the window length for reverse playback. Each window of audio is played backwards
+    /// with a one block crossfade at the window boundaries. The reverse playback lags the input
+    /// by up to twice the window length.
+    /// @details the window is rounded down to a multiple of AUDIO_BLOCK_SAMPLES and limited
+    /// by the max delay. The first call allocates the reverse playback buffers so it should
+    /// not be made from update().
+    /// @param windowSamples the length of the window in samples
+    /// @returns the actual window length in samples
+    size_t setReverseWindow(size_t windowSamples);
+
+    /// Request the next block of reverse playback. Call once per audio block before addBlock().
+    /// @details memory is always read forwards, one read per block, and reversed internally.
+    /// @returns true on success, false on error.
+    bool requestReverseSamples(void);
+
+    /// Get the block of reverse playback requested by requestReverseSamples(). When using DMA
+    /// this will wait for the read to complete.
+    /// @param dest pointer to the target sample array, must hold AUDIO_BLOCK_SAMPLES
+    /// @returns true on success, false on error.
+    bool getReverseSamples(int16_t *dest);
+
     /// When using EXTERNAL memory, this function can return a pointer to the underlying ExtMemSlot object associated
     /// with the buffer.
     /// @returns pointer to the underlying ExtMemSlot.
@@ -201,24 +605,263 @@ public:
     /// @returns true if suceess, false if an error occurs
     bool setSpiDmaCopyBuffer(void);
 
-    /// When using INTERNAL memory, this function can return a pointer to the underlying RingBuffer that contains
+    /// When using INTERNAL_RING memory, this function can return a pointer to the underlying RingBuffer that contains
     /// audio_block_t * pointers.
-    /// @returns pointer to the underlying RingBuffer
-    RingBuffer<audio_block_t*> *getRingBuffer() const { return m_ringBuffer; }
+    /// @returns pointer to the underlying RingBuffer, or nullptr for other backends
+    RingBuffer<audio_block_t*> *getRingBuffer() const { return m_ring ? m_ring->getRingBuffer() : nullptr; }
 
 private:
+    AudioDelayBackend m_backend;                                         ///< the configured memory backend
+    AudioDelayT<AudioDelayBackend::INTERNAL_RING> *m_ring = nullptr;     ///< When using INTERNAL_RING memory
+    AudioDelayT<AudioDelayBackend::INTERNAL_FLAT> *m_flat = nullptr;     ///< When using INTERNAL_FLAT memory
+    ExtMemSlot *m_slot = nullptr;                                        ///< When using EXTERNAL memory, an ExtMemSlot must be provided.
+    AudioDelayT<AudioDelayBackend::EXTERNAL_PIO> m_extPio = AudioDelayT<AudioDelayBackend::EXTERNAL_PIO>(nullptr);
+    AudioDelayT<AudioDelayBackend::EXTERNAL_DMA> m_extDma = AudioDelayT<AudioDelayBackend::EXTERNAL_DMA>(nullptr);
+    bool m_getSamples(int16_t *dest, size_t offsetSamples, size_t numSamples); ///< operates directly on int16_y buffers
 
-    /// enumerates whether the underlying memory buffer uses INTERNAL or EXTERNAL memory
-    enum class MemType : unsigned {
-        MEM_INTERNAL = 0, ///< internal audio_block_t from the Teensy Audio Library is used
-        MEM_EXTERNAL      ///< external SPI based ram is used
-    };
+    // Reverse playback
+    size_t   m_reverseWindow = 0;           ///< length of the reverse playback window in samples
+    size_t   m_reversePhase  = 0;           ///< position of the current block in the window
+    size_t   m_reverseReadSamples = 0;      ///< number of samples in the last forward read
+    int16_t *m_reverseBuffer = nullptr;     ///< forward read buffer, two blocks followed by the crossfade tail
+};
 
-    MemType m_type;                                      ///< when 0, INTERNAL memory, when 1, external MEMORY.
-    RingBuffer<audio_block_t *> *m_ringBuffer = nullptr; ///< When using INTERNAL memory, a RingBuffer will be created.
-    ExtMemSlot *m_slot = nullptr;                        ///< When using EXTERNAL memory, an ExtMemSlot must be provided.
-    size_t m_maxDelaySamples = 0;                        ///< stores the number of audio samples in the AudioDelay.
-    bool m_getSamples(int16_t *dest, size_t offsetSamples, size_t numSamples); ///< operates directly on int16_y buffers
+template <>
+inline AudioDelayT<AudioDelayBackend::INTERNAL_RING> *AudioDelay::getBackend<AudioDelayBackend::INTERNAL_RING>() { return m_ring; }
+template <>
+inline AudioDelayT<AudioDelayBackend::INTERNAL_FLAT> *AudioDelay::getBackend<AudioDelayBackend::INTERNAL_FLAT>() { return m_flat; }
+template <>
+inline AudioDelayT<AudioDelayBackend::EXTERNAL_PIO> *AudioDelay::getBackend<AudioDelayBackend::EXTERNAL_PIO>() {
+    return (getBackendType() == AudioDelayBackend::EXTERNAL_PIO) ? &m_extPio : nullptr;
+}
+template <>
+inline AudioDelayT<AudioDelayBackend::EXTERNAL_DMA> *AudioDelay::getBackend<AudioDelayBackend::EXTERNAL_DMA>() {
+    return (getBackendType() == AudioDelayBackend::EXTERNAL_DMA) ? &m_extDma : nullptr;
+}
+
+/**************************************************************************//**
+ * AudioDelayF32 is the single-precision floating-point version of AudioDelay used
+ * by the F32 effects.
+ * @details INTERNAL memory stores float samples in a flat circular buffer, so there
+ * are no format conversions and no loss of headroom. EXTERNAL memory stores Q15
+ * samples in an ExtMemSlot, the samples are converted when written and when the
+ * read completes. Reads and writes work the same as AudioDelay with the
+ * INTERNAL_FLAT or EXTERNAL backends. When using DMA, getSamples() only requests
+ * the read, call waitForRead() before using the samples.
+ *****************************************************************************/
+class AudioDelayF32 {
+public:
+    AudioDelayF32() = delete;
+    AudioDelayF32(const AudioDelayF32 &) = delete;
+    AudioDelayF32 &operator=(const AudioDelayF32 &) = delete;
+
+    /// The largest read supported by EXTERNAL memory, in samples. One block fits the T4 DMA copy buffer.
+    static constexpr size_t MAX_EXTERNAL_READ_SAMPLES = AUDIO_BLOCK_SAMPLES;
+
+    /// Construct an audio buffer using INTERNAL memory by specifying the max number
+    /// of audio samples you will want.
+    /// @param maxSamples equal or greater than your longest delay requirement
+    AudioDelayF32(size_t maxSamples);
+
+    /// Construct an audio buffer using INTERNAL memory by specifying the max amount of
+    /// time you will want available in the buffer.
+    /// @param maxDelayTimeMs max length of time you want in the buffer specified in milliseconds
+    AudioDelayF32(float maxDelayTimeMs);
+
+    /// Construct an audio buffer using a slot configured with the BALibrary::ExternalSramManager
+    /// @param slot a pointer to the slot representing the memory you wish to use for the buffer.
+    AudioDelayF32(ExtMemSlot *slot);
+
+    ~AudioDelayF32();
+
+    /// Add a new block of samples into the buffer.
+    /// @param samples pointer to AUDIO_BLOCK_SAMPLES samples, or nullptr to add silence
+    void addBlock(const float *samples);
+
+    /// Returns the max possible delay samples. For EXTERNAL memory, the max delay is actually one audio
+    /// block less then the full size to prevent wrapping.
+    /// @returns the maximum delay offset in units of samples.
+    size_t getMaxDelaySamples() const;
+
+    /// Retrieve samples from the buffer
+    /// @param dest pointer to the target sample array to write the samples to.
+    /// @param offsetSamples data will start being transferred offset samples from the start of the audio buffer
+    /// @param numSamples number of samples to transfer, up to MAX_EXTERNAL_READ_SAMPLES for EXTERNAL memory
+    /// @returns true on success, false on error.
+    bool getSamples(float *dest, size_t offsetSamples, size_t numSamples = AUDIO_BLOCK_SAMPLES);
+
+    /// Wait for the read requested by getSamples() to complete. Always call this before
+    /// using the samples when using EXTERNAL memory.
+    void waitForRead();
+
+    /// Set the window length for reverse playback, see AudioDelay::setReverseWindow()
+    /// @param windowSamples the length of the window in samples
+    /// @returns the actual window length in samples
+    size_t setReverseWindow(size_t windowSamples);
+
+    /// Request the next block of reverse playback. Call once per audio block before addBlock().
+    /// @returns true on success, false on error.
+    bool requestReverseSamples(void);
+
+    /// Get the block of reverse playback requested by requestReverseSamples(). When using DMA
+    /// this will wait for the read to complete.
+    /// @param dest pointer to the target sample array, must hold AUDIO_BLOCK_SAMPLES
+    /// @returns true on success, false on error.
+    bool getReverseSamples(float *dest);
+
+    /// When using EXTERNAL memory, this function can return a pointer to the underlying ExtMemSlot object associated
+    /// with the buffer.
+    /// @returns pointer to the underlying ExtMemSlot, or nullptr for INTERNAL memory
+    ExtMemSlot *getSlot() const { return m_slot; }
+
+private:
+    // INTERNAL memory
+    float  *m_buffer = nullptr;             ///< flat circular buffer of samples
+    size_t  m_bufferSize = 0;
+    size_t  m_maxDelaySamples = 0;
+    size_t  m_writePosition = 0;
+
+    // EXTERNAL memory, the Q15 samples are staged here for the SPI transfers
+    ExtMemSlot *m_slot = nullptr;
+    AudioDelayExtMem<true> m_extMem = AudioDelayExtMem<true>(nullptr); ///< waitForRead() returns immediately without DMA
+    int16_t *m_writeBuffer = nullptr;       ///< Q15 samples being written
+    int16_t *m_readBuffer  = nullptr;       ///< Q15 samples being read
+    float   *m_readDest    = nullptr;       ///< destination of the pending read, nullptr if none
+    size_t   m_readSamples = 0;             ///< size of the pending read
+
+    // Reverse playback
+    size_t m_reverseWindow = 0;             ///< length of the reverse playback window in samples
+    size_t m_reversePhase  = 0;             ///< position of the current block in the window
+    size_t m_reverseReadSamples = 0;        ///< number of samples in the last forward read
+    float *m_reverseBuffer = nullptr;       ///< forward read buffer, two blocks followed by the crossfade tail
+};
+
+/// Biquad filter responses supported by designBiquad()
+enum class BiquadType : unsigned {
+	LOW_PASS = 0, ///< 2nd-order lowpass, Q sets the resonance
+	HIGH_PASS,    ///< 2nd-order highpass, Q sets the resonance
+	BAND_PASS,    ///< constant 0dB peak gain bandpass
+	NOTCH,        ///< band reject
+	PEAKING,      ///< peaking EQ, gainDb sets the boost or cut
+	LOW_SHELF,    ///< low shelf, gainDb sets the boost or cut
+	HIGH_SHELF    ///< high shelf, gainDb sets the boost or cut
+};
+
+/// Design a single biquad stage using the RBJ Audio EQ Cookbook formulas.
+/// @details The coefficients are {b0, b1, b2, a1, a2} with the 'a' coefficients negated
+/// as expected by CMSIS-DSP. This function uses double-precision trig functions, call it
+/// from your loop() code, not from inside update().
+/// @param type the filter response
+/// @param fc the cutoff or center frequency in Hz
+/// @param q the filter Q. For shelves, 0.7071 gives the steepest slope without overshoot.
+/// @param gainDb the boost or cut in dB, only used by PEAKING, LOW_SHELF and HIGH_SHELF
+/// @param coeffs pointer to an array of 5 coefficients where the result is written
+/// @returns false if the parameters are out of range
+bool designBiquad(BiquadType type, float fc, float q, float gainDb, float *coeffs);
+
+/// Design a single biquad stage in the Q31 format used by IirBiQuadFilter and IirBiQuadFilterHQ.
+/// @param type the filter response
+/// @param fc the cutoff or center frequency in Hz
+/// @param q the filter Q
+/// @param gainDb the boost or cut in dB, only used by PEAKING, LOW_SHELF and HIGH_SHELF
+/// @param coeffs pointer to an array of 5 Q31 coefficients where the result is written
+/// @param coeffShift coeffs are multiplied by 2^coeffShift. A shift of at least 1 is required
+/// since a1 can approach 2.0. Peaks and shelves with more than 6dB of boost may require 3.
+/// @returns false if the parameters are out of range or a coefficient does not fit
+bool designBiquad(BiquadType type, float fc, float q, float gainDb, int32_t *coeffs, int coeffShift);
+
+/**************************************************************************//**
+ * IirBiQuadMorph is used by the Q31 biquad filters to change coefficients without
+ * clicks or races with the audio interrupt.
+ * @details New coefficients are published from the main loop into one of two buffers
+ * and handed to the audio interrupt with an atomic index. The change is then spread
+ * over one audio block using one of two transitions.<br>
+ * INTERPOLATE linearly interpolates every coefficient from old to new without touching
+ * the filter state. Since the stable region for (a1, a2) is convex, every intermediate
+ * stage is stable. Use this for sweeping a filter, e.g. a tone control, in small steps.
+ * When the number of stages changes, missing stages are treated as pass-through.<br>
+ * CROSSFADE starts the new filter from rest alongside the old one and crossfades their
+ * outputs. Use this when switching between unrelated filters, such as presets, where
+ * the intermediate coefficients could have very large gains.
+ *****************************************************************************/
+class IirBiQuadMorph {
+public:
+	/// The transition used to move to the new coefficients
+	enum class Transition : unsigned {
+		INTERPOLATE = 0, ///< interpolate the coefficients, keep the filter state
+		CROSSFADE        ///< crossfade the outputs of the old and new filters
+	};
+
+	IirBiQuadMorph() = delete;
+	/// Construct for a filter with the specified maximum number of stages
+	IirBiQuadMorph(unsigned maxNumStages);
+	virtual ~IirBiQuadMorph();
+
+	/// Publish new coefficients. Call this from outside the audio interrupt.
+	/// @details if called again before the filter has picked up the previous
+	/// coefficients, the previous ones are skipped. A pending CROSSFADE is kept so
+	/// the new coefficients are never interpolated from an unrelated filter.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift
+	/// @param transition how to move from the old coefficients to the new ones
+	/// @returns false if numStages is too large
+	bool publish(unsigned numStages, const int32_t *coeffs, int coeffShift, Transition transition = Transition::INTERPOLATE);
+
+	/// Discard any published coefficients that have not been picked up yet
+	void cancel() { m_pending.store(-1); }
+
+	/// Check if new coefficients are waiting to be picked up
+	/// @returns true if there are published coefficients
+	bool isPending() const { return m_pending.load() >= 0; }
+
+	/// Pick up the published coefficients and set up the transition. Called by
+	/// the filter from the audio interrupt.
+	/// @param numStages the filter's current number of stages
+	/// @param coeffShift the filter's current coefficient shift
+	/// @param coeffs the filter's current coefficients
+	/// @param numSamples the number of samples to transition over
+	/// @returns the number of stages to run with getCoeffs() during the transition, or 0
+	/// if nothing was pending
+	unsigned start(unsigned numStages, int coeffShift, const int32_t *coeffs, size_t numSamples);
+
+	/// Check if the transition started by start() is a crossfade
+	/// @returns true for CROSSFADE, false for INTERPOLATE
+	bool isCrossfade() const { return m_transition == Transition::CROSSFADE; }
+
+	/// Get the coefficients for the current sample. When interpolating these are the
+	/// interpolated coefficients, when crossfading these are the new coefficients.
+	const int32_t *getCoeffs() const { return m_coeffs; }
+
+	/// Get the coefficient shift to use with getCoeffs()
+	int getCoeffShift() const { return m_coeffShift; }
+
+	/// Advance the interpolated coefficients by one sample. Not used when crossfading.
+	void step();
+
+	/// Complete the interpolation by copying the exact target coefficients.
+	/// @param coeffs the filter's coefficient array to update
+	/// @param coeffShift returns the new coefficient shift
+	/// @returns the new number of stages
+	unsigned finish(int32_t *coeffs, int &coeffShift);
+
+private:
+	const unsigned NUM_STAGES;
+	int32_t *m_published[2] = {nullptr, nullptr}; ///< double buffer written by publish()
+	unsigned m_publishedStages[2] = {0, 0};
+	int      m_publishedShift[2] = {0, 0};
+	Transition m_publishedTransition[2] = {Transition::INTERPOLATE, Transition::INTERPOLATE};
+	unsigned m_writeIndex = 0;
+	std::atomic<int> m_pending; ///< index of the published buffer to pick up, or -1
+
+	int32_t *m_target = nullptr; ///< exact target coefficients
+	int32_t *m_coeffs = nullptr; ///< interpolated coefficients
+	int32_t *m_delta  = nullptr; ///< per-sample coefficient increments
+	unsigned m_numStages = 0;
+	unsigned m_targetStages = 0;
+	int m_coeffShift = 0;
+	int m_targetShift = 0;
+	Transition m_transition = Transition::INTERPOLATE;
 };
 
 /**************************************************************************//**
@@ -248,8 +891,24 @@ public:
 	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
 	void changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift = 0);
 
+	/// Change the filter coefficients while audio is running without clicks.
+	/// @details The coefficients are copied and published atomically, then the
+	/// filter transitions to them over the next processed block. Call this from
+	/// outside the audio interrupt. See IirBiQuadMorph.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients (range -1 to +0.999...)
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	/// @param transition use INTERPOLATE for sweeping a filter, CROSSFADE for switching to an unrelated one
+	/// @returns false if numStages is too large
+	bool morphFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift = 0,
+		IirBiQuadMorph::Transition transition = IirBiQuadMorph::Transition::INTERPOLATE) {
+		return m_morph.publish(numStages, coeffs, coeffShift, transition);
+	}
+
 	/// Process the data using the configured IIR filter
-	/// @details output and input can be the same pointer if in-place modification is desired
+	/// @details output and input can be the same pointer if in-place modification is desired.
+	/// The samples are widened, filtered through all stages and saturated back to 16-bit
+	/// in a single pass.
 	/// @param output pointer to where the output results will be written
 	/// @param input pointer to where the input data will be read from
     /// @param numSampmles number of samples to process
@@ -261,6 +920,8 @@ private:
 	// ARM DSP Math library filter instance
 	arm_biquad_casd_df1_inst_q31 m_iirCfg;
 	int32_t *m_state = nullptr;
+	int32_t *m_fadeState = nullptr; ///< state for the new filter during a crossfade
+	IirBiQuadMorph m_morph;
 };
 
 /**************************************************************************//**
@@ -286,9 +947,25 @@ public:
 	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
 	void changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift = 0);
 
+	/// Change the filter coefficients while audio is running without clicks.
+	/// @details The coefficients are copied and published atomically, then the
+	/// filter transitions to them over the next processed block. Call this from
+	/// outside the audio interrupt. See IirBiQuadMorph.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients (range -1 to +0.999...)
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	/// @param transition use INTERPOLATE for sweeping a filter, CROSSFADE for switching to an unrelated one
+	/// @returns false if numStages is too large
+	bool morphFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift = 0,
+		IirBiQuadMorph::Transition transition = IirBiQuadMorph::Transition::INTERPOLATE) {
+		return m_morph.publish(numStages, coeffs, coeffShift, transition);
+	}
+
     /// Process the data using the configured IIR filter
-    /// @details output and input can be the same pointer if in-place modification is desired
-    /// @param output poinvoid combine(audio_block_t *out, audio_block_t *in0, audio_block_t *in1)ter to where the output results will be written
+    /// @details output and input can be the same pointer if in-place modification is desired.
+    /// The samples are widened, filtered through all stages and saturated back to 16-bit
+    /// in a single pass.
+    /// @param output pointer to where the output results will be written
     /// @param input pointer to where the input data will be read from
     /// @param numSampmles number of samples to process
 	bool process(int16_t *output, int16_t *input, size_t numSamples);
@@ -299,12 +976,67 @@ private:
 	// ARM DSP Math library filter instance
 	arm_biquad_cas_df1_32x64_ins_q31 m_iirCfg;
 	int64_t *m_state = nullptr;
+	int64_t *m_fadeState = nullptr; ///< state for the new filter during a crossfade
+	IirBiQuadMorph m_morph;
+};
+
+/**************************************************************************//**
+ * A native Q15 version of IirBiQuadFilter. Audio samples are filtered directly
+ * with the CMSIS-DSP Q15 biquads (64-bit accumulator) without any conversion.
+ * @details Q15 coefficients require the extra zero like the Q31 ones. E.g. <br>
+ * {b10, 0, b11, b12, a11, a12, b20, 0, b21, b22, a21, a22, ...}<br>
+ * The reduced coefficient precision is not suitable for filters with very low
+ * cutoff frequencies, use IirBiQuadFilterHQ for those.
+ *****************************************************************************/
+class IirBiQuadFilterQ15 {
+public:
+	IirBiQuadFilterQ15() = delete;
+	/// Construct a Biquad filter with specified number of stages, coefficients and scaling.
+	/// @param numStages number of biquad stages. Each stage has 6 coefficients.
+	/// @param coeffs pointer to an array of Q15 fixed-point coefficients (range -1 to +0.999...)
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	IirBiQuadFilterQ15(unsigned maxNumStages, const int16_t *coeffs, int coeffShift = 0);
+
+	/// Construct a Biquad filter from the Q31 coefficients used by IirBiQuadFilter.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients, rounded to Q15
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	IirBiQuadFilterQ15(unsigned maxNumStages, const int32_t *coeffs, int coeffShift = 0);
+	virtual ~IirBiQuadFilterQ15();
+
+	/// Reconfigure the filter coefficients.
+	/// @param numStages number of biquad stages. Each stage has 6 coefficients.
+	/// @param coeffs pointer to an array of Q15 fixed-point coefficients (range -1 to +0.999...)
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	void changeFilterCoeffs(unsigned numStages, const int16_t *coeffs, int coeffShift = 0);
+
+	/// Reconfigure the filter coefficients from Q31 coefficients.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients, rounded to Q15
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	void changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift = 0);
+
+	/// Process the data using the configured IIR filter
+	/// @details output and input can be the same pointer if in-place modification is desired
+	/// @param output pointer to where the output results will be written
+	/// @param input pointer to where the input data will be read from
+	/// @param numSamples number of samples to process
+	bool process(int16_t *output, int16_t *input, size_t numSamples);
+private:
+	const unsigned NUM_STAGES;
+	int16_t *m_coeffs = nullptr;
+
+	// ARM DSP Math library filter instance
+	arm_biquad_casd_df1_inst_q15 m_iirCfg;
+	int16_t *m_state = nullptr;
 };
 
 /**************************************************************************//**
  * A single-precision floating-point biquad using CMSIS-DSP hardware instructions.
  * @details Use this when IirBiQuadFilterHQ is insufficient, since that version
- * is still faster with 64-bit fixed-point arithmetic.
+ * is still faster with 64-bit fixed-point arithmetic. The float coefficients are
+ * {b0, b1, b2, a1, a2} per stage, with the 'a' coefficients negated like the Q31
+ * ones. The Q31 presets used with IirBiQuadFilterHQ can be converted directly.
  *****************************************************************************/
 class IirBiQuadFilterFloat {
 public:
@@ -315,6 +1047,12 @@ public:
     /// @param numStages number of biquad stages. Each stage has 5 coefficients.
     /// @param coeffs pointer to an array of single-precision floating-point coefficients
 	IirBiQuadFilterFloat(unsigned maxNumStages, const float *coeffs);
+
+	/// Construct a Biquad filter from the Q31 coefficients used by IirBiQuadFilter.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	IirBiQuadFilterFloat(unsigned maxNumStages, const int32_t *coeffs, int coeffShift = 0);
 	virtual ~IirBiQuadFilterFloat();
 
 	/// Reconfigure the filter coefficients.
@@ -323,6 +1061,32 @@ public:
     /// @param coeffs pointer to an array of single-precision floating-point coefficients
 	void changeFilterCoeffs(unsigned numStages, const float *coeffs);
 
+	/// Reconfigure the filter coefficients from Q31 coefficients.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	void changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift = 0);
+
+	/// Change the filter coefficients while audio is running without clicks.
+	/// @details Works like IirBiQuadFilterHQ::morphFilterCoeffs(). The coefficients are
+	/// copied and published atomically, then the filter transitions to them over the next
+	/// processed block. Call this from outside the audio interrupt.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of single-precision floating-point coefficients
+	/// @param transition use INTERPOLATE for sweeping a filter, CROSSFADE for switching to an unrelated one
+	/// @returns false if numStages is too large
+	bool morphFilterCoeffs(unsigned numStages, const float *coeffs,
+		IirBiQuadMorph::Transition transition = IirBiQuadMorph::Transition::INTERPOLATE);
+
+	/// Change the filter coefficients to Q31 coefficients while audio is running without clicks.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	/// @param transition use INTERPOLATE for sweeping a filter, CROSSFADE for switching to an unrelated one
+	/// @returns false if numStages is too large
+	bool morphFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift = 0,
+		IirBiQuadMorph::Transition transition = IirBiQuadMorph::Transition::INTERPOLATE);
+
     /// Process the data using the configured IIR filter
     /// @details output and input can be the same pointer if in-place modification is desired
     /// @param output pointer to where the output results will be written
@@ -337,6 +1101,328 @@ private:
 	arm_biquad_cascade_df2T_instance_f32 m_iirCfg;
 	float *m_state = nullptr;
 
+	// Coefficient changes, see IirBiQuadMorph
+	float *m_published[2] = {nullptr, nullptr}; ///< double buffer written by morphFilterCoeffs()
+	unsigned m_publishedStages[2] = {0, 0};
+	IirBiQuadMorph::Transition m_publishedTransition[2] = {IirBiQuadMorph::Transition::INTERPOLATE, IirBiQuadMorph::Transition::INTERPOLATE};
+	unsigned m_writeIndex = 0;
+	std::atomic<int> m_pending;    ///< index of the published buffer to pick up, or -1
+	float *m_delta = nullptr;      ///< per-sample coefficient increments when interpolating
+	float *m_fadeState = nullptr;  ///< state for the new filter during a crossfade
+
+	float *m_publishBuffer(void);
+	void m_publish(unsigned numStages, IirBiQuadMorph::Transition transition);
+	void m_processTransition(float *output, const float *input, size_t numSamples);
+};
+
+/**************************************************************************//**
+ * A multi-channel version of IirBiQuadFilterQ15. NUM_CHANNELS (2 or 4) channels
+ * are filtered with one shared set of coefficients, so each stage's coefficients
+ * are loaded once per frame instead of once per channel.
+ * @details The coefficient and state pairs are packed so each stage is computed
+ * with two dual 16-bit multiply-accumulates per channel. Coefficients use the
+ * same format as IirBiQuadFilterQ15. The samples can be interleaved frames, e.g.
+ * {L0, R0, L1, R1, ...}, or separate buffers per channel.
+ *****************************************************************************/
+template <unsigned NUM_CHANNELS>
+class IirBiQuadFilterMultiQ15 {
+public:
+	static_assert((NUM_CHANNELS == 2) || (NUM_CHANNELS == 4), "NUM_CHANNELS must be 2 or 4");
+
+	IirBiQuadFilterMultiQ15() = delete;
+	/// Construct a Biquad filter with specified number of stages, coefficients and scaling.
+	/// @param maxNumStages number of biquad stages. Each stage has 6 coefficients.
+	/// @param coeffs pointer to an array of Q15 fixed-point coefficients (range -1 to +0.999...)
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	IirBiQuadFilterMultiQ15(unsigned maxNumStages, const int16_t *coeffs, int coeffShift = 0);
+	virtual ~IirBiQuadFilterMultiQ15();
+
+	/// Reconfigure the filter coefficients. The filter state of all channels is cleared.
+	/// @param numStages number of biquad stages. Each stage has 6 coefficients.
+	/// @param coeffs pointer to an array of Q15 fixed-point coefficients (range -1 to +0.999...)
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	void changeFilterCoeffs(unsigned numStages, const int16_t *coeffs, int coeffShift = 0);
+
+	/// Process interleaved frames of NUM_CHANNELS samples
+	/// @details output and input can be the same pointer if in-place modification is desired
+	/// @param output pointer to where the interleaved output frames will be written
+	/// @param input pointer to where the interleaved input frames will be read from
+	/// @param numFrames number of frames to process
+	bool process(int16_t *output, const int16_t *input, size_t numFrames);
+
+	/// Process separate buffers for each channel
+	/// @param outputs array of NUM_CHANNELS output pointers
+	/// @param inputs array of NUM_CHANNELS input pointers
+	/// @param numSamples number of samples per channel to process
+	bool process(int16_t * const *outputs, const int16_t * const *inputs, size_t numSamples);
+private:
+	const unsigned NUM_STAGES;
+	unsigned m_numStages = 0;
+	int m_postShift = 0;
+	int32_t *m_coeffs = nullptr; ///< per stage {b0, b1|b2, a1|a2} with the pairs packed
+	int32_t *m_state  = nullptr; ///< per stage and channel {x1|x2, y1|y2} packed
+
+	void m_process(int16_t * const *outputs, const int16_t * const *inputs, size_t stride, size_t numSamples);
+};
+
+/**************************************************************************//**
+ * A multi-channel version of IirBiQuadFilterHQ. NUM_CHANNELS (2 or 4) channels
+ * are filtered with one shared set of Q31 coefficients and 64-bit precision,
+ * so each stage's coefficients are loaded once per frame instead of once per
+ * channel.
+ * @details Coefficients use the same format as IirBiQuadFilterHQ. The samples
+ * can be interleaved frames, e.g. {L0, R0, L1, R1, ...}, or separate buffers
+ * per channel.
+ *****************************************************************************/
+template <unsigned NUM_CHANNELS>
+class IirBiQuadFilterMultiHQ {
+public:
+	static_assert((NUM_CHANNELS == 2) || (NUM_CHANNELS == 4), "NUM_CHANNELS must be 2 or 4");
+
+	IirBiQuadFilterMultiHQ() = delete;
+	/// Construct a Biquad filter with specified number of stages, coefficients and scaling.
+	/// @param maxNumStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients (range -1 to +0.999...)
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	IirBiQuadFilterMultiHQ(unsigned maxNumStages, const int32_t *coeffs, int coeffShift = 0);
+	virtual ~IirBiQuadFilterMultiHQ();
+
+	/// Reconfigure the filter coefficients. The filter state of all channels is cleared.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of Q31 fixed-point coefficients (range -1 to +0.999...)
+	/// @param coeffShift coeffs are multiplied by 2^coeffShift to support coefficient range scaling
+	void changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift = 0);
+
+	/// Process interleaved frames of NUM_CHANNELS samples
+	/// @details output and input can be the same pointer if in-place modification is desired
+	/// @param output pointer to where the interleaved output frames will be written
+	/// @param input pointer to where the interleaved input frames will be read from
+	/// @param numFrames number of frames to process
+	bool process(int16_t *output, const int16_t *input, size_t numFrames);
+
+	/// Process separate buffers for each channel
+	/// @param outputs array of NUM_CHANNELS output pointers
+	/// @param inputs array of NUM_CHANNELS input pointers
+	/// @param numSamples number of samples per channel to process
+	bool process(int16_t * const *outputs, const int16_t * const *inputs, size_t numSamples);
+private:
+	const unsigned NUM_STAGES;
+	unsigned m_numStages = 0;
+	int m_postShift = 0;
+	int32_t *m_coeffs = nullptr;
+	int32_t *m_xState = nullptr; ///< per stage and channel {x1, x2}
+	int64_t *m_yState = nullptr; ///< per stage and channel {y1, y2} in 1.63 format
+
+	void m_process(int16_t * const *outputs, const int16_t * const *inputs, size_t stride, size_t numSamples);
+};
+
+/**************************************************************************//**
+ * A multi-channel version of IirBiQuadFilterFloat. NUM_CHANNELS (2 or 4) channels
+ * are filtered with one shared set of coefficients using Direct Form II Transposed.
+ * @details The Cortex-M FPUs have no vector lanes so the channels are processed
+ * together in the inner loop while each stage's coefficients are held in registers.
+ * Coefficients use the same format as IirBiQuadFilterFloat.
+ *****************************************************************************/
+template <unsigned NUM_CHANNELS>
+class IirBiQuadFilterMultiFloat {
+public:
+	static_assert((NUM_CHANNELS == 2) || (NUM_CHANNELS == 4), "NUM_CHANNELS must be 2 or 4");
+
+	IirBiQuadFilterMultiFloat() = delete;
+	/// Construct a Biquad filter with specified number of stages and coefficients
+	/// @param maxNumStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of single-precision floating-point coefficients
+	IirBiQuadFilterMultiFloat(unsigned maxNumStages, const float *coeffs);
+	virtual ~IirBiQuadFilterMultiFloat();
+
+	/// Reconfigure the filter coefficients. The filter state of all channels is cleared.
+	/// @param numStages number of biquad stages. Each stage has 5 coefficients.
+	/// @param coeffs pointer to an array of single-precision floating-point coefficients
+	void changeFilterCoeffs(unsigned numStages, const float *coeffs);
+
+	/// Process interleaved frames of NUM_CHANNELS samples
+	/// @details output and input can be the same pointer if in-place modification is desired
+	/// @param output pointer to where the interleaved output frames will be written
+	/// @param input pointer to where the interleaved input frames will be read from
+	/// @param numFrames number of frames to process
+	bool process(float *output, const float *input, size_t numFrames);
+
+	/// Process separate buffers for each channel
+	/// @param outputs array of NUM_CHANNELS output pointers
+	/// @param inputs array of NUM_CHANNELS input pointers
+	/// @param numSamples number of samples per channel to process
+	bool process(float * const *outputs, const float * const *inputs, size_t numSamples);
+private:
+	const unsigned NUM_STAGES;
+	unsigned m_numStages = 0;
+	float *m_coeffs = nullptr;
+	float *m_state  = nullptr; ///< per stage and channel {d1, d2}
+
+	void m_process(float * const *outputs, const float * const *inputs, size_t stride, size_t numSamples);
+};
+
+/**************************************************************************//**
+ * UniformConvolution convolves audio with an impulse response such as a speaker
+ * cabinet using uniformly partitioned overlap-save.
+ * @details The impulse response is split into partitions of AUDIO_BLOCK_SAMPLES
+ * and the spectrum of each partition is computed with a CMSIS real FFT when it is
+ * loaded. Each block of audio then costs one forward FFT, a complex multiply
+ * accumulate per partition against the spectra of the previous input blocks and one
+ * inverse FFT. There is no latency beyond the audio block. All memory is allocated
+ * by the constructor.
+ *****************************************************************************/
+class UniformConvolution {
+public:
+	static constexpr size_t PARTITION_SAMPLES = AUDIO_BLOCK_SAMPLES; ///< samples per partition
+	static constexpr size_t FFT_SIZE = 2*PARTITION_SAMPLES;          ///< real FFT length
+
+	UniformConvolution() = delete;
+	/// Construct a convolution for impulse responses up to maxSamples long
+	/// @param maxSamples the length of the longest impulse response that will be loaded
+	UniformConvolution(size_t maxSamples);
+	virtual ~UniformConvolution();
+
+	/// Load an impulse response and compute the spectra of its partitions.
+	/// @details Call this from outside the audio interrupt. The output is silent
+	/// until the load finishes. Samples beyond the maximum length are ignored.
+	/// @param ir pointer to the impulse response where full scale is +/-1.0
+	/// @param numSamples number of samples in the impulse response
+	/// @param gain scales the impulse response
+	/// @returns false if the impulse response is empty
+	bool setImpulseResponse(const float *ir, size_t numSamples, float gain = 1.0f);
+
+	/// Load a Q15 impulse response, e.g. converted from a WAV file.
+	/// @param ir pointer to the Q15 impulse response
+	/// @param numSamples number of samples in the impulse response
+	/// @param gain scales the impulse response
+	/// @returns false if the impulse response is empty
+	bool setImpulseResponse(const int16_t *ir, size_t numSamples, float gain = 1.0f);
+
+	/// Clear the audio history, e.g. after the input was muted
+	void reset();
+
+	/// Convolve a block of PARTITION_SAMPLES
+	/// @details output and input can be the same pointer if in-place modification is desired
+	/// @param output pointer to where the output samples will be written
+	/// @param input pointer to where the input samples will be read from
+	void process(float *output, const float *input);
+
+	/// Get the number of partitions in the loaded impulse response
+	/// @returns the number of partitions, 0 when nothing is loaded
+	size_t getNumPartitions() const { return m_numPartitions; }
+
+	/// Get the longest impulse response that can be loaded
+	/// @returns the maximum length in samples
+	size_t getMaxSamples() const { return m_maxPartitions * PARTITION_SAMPLES; }
+
+private:
+	arm_rfft_fast_instance_f32 m_fftInstance;
+	size_t m_maxPartitions;
+	std::atomic<size_t> m_numPartitions; ///< 0 while an impulse response is loading
+	float *m_irSpectra    = nullptr; ///< spectrum of each partition of the impulse response
+	float *m_inputSpectra = nullptr; ///< ring of the spectra of the most recent input frames
+	size_t m_newestInput  = 0;       ///< index of the newest spectrum in m_inputSpectra
+	float *m_frame        = nullptr; ///< the previous and current input blocks
+	float *m_accumulator  = nullptr; ///< sum of the partition products
+
+	bool m_loadPartitions(const float *ir, const int16_t *irQ15, size_t numSamples, float gain);
+};
+
+/**************************************************************************//**
+ * NonUniformConvolution convolves audio with a long impulse response such as a
+ * room reverb. The late part of the impulse response is kept in external memory.
+ * @details The impulse response is split into two levels of partitions:<br>
+ * The head, the first 2*tailPartitionSamples, uses a UniformConvolution in internal
+ * memory so there is no latency.<br>
+ * The tail uses partitions of tailPartitionSamples. Their spectra are stored in the
+ * ExtMemSlot as 16-bit block floating point and are streamed in, SLICE_WORDS each
+ * audio block, with DMA reads that run while the previous slice is multiplied. A
+ * tail period is tailPartitionSamples long. The input frame is transformed in its
+ * first block, the slices are accumulated over the following blocks and the inverse
+ * transform is done in its last block, so the tail output is ready exactly when the
+ * head runs out.<br>
+ * LIMITATIONS: this is not a multi-second reverb. The tail is limited to
+ * MAX_TAIL_PARTITIONS by the SPI bandwidth, one slice per block already uses more
+ * than half of the 20 MHz bus. The longest impulse response is 9*tailPartitionSamples,
+ * while the internal memory grows with the partition size:
+ * <table>
+ * <tr><th>tailPartitionSamples</th><th>longest IR</th><th>internal memory</th><th>slot memory</th></tr>
+ * <tr><td>2048 (default)</td><td>18432 samples, 0.4 s</td><td>180 KB</td><td>56 KB</td></tr>
+ * <tr><td>4096</td><td>36864 samples, 0.8 s</td><td>370 KB</td><td>112 KB</td></tr>
+ * <tr><td>8192</td><td>73728 samples, 1.7 s</td><td>740 KB</td><td>224 KB</td></tr>
+ * </table>
+ * Longer impulse responses need more partition levels with the input spectra also
+ * kept in external memory, which is not implemented.
+ *****************************************************************************/
+class NonUniformConvolution {
+public:
+	static constexpr size_t SLICE_WORDS = 2048;       ///< 16-bit words streamed from the slot each audio block
+	static constexpr size_t MAX_TAIL_PARTITIONS = 7;  ///< tail partitions that can be streamed in a tail period
+
+	NonUniformConvolution() = delete;
+	/// Construct a convolution that keeps the tail in external memory
+	/// @param slot the external memory for the tail partitions. A DMA slot is recommended.
+	/// @param tailPartitionSamples the size of the tail partitions, a power of two from 1024
+	NonUniformConvolution(ExtMemSlot *slot, size_t tailPartitionSamples = 2048);
+	virtual ~NonUniformConvolution();
+
+	/// Load an impulse response, the head is transformed into internal memory and the
+	/// tail is transformed and written to the slot.
+	/// @details Call this from outside the audio interrupt, after the memory has been
+	/// allocated to the slot. The tail is silent until the load finishes.
+	/// @param ir pointer to the impulse response where full scale is +/-1.0
+	/// @param numSamples number of samples in the impulse response, extra samples past getMaxSamples() are ignored
+	/// @param gain scales the impulse response
+	/// @returns false if the impulse response is empty
+	bool setImpulseResponse(const float *ir, size_t numSamples, float gain = 1.0f);
+
+	/// Load a Q15 impulse response, e.g. converted from a WAV file.
+	/// @param ir pointer to the Q15 impulse response
+	/// @param numSamples number of samples in the impulse response, extra samples past getMaxSamples() are ignored
+	/// @param gain scales the impulse response
+	/// @returns false if the impulse response is empty
+	bool setImpulseResponse(const int16_t *ir, size_t numSamples, float gain = 1.0f);
+
+	/// Convolve a block of AUDIO_BLOCK_SAMPLES
+	/// @details output and input can be the same pointer if in-place modification is desired
+	/// @param output pointer to where the output samples will be written
+	/// @param input pointer to where the input samples will be read from
+	void process(float *output, const float *input);
+
+	/// Get the longest impulse response that can be loaded. This depends on the size of
+	/// the slot so check it after the memory has been allocated.
+	/// @returns the maximum length in samples
+	size_t getMaxSamples() const;
+
+private:
+	ExtMemSlot *m_slot;
+	UniformConvolution *m_head = nullptr;
+	const size_t m_partitionSamples;  ///< samples per tail partition, M
+	const size_t m_spectrumWords;     ///< words in a tail spectrum, 2*M
+	const unsigned m_periodBlocks;    ///< audio blocks per tail period
+	arm_rfft_fast_instance_f32 m_fftInstance;
+
+	std::atomic<bool> m_loading;           ///< set while setImpulseResponse() writes the slot
+	std::atomic<size_t> m_tailPartitions;  ///< partitions in the loaded tail
+	float m_tailScales[MAX_TAIL_PARTITIONS] = {}; ///< block floating point scale of each tail spectrum
+
+	// Tail period state, only used by the audio interrupt
+	unsigned m_block = 0;             ///< audio block within the tail period
+	size_t m_framePartitions = 0;     ///< tail partitions used in this period, 0 when invalid
+	float *m_frame = nullptr;         ///< the previous and current input frames
+	float *m_work = nullptr;          ///< FFT input
+	float *m_accumulator = nullptr;   ///< sum of the partition products
+	float *m_tailOutput = nullptr;    ///< tail output played during the next period
+	int16_t *m_inputSpectra = nullptr;       ///< ring of the input spectra in block floating point
+	float m_inputScales[MAX_TAIL_PARTITIONS] = {};
+	unsigned m_newestInput = 0;
+	int16_t *m_slices[2] = {nullptr, nullptr}; ///< double buffered slice reads
+
+	bool m_loadPartitions(const float *ir, const int16_t *irQ15, size_t numSamples, float gain);
+	void m_startPeriod();
+	void m_requestSlice(unsigned slice);
+	void m_accumulateSlice(unsigned slice);
+	void m_finishPeriod();
 };
 
 } // namespace BALibrary
@@ -373,6 +1459,17 @@ public:
     void reconfigure(T startValue, T endValue, size_t durationSamples,     Function function = Function::LINEAR);
     void reconfigure(T startValue, T endValue, float durationMilliseconds, Function function = Function::LINEAR);
 
+    /// set the start and end values for the automation using a LOOKUP_TABLE curve
+    /// @details the table is not copied and must remain valid, e.g. a const array in flash.
+    /// @param startValue after reset, parameter automation start from this value
+    /// @param endValue after the automation duration, paramter will finish at this value
+    /// @param durationSamples number of samples to transition from startValue to endValue
+    /// @param table array of curve values evenly spaced from x=0 to x=1. 0.0 corresponds to
+    /// startValue and 1.0 to endValue, values in between are linearly interpolated.
+    /// @param tableSize number of values in the table, must be at least 2
+    void reconfigure(T startValue, T endValue, size_t durationSamples,     const float *table, size_t tableSize);
+    void reconfigure(T startValue, T endValue, float durationMilliseconds, const float *table, size_t tableSize);
+
     /// Start the automation from startValue
     void trigger();
 
@@ -380,6 +1477,12 @@ public:
     /// @returns the calculated parameter value of templated type T
     T getNextValue();
 
+    /// Retrieve the automation values for each sample in the next audio block. This
+    /// advances the automation by one block, the same as getNextValue(), and the last
+    /// value is the one getNextValue() would have returned.
+    /// @param values array of AUDIO_BLOCK_SAMPLES to store the calculated parameter values
+    void getNextVector(T *values);
+
     bool isFinished() { return !m_running; }
 
 private:
@@ -393,6 +1496,13 @@ private:
     float m_slopeX;
     float m_scaleY;
     bool m_positiveSlope = true;
+    float m_expValue;        ///< the exponential term at m_currentValueX, updated by multiplication
+    float m_expBlockRatio;   ///< change in the exponential term over one block
+    float m_expSampleRatio;  ///< change in the exponential term over one sample
+    const float *m_table = nullptr; ///< the curve for LOOKUP_TABLE
+    size_t m_tableSize = 0;         ///< number of values in m_table
+    T m_scaleValue(float value) const; ///< convert a curve value between 0.0 and 1.0 to the parameter range
+    float m_lookup(float x) const;     ///< interpolate the LOOKUP_TABLE curve
 };
 
 
@@ -409,14 +1519,26 @@ public:
 
     void setupParameter(int index, T startValue, T endValue, size_t durationSamples,     typename ParameterAutomation<T>::Function function);
     void setupParameter(int index, T startValue, T endValue, float durationMilliseconds, typename ParameterAutomation<T>::Function function);
+    /// Setup a stage to follow a LOOKUP_TABLE curve, see ParameterAutomation::reconfigure()
+    void setupParameter(int index, T startValue, T endValue, size_t durationSamples,     const float *table, size_t tableSize);
+    void setupParameter(int index, T startValue, T endValue, float durationMilliseconds, const float *table, size_t tableSize);
 
     /// Trigger a the automation sequence until numStages is reached or a Function is ParameterAutomation<T>::Function::NOT_CONFIGURED
     void trigger();
 
     T getNextValue();
+
+    /// Retrieve the automation values for each sample in the next audio block.
+    /// @details Stages change on block boundaries, if a stage finishes part way through the
+    /// block the remaining values hold its end value and the next stage starts on the
+    /// next block.
+    /// @param values array of AUDIO_BLOCK_SAMPLES to store the calculated parameter values
+    void getNextVector(T *values);
+
     bool isFinished();
 
 private:
+    void m_checkStageFinished(); ///< called internally to move to the next stage
     ParameterAutomation<T> *m_paramArray[MAX_PARAMETER_SEQUENCES];
     int m_currentIndex = 0;
     int m_numStages = 0;
@@ -429,7 +1551,7 @@ enum class Waveform : unsigned {
 	TRIANGLE, ///< triangle wave
 	SQUARE,   ///< square wave
 	SAWTOOTH, ///< sawtooth wave
-	RANDOM,   ///< a non-repeating random waveform
+	RANDOM,   ///< a non-repeating, smoothly varying random waveform
 	NUM_WAVEFORMS, ///< the number of defined waveforms
 };
 
@@ -438,19 +1560,26 @@ enum class Waveform : unsigned {
  * The LFO is commonly used on modulation effects where some parameter (delay,
  * volume, etc.) is modulated via  waveform at a frequency below 20 Hz. Waveforms
  * vary between -1.0f and +1.0f.
- * @details this LFO is for operating on vectors of audio block samples.
+ * @details this LFO is for operating on vectors of audio block samples. The phase
+ * is a 32-bit fixed-point accumulator and the sine is read from an interpolated
+ * wavetable. LowFrequencyOscillatorVector<float> outputs floats between -1.0f and
+ * +1.0f, LowFrequencyOscillatorVector<int16_t> outputs Q15 values between -32767
+ * and +32767 and skips the float conversion.<br>
+ * The rate may be changed from another thread (e.g. MIDI or a control loop) while
+ * the audio interrupt is calling getNextVector(), no locking is required and the
+ * phase stays continuous.
  *****************************************************************************/
 template <class T>
 class LowFrequencyOscillatorVector {
 public:
 	/// Default constructor, uses SINE as default waveform
-	LowFrequencyOscillatorVector() {}
+	LowFrequencyOscillatorVector() { m_initRandom(); }
 
 	/// Specifies the desired waveform at construction time.
 	/// @param waveform specifies desired waveform
-	LowFrequencyOscillatorVector(Waveform waveform) : m_waveform(waveform) {};
-	/// Default destructor
-    ~LowFrequencyOscillatorVector() {}
+	LowFrequencyOscillatorVector(Waveform waveform) : m_waveform(waveform) { m_initRandom(); }
+	/// Destructor
+	~LowFrequencyOscillatorVector();
 
     /// Change the waveform
 	/// @param waveform specifies desired waveform
@@ -465,24 +1594,42 @@ public:
 	void setRateRatio(float ratio);
 
 	/// Get the next waveform value
-	/// @returns the next vector of phase values
+	/// @returns the next vector of waveform values
 	T *getNextVector();
 
+	/// Configure several phase-locked outputs from this oscillator. E.g. {0.0f, 180.0f}
+	/// for a stereo tremolo or {0.0f, 90.0f} for a quadrature chorus.
+	/// @details This allocates memory so it should be called during setup, not while
+	/// another thread is calling getNextVectors(). getNextVector() is unaffected.
+	/// @param numPhases the number of outputs
+	/// @param phaseOffsetsDegrees array of numPhases phase offsets in degrees, added to the oscillator phase
+	/// @returns true on success
+	bool setPhaseOffsets(unsigned numPhases, const float *phaseOffsetsDegrees);
+
+	/// Get the number of outputs configured with setPhaseOffsets()
+	/// @returns the number of phase offsets
+	unsigned getNumPhases() const { return m_numPhases; }
+
+	/// Get the next waveform value for every phase offset. All outputs are computed
+	/// from the same phase accumulator in a single pass.
+	/// @returns an array of getNumPhases() vectors in the same order as the offsets, or
+	/// nullptr if setPhaseOffsets() has not been called.
+	T * const *getNextVectors();
+
 private:
-	void m_updatePhase(); ///< called internally when updating the phase vector
-	void m_initPhase(T radiansPerSample); ///< called internally to reset phase upon rate change
+	void m_generate(T * const *dests, const uint32_t *offsets, unsigned numOutputs); ///< called internally to compute the next block of values
+	int16_t m_nextRandom(); ///< called internally to get the next random level
+	void m_initRandom(); ///< called internally to seed the RANDOM waveform levels
 	Waveform m_waveform = Waveform::SINE; ///< LFO waveform
-	T m_phaseVec[AUDIO_BLOCK_SAMPLES]; ///< the vector of next phase values
-	T m_radiansPerBlock = 0.0f; ///< stores the change in radians over one block of data
+	uint32_t m_phase = 0; ///< the phase of the next output sample, 2^32 is one full cycle
+	std::atomic<uint32_t> m_phaseIncrement{0}; ///< the change in phase per sample
+	uint32_t m_randomState = 0x12345678; ///< PRNG state for the RANDOM waveform
+	int16_t m_randomLevels[3]; ///< RANDOM waveform levels at the start of the current, next and following cycles
 	T m_outputVec[AUDIO_BLOCK_SAMPLES]; ///< stores the output LFO values
-	std::atomic_flag m_phaseLock = ATOMIC_FLAG_INIT; ///< used for thread-safety on m_phaseVec
-	const T PI_F = 3.14159265358979323846264338327950288419716939937510582097494459230781640628620899; ///< 2*PI
-	const T TWO_PI_F = 2.0 *  3.14159265358979323846264338327950288419716939937510582097494459230781640628620899; ///< 2*PI
-	const T PI_DIV2_F = 0.5 *  3.14159265358979323846264338327950288419716939937510582097494459230781640628620899; ///< PI/2
-	const T THREE_PI_DIV2_F = 1.5 *  3.14159265358979323846264338327950288419716939937510582097494459230781640628620899; ///< 3*PI/2
-    const T TRIANGE_POS_SLOPE = 2.0f/PI_F;
-    const T TRIANGE_NEG_SLOPE = -2.0f/PI_F;
-    const T SAWTOOTH_SLOPE = -1.0f/PI_F;
+	unsigned  m_numPhases = 0;            ///< number of outputs configured with setPhaseOffsets()
+	uint32_t *m_phaseOffsets = nullptr;   ///< phase offset of each output
+	T        *m_phaseOutputs = nullptr;   ///< output values for each offset, one block each
+	T       **m_phaseVectors = nullptr;   ///< pointer to each output block
 };
 
 } // BALibrary
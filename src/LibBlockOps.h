@@ -0,0 +1,214 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  LibBlockOps provides fused arithmetic on blocks of Q15 audio samples. A chain
+ *  of scale, mix, add and saturate operations is described as an expression and
+ *  then evaluated in a single pass over the samples. No temporary blocks are
+ *  needed and each sample is loaded and stored only once.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BALIBRARY_LIBBLOCKOPS_H
+#define __BALIBRARY_LIBBLOCKOPS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Audio.h"
+#include "LibSimd.h"
+
+namespace BALibrary {
+
+/// Fused block operations. Build an expression from the functions below then write
+/// it out with evaluate(). E.g. the alphaBlend() followed by gainAdjust() is<br>
+/// blockOps::evaluate(out, blockOps::scale(blockOps::mix(dry, wet, mix), volume));
+/// @details Intermediate results are 32-bit and are only saturated to 16 bits when
+/// stored, or where saturate() is used. Each scale() expects its operand to be within
+/// the 17-bit range (e.g. the sum of two blocks), wrap larger sums in saturate() first.
+namespace blockOps {
+
+using simd::saturate16;
+
+/// Convert a float gain between -1.0 and +1.0 to Q15, the same as gainAdjust()
+inline int16_t toQ15Gain(float gain) { return static_cast<int16_t>(gain * 32767.0f); }
+
+/// Base class for all block expressions. Expressions are small and are held by value
+/// so temporaries can be safely chained.
+template <class Derived>
+struct BlockExpr {
+	const Derived &derived() const { return static_cast<const Derived &>(*this); }
+};
+
+/// An array of samples used as an expression operand
+class BlockSource : public BlockExpr<BlockSource> {
+public:
+	explicit BlockSource(const int16_t *data) : m_data(data) {}
+	int32_t operator[](size_t index) const { return m_data[index]; }
+private:
+	const int16_t *m_data;
+};
+
+/// expr * (gain * 2^coeffShift), with the same truncation as arm_scale_q15()
+template <class E>
+class BlockScale : public BlockExpr<BlockScale<E>> {
+public:
+	BlockScale(const E &expr, int16_t gain, int coeffShift) : m_expr(expr), m_gain(gain), m_shift(15 - coeffShift) {}
+	int32_t operator[](size_t index) const { return (m_expr[index] * m_gain) >> m_shift; }
+private:
+	const E m_expr;
+	const int32_t m_gain;
+	const int m_shift;
+};
+
+/// expr * gains, a separate Q15 gain for every sample
+template <class E>
+class BlockModulate : public BlockExpr<BlockModulate<E>> {
+public:
+	BlockModulate(const E &expr, const int16_t *gains) : m_expr(expr), m_gains(gains) {}
+	int32_t operator[](size_t index) const { return (m_expr[index] * m_gains[index]) >> 15; }
+private:
+	const E m_expr;
+	const int16_t *m_gains;
+};
+
+/// a + b
+template <class A, class B>
+class BlockAdd : public BlockExpr<BlockAdd<A, B>> {
+public:
+	BlockAdd(const A &a, const B &b) : m_a(a), m_b(b) {}
+	int32_t operator[](size_t index) const { return m_a[index] + m_b[index]; }
+private:
+	const A m_a;
+	const B m_b;
+};
+
+/// expr clamped to the Q15 range
+template <class E>
+class BlockSaturate : public BlockExpr<BlockSaturate<E>> {
+public:
+	explicit BlockSaturate(const E &expr) : m_expr(expr) {}
+	int32_t operator[](size_t index) const { return saturate16(m_expr[index]); }
+private:
+	const E m_expr;
+};
+
+/// Use an audio block as an operand
+inline BlockSource source(const audio_block_t *block) { return BlockSource(block->data); }
+
+/// Use an array of samples as an operand
+inline BlockSource source(const int16_t *data) { return BlockSource(data); }
+
+/// Scale an expression by a Q15 gain.
+/// @param expr the expression to scale
+/// @param gain the Q15 gain
+/// @param coeffShift number of bits to shift the gain
+template <class E>
+BlockScale<E> scale(const BlockExpr<E> &expr, int16_t gain, int coeffShift = 0)
+{
+	return BlockScale<E>(expr.derived(), gain, coeffShift);
+}
+
+/// Scale an expression by a float gain, see gainAdjust().
+/// @param expr the expression to scale
+/// @param gain volume coefficient between -1.0 and +1.0
+/// @param coeffShift number of bits to shift the gain
+template <class E>
+BlockScale<E> scale(const BlockExpr<E> &expr, float gain, int coeffShift = 0)
+{
+	return BlockScale<E>(expr.derived(), toQ15Gain(gain), coeffShift);
+}
+
+/// Scale an audio block by a float gain, see gainAdjust().
+inline BlockScale<BlockSource> scale(const audio_block_t *block, float gain, int coeffShift = 0)
+{
+	return scale(source(block), gain, coeffShift);
+}
+
+/// Scale an expression by a vector of Q15 gains, e.g. from an LFO or automation.
+/// @param expr the expression to scale
+/// @param gains pointer to one Q15 gain per sample
+template <class E>
+BlockModulate<E> scale(const BlockExpr<E> &expr, const int16_t *gains)
+{
+	return BlockModulate<E>(expr.derived(), gains);
+}
+
+/// Scale an audio block by a vector of Q15 gains.
+inline BlockModulate<BlockSource> scale(const audio_block_t *block, const int16_t *gains)
+{
+	return scale(source(block), gains);
+}
+
+/// Add two expressions
+template <class A, class B>
+BlockAdd<A, B> operator+(const BlockExpr<A> &a, const BlockExpr<B> &b)
+{
+	return BlockAdd<A, B>(a.derived(), b.derived());
+}
+
+/// Saturate an intermediate result to the Q15 range
+template <class E>
+BlockSaturate<E> saturate(const BlockExpr<E> &expr)
+{
+	return BlockSaturate<E>(expr.derived());
+}
+
+/// Alpha blend two expressions, dry*(1-mix) + wet*(mix), see alphaBlend().
+/// @param dry the dry expression
+/// @param wet the wet expression
+/// @param mix float between 0.0 and 1.0.
+template <class D, class W>
+BlockAdd<BlockScale<D>, BlockScale<W>> mix(const BlockExpr<D> &dry, const BlockExpr<W> &wet, float mix)
+{
+	const int16_t scaleFractWet = toQ15Gain(mix);
+	const int16_t scaleFractDry = 32767 - scaleFractWet;
+	return scale(dry, scaleFractDry) + scale(wet, scaleFractWet);
+}
+
+/// Alpha blend two audio blocks, dry*(1-mix) + wet*(mix), see alphaBlend().
+inline BlockAdd<BlockScale<BlockSource>, BlockScale<BlockSource>>
+mix(const audio_block_t *dry, const audio_block_t *wet, float mix)
+{
+	return blockOps::mix(source(dry), source(wet), mix);
+}
+
+/// Evaluate an expression in a single pass, saturating the results to Q15.
+/// @details the destination may be one of the expression's sources.
+/// @param dest pointer to the destination samples
+/// @param expr the expression to evaluate
+/// @param numSamples number of samples to evaluate
+template <class E>
+void evaluate(int16_t *dest, const BlockExpr<E> &expr, size_t numSamples = AUDIO_BLOCK_SAMPLES)
+{
+	const E &e = expr.derived();
+	for (size_t i=0; i < numSamples; i++) {
+		dest[i] = saturate16(e[i]);
+	}
+}
+
+/// Evaluate an expression into an audio block in a single pass, saturating the results to Q15.
+template <class E>
+void evaluate(audio_block_t *dest, const BlockExpr<E> &expr)
+{
+	evaluate(dest->data, expr, AUDIO_BLOCK_SAMPLES);
+}
+
+} // namespace blockOps
+
+} // namespace BALibrary
+
+#endif /* __BALIBRARY_LIBBLOCKOPS_H */
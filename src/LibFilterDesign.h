@@ -0,0 +1,377 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  LibFilterDesign contains constexpr functions for designing cascaded
+ *  second-order-section (SOS) IIR filters from analog parameters and quantizing
+ *  them to the Q31 format used by IirBiQuadFilter and IirBiQuadFilterHQ. All
+ *  of the math is evaluated by the compiler so the resulting tables cost
+ *  nothing at runtime and are stored in flash like hand-written tables.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BALIBRARY_LIBFILTERDESIGN_H
+#define __BALIBRARY_LIBFILTERDESIGN_H
+
+#include <cstdint>
+#include <AudioStream.h>
+
+namespace BALibrary {
+
+/// The standard libary math functions are not constexpr, these replacements are only
+/// intended for compile-time use.
+namespace constexprMath {
+
+constexpr double PI_DOUBLE  = 3.14159265358979323846;
+constexpr double LN2 = 0.69314718055994530942;
+constexpr double LN10 = 2.30258509299404568402;
+
+constexpr double fabs(double x) { return (x < 0.0) ? -x : x; }
+
+constexpr double roundNearest(double x) { return (x < 0.0) ? -static_cast<double>(static_cast<int64_t>(-x + 0.5)) : static_cast<double>(static_cast<int64_t>(x + 0.5)); }
+
+constexpr double sqrt(double x)
+{
+	if (x <= 0.0) { return 0.0; }
+	double result = (x > 1.0) ? x : 1.0;
+	for (unsigned i=0; i<200; i++) {
+		const double next = 0.5 * (result + x/result);
+		if (next == result) { break; }
+		result = next;
+	}
+	return result;
+}
+
+constexpr double exp(double x)
+{
+	// reduce the argument by halving, then square the Taylor series result back up
+	unsigned halvings = 0;
+	while (fabs(x) > 0.5) { x *= 0.5; halvings++; }
+	double term = 1.0, result = 1.0;
+	for (unsigned n=1; n<30; n++) {
+		term *= x / n;
+		result += term;
+	}
+	for (unsigned i=0; i<halvings; i++) { result *= result; }
+	return result;
+}
+
+constexpr double log(double x)
+{
+	if (x <= 0.0) { return 0.0; }
+	// x = m * 2^e with m in [1,2), then log(m) = 2*atanh((m-1)/(m+1))
+	int e = 0;
+	while (x >= 2.0) { x *= 0.5; e++; }
+	while (x < 1.0)  { x *= 2.0; e--; }
+	const double y = (x - 1.0) / (x + 1.0);
+	const double y2 = y * y;
+	double term = y, result = 0.0;
+	for (unsigned n=1; n<60; n+=2) {
+		result += term / n;
+		term *= y2;
+	}
+	return 2.0*result + e*LN2;
+}
+
+constexpr double pow10(double x) { return exp(x * LN10); }
+
+constexpr double sin(double x)
+{
+	// reduce to [-pi, pi]
+	const double turns = roundNearest(x / (2.0*PI_DOUBLE));
+	x -= turns * 2.0 * PI_DOUBLE;
+	double term = x, result = x;
+	for (unsigned n=1; n<30; n++) {
+		term *= -x * x / ((2*n) * (2*n+1));
+		result += term;
+	}
+	return result;
+}
+
+constexpr double cos(double x) { return sin(x + PI_DOUBLE/2.0); }
+constexpr double tan(double x) { return sin(x) / cos(x); }
+constexpr double sinh(double x) { return 0.5 * (exp(x) - exp(-x)); }
+constexpr double cosh(double x) { return 0.5 * (exp(x) + exp(-x)); }
+constexpr double asinh(double x) { return (x < 0.0) ? -log(-x + sqrt(x*x + 1.0)) : log(x + sqrt(x*x + 1.0)); }
+
+/// Minimal constexpr complex number
+struct Complex {
+	double re = 0.0;
+	double im = 0.0;
+	constexpr Complex() = default;
+	constexpr Complex(double real, double imag) : re(real), im(imag) {}
+	constexpr Complex operator+(const Complex &rhs) const { return Complex(re + rhs.re, im + rhs.im); }
+	constexpr Complex operator-(const Complex &rhs) const { return Complex(re - rhs.re, im - rhs.im); }
+	constexpr Complex operator*(const Complex &rhs) const { return Complex(re*rhs.re - im*rhs.im, re*rhs.im + im*rhs.re); }
+	constexpr Complex operator*(double rhs) const { return Complex(re*rhs, im*rhs); }
+	constexpr Complex operator/(const Complex &rhs) const {
+		const double den = rhs.re*rhs.re + rhs.im*rhs.im;
+		return Complex((re*rhs.re + im*rhs.im)/den, (im*rhs.re - re*rhs.im)/den);
+	}
+	constexpr double norm() const { return re*re + im*im; }
+};
+
+} // namespace constexprMath
+
+/// Number of Q31 coefficients per stage, {b0, b1, b2, a1, a2}
+constexpr unsigned SOS_COEFFS_PER_STAGE = 5;
+
+/// Analog prototypes supported by designSos()
+enum class SosPrototype : unsigned {
+	BUTTERWORTH = 0, ///< maximally flat, param is unused
+	CHEBYSHEV1,      ///< equiripple passband, param is the passband ripple in dB
+	CHEBYSHEV2       ///< equiripple stopband, param is the stopband attenuation in dB, fc is the stopband edge
+};
+
+/// A 2nd-order analog lowpass section H(s) = w0^2 / (s^2 + (w0/Q)s + w0^2)
+struct AnalogSection {
+	double f0; ///< natural frequency in Hz
+	double q;  ///< section Q, 0.7071 is a Butterworth section
+};
+
+/**************************************************************************//**
+ * A cascade of digital second order sections in double-precision. Each stage
+ * is H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2), i.e. the 'a'
+ * coefficients are NOT negated yet.
+ *****************************************************************************/
+template <unsigned NUM_STAGES>
+struct SosDesign {
+	double b[NUM_STAGES][3] = {};
+	double a[NUM_STAGES][2] = {};
+};
+
+/**************************************************************************//**
+ * A cascade of second order sections quantized to Q31 in the layout used by
+ * AudioEffectAnalogDelay::setFilterCoeffs(), IirBiQuadFilter and IirBiQuadFilterHQ.
+ * The 'a' coefficients are negated as required by CMSIS-DSP.
+ *****************************************************************************/
+template <unsigned NUM_STAGES>
+struct SosQ31 {
+	int32_t  coeffs[SOS_COEFFS_PER_STAGE*NUM_STAGES] = {}; ///< {b0, b1, b2, a1, a2} per stage
+	unsigned numStages = NUM_STAGES; ///< number of stages
+	int      coeffShift = 0;         ///< coefficients are multiplied by 2^coeffShift
+};
+
+/// Design a lowpass or highpass filter of order 2*NUM_STAGES from an analog prototype using
+/// the bilinear transform with frequency prewarping.
+/// @details The stages are ordered from highest Q to lowest Q and the overall gain is applied
+/// to the last stage. This matches the stage ordering Matlab/Octave tf2sos() produced for the
+/// AudioEffectAnalogDelay presets.
+/// @param prototype the analog prototype
+/// @param fc the cutoff frequency in Hz (the stopband edge for CHEBYSHEV2)
+/// @param param prototype specific parameter, see SosPrototype
+/// @param highpass when true, a highpass is designed instead of a lowpass
+/// @param sampleRate the sample rate in Hz
+/// @returns the cascade of second order sections
+template <unsigned NUM_STAGES>
+constexpr SosDesign<NUM_STAGES> designSos(SosPrototype prototype, double fc, double param = 0.0,
+                                          bool highpass = false, double sampleRate = AUDIO_SAMPLE_RATE_EXACT)
+{
+	constexpr unsigned ORDER = 2*NUM_STAGES;
+	SosDesign<NUM_STAGES> sos;
+
+	const double fs2 = 2.0 * sampleRate;
+	const double wc  = fs2 * constexprMath::tan(constexprMath::PI_DOUBLE * fc / sampleRate); // prewarped analog cutoff
+
+	double mu = 0.0;
+	if (prototype == SosPrototype::CHEBYSHEV1) {
+		const double eps = constexprMath::sqrt(constexprMath::pow10(param / 10.0) - 1.0);
+		mu = constexprMath::asinh(1.0 / eps) / ORDER;
+	} else if (prototype == SosPrototype::CHEBYSHEV2) {
+		const double eps = 1.0 / constexprMath::sqrt(constexprMath::pow10(param / 10.0) - 1.0);
+		mu = constexprMath::asinh(1.0 / eps) / ORDER;
+	}
+
+	for (unsigned k=0; k<NUM_STAGES; k++) {
+		const double theta = constexprMath::PI_DOUBLE * (2*k + 1) / (2*ORDER);
+
+		// normalized analog pole (upper half-plane) and zero
+		constexprMath::Complex pole(-constexprMath::sin(theta), constexprMath::cos(theta));
+		constexprMath::Complex zero;
+		bool finiteZero = false;
+		if (prototype == SosPrototype::CHEBYSHEV1) {
+			pole = constexprMath::Complex(-constexprMath::sinh(mu) * constexprMath::sin(theta), constexprMath::cosh(mu) * constexprMath::cos(theta));
+		} else if (prototype == SosPrototype::CHEBYSHEV2) {
+			pole = constexprMath::Complex(1.0, 0.0) / constexprMath::Complex(-constexprMath::sinh(mu) * constexprMath::sin(theta), -constexprMath::cosh(mu) * constexprMath::cos(theta));
+			zero = constexprMath::Complex(0.0, 1.0 / constexprMath::cos(theta));
+			finiteZero = true;
+		}
+
+		// scale to the cutoff, s -> s/wc for lowpass and s -> wc/s for highpass
+		if (highpass) {
+			pole = constexprMath::Complex(wc, 0.0) / pole;
+			if (finiteZero) { zero = constexprMath::Complex(wc, 0.0) / zero; }
+		} else {
+			pole = pole * wc;
+			if (finiteZero) { zero = zero * wc; }
+		}
+
+		// bilinear transform z = (2fs + s) / (2fs - s)
+		const constexprMath::Complex zPole = (constexprMath::Complex(fs2, 0.0) + pole) / (constexprMath::Complex(fs2, 0.0) - pole);
+		sos.a[k][0] = -2.0 * zPole.re;
+		sos.a[k][1] = zPole.norm();
+
+		if (finiteZero) {
+			const constexprMath::Complex zZero = (constexprMath::Complex(fs2, 0.0) + zero) / (constexprMath::Complex(fs2, 0.0) - zero);
+			sos.b[k][0] = 1.0;
+			sos.b[k][1] = -2.0 * zZero.re;
+			sos.b[k][2] = zZero.norm();
+		} else {
+			// zeros at z = -1 for lowpass, z = +1 for highpass
+			sos.b[k][0] = 1.0;
+			sos.b[k][1] = highpass ? -2.0 : 2.0;
+			sos.b[k][2] = 1.0;
+		}
+	}
+
+	// normalize the gain at DC (lowpass) or Nyquist (highpass)
+	const double zEval = highpass ? -1.0 : 1.0;
+	double gain = 1.0;
+	for (unsigned k=0; k<NUM_STAGES; k++) {
+		gain *= (sos.b[k][0] + sos.b[k][1]*zEval + sos.b[k][2]) / (1.0 + sos.a[k][0]*zEval + sos.a[k][1]);
+	}
+	double target = 1.0;
+	if (prototype == SosPrototype::CHEBYSHEV1) {
+		target = 1.0 / constexprMath::sqrt(constexprMath::pow10(param / 10.0)); // even order passband starts at the bottom of the ripple
+	}
+	for (unsigned i=0; i<3; i++) { sos.b[NUM_STAGES-1][i] *= target / gain; }
+	return sos;
+}
+
+/// Design a cascade of 2nd-order analog lowpass sections using the bilinear transform with each
+/// section prewarped at its natural frequency. Each section has unity gain at DC.
+/// @details This is useful for modeling analog circuits like BBD anti-aliasing and reconstruction
+/// filters that are described by their section frequencies and Qs.
+/// @param sections an array of NUM_STAGES analog sections
+/// @param sampleRate the sample rate in Hz
+/// @returns the cascade of second order sections
+template <unsigned NUM_STAGES>
+constexpr SosDesign<NUM_STAGES> designSos(const AnalogSection (&sections)[NUM_STAGES], double sampleRate = AUDIO_SAMPLE_RATE_EXACT)
+{
+	SosDesign<NUM_STAGES> sos;
+	for (unsigned k=0; k<NUM_STAGES; k++) {
+		const double K  = constexprMath::tan(constexprMath::PI_DOUBLE * sections[k].f0 / sampleRate);
+		const double K2 = K * K;
+		const double a0 = K2 + K/sections[k].q + 1.0;
+		sos.b[k][0] = K2 / a0;
+		sos.b[k][1] = 2.0 * K2 / a0;
+		sos.b[k][2] = K2 / a0;
+		sos.a[k][0] = 2.0 * (K2 - 1.0) / a0;
+		sos.a[k][1] = (K2 - K/sections[k].q + 1.0) / a0;
+	}
+	return sos;
+}
+
+/// Quantize a cascade of second order sections to Q31. The smallest coefficient shift that fits
+/// every coefficient is chosen.
+/// @param sos the double-precision second order sections
+/// @returns the Q31 coefficients, number of stages and coefficient shift
+template <unsigned NUM_STAGES>
+constexpr SosQ31<NUM_STAGES> quantizeSosQ31(const SosDesign<NUM_STAGES> &sos)
+{
+	SosQ31<NUM_STAGES> result;
+
+	// CMSIS-DSP layout with the 'a' coefficients negated
+	double values[SOS_COEFFS_PER_STAGE*NUM_STAGES] = {};
+	for (unsigned k=0; k<NUM_STAGES; k++) {
+		values[SOS_COEFFS_PER_STAGE*k + 0] =  sos.b[k][0];
+		values[SOS_COEFFS_PER_STAGE*k + 1] =  sos.b[k][1];
+		values[SOS_COEFFS_PER_STAGE*k + 2] =  sos.b[k][2];
+		values[SOS_COEFFS_PER_STAGE*k + 3] = -sos.a[k][0];
+		values[SOS_COEFFS_PER_STAGE*k + 4] = -sos.a[k][1];
+	}
+
+	double maxValue = 0.0;
+	for (unsigned i=0; i<SOS_COEFFS_PER_STAGE*NUM_STAGES; i++) {
+		if (constexprMath::fabs(values[i]) > maxValue) { maxValue = constexprMath::fabs(values[i]); }
+	}
+	double scale = 2147483648.0;
+	while (constexprMath::roundNearest(maxValue * scale) > 2147483647.0) {
+		scale *= 0.5;
+		result.coeffShift++;
+	}
+
+	for (unsigned i=0; i<SOS_COEFFS_PER_STAGE*NUM_STAGES; i++) {
+		result.coeffs[i] = static_cast<int32_t>(constexprMath::roundNearest(values[i] * scale));
+	}
+	return result;
+}
+
+/// Compute the magnitude response of a Q31 cascade at the specified frequency.
+/// @param coeffs pointer to the Q31 coefficients, {b0, b1, b2, a1, a2} per stage with 'a' negated
+/// @param numStages the number of stages
+/// @param coeffShift the coefficient shift
+/// @param freqHz the frequency in Hz
+/// @param sampleRate the sample rate in Hz
+/// @returns the linear magnitude
+constexpr double sosMagnitudeQ31(const int32_t *coeffs, unsigned numStages, int coeffShift,
+                                 double freqHz, double sampleRate = AUDIO_SAMPLE_RATE_EXACT)
+{
+	const double w = 2.0 * constexprMath::PI_DOUBLE * freqHz / sampleRate;
+	const constexprMath::Complex z1(constexprMath::cos(w), -constexprMath::sin(w));  // z^-1
+	const constexprMath::Complex z2 = z1 * z1;         // z^-2
+	double scale = 1.0 / 2147483648.0;
+	for (int i=0; i<coeffShift; i++) { scale *= 2.0; }
+
+	double magSquared = 1.0;
+	for (unsigned k=0; k<numStages; k++) {
+		const int32_t *c = &coeffs[SOS_COEFFS_PER_STAGE*k];
+		const constexprMath::Complex num = constexprMath::Complex(c[0]*scale, 0.0) + z1*(c[1]*scale) + z2*(c[2]*scale);
+		const constexprMath::Complex den = constexprMath::Complex(1.0, 0.0) - z1*(c[3]*scale) - z2*(c[4]*scale);
+		magSquared *= num.norm() / den.norm();
+	}
+	return constexprMath::sqrt(magSquared);
+}
+
+/// Compute the magnitude response of a Q31 cascade at the specified frequency.
+/// @param sos the Q31 second order sections
+/// @param freqHz the frequency in Hz
+/// @param sampleRate the sample rate in Hz
+/// @returns the linear magnitude
+template <unsigned NUM_STAGES>
+constexpr double sosMagnitudeQ31(const SosQ31<NUM_STAGES> &sos, double freqHz, double sampleRate = AUDIO_SAMPLE_RATE_EXACT)
+{
+	return sosMagnitudeQ31(sos.coeffs, sos.numStages, sos.coeffShift, freqHz, sampleRate);
+}
+
+/// Check if a Q31 cascade matches a reference table within quantization error. The coefficient
+/// shifts must match and the magnitude responses must agree within the tolerance wherever the
+/// reference response is above -60dB, sampled every third of an octave from 20Hz to 20kHz.
+/// @details This is intended for use in static_assert() to verify generated tables.
+/// @param sos the Q31 second order sections to check
+/// @param coeffs pointer to the reference Q31 coefficients
+/// @param numStages number of stages in the reference
+/// @param coeffShift coefficient shift of the reference
+/// @param tolerance maximum relative magnitude difference
+/// @param sampleRate the sample rate in Hz
+/// @returns true if the responses match
+template <unsigned NUM_STAGES>
+constexpr bool sosMatchesQ31(const SosQ31<NUM_STAGES> &sos, const int32_t *coeffs, unsigned numStages,
+                             int coeffShift, double tolerance = 0.01, double sampleRate = AUDIO_SAMPLE_RATE_EXACT)
+{
+	if ((sos.numStages != numStages) || (sos.coeffShift != coeffShift)) { return false; }
+	for (double freqHz = 20.0; freqHz < 20000.0; freqHz *= 1.25992105) {
+		const double reference = sosMagnitudeQ31(coeffs, numStages, coeffShift, freqHz, sampleRate);
+		if (reference < 0.001) { continue; }
+		const double error = sosMagnitudeQ31(sos, freqHz, sampleRate) / reference - 1.0;
+		if ((error > tolerance) || (error < -tolerance)) { return false; }
+	}
+	return true;
+}
+
+} // namespace BALibrary
+
+#endif /* __BALIBRARY_LIBFILTERDESIGN_H */
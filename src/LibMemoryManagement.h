@@ -149,6 +149,19 @@ public:
 	/// @returns true on success, else false on error
 	bool read16(size_t offsetWords, int16_t *dest, size_t numWords);
 
+	/// Read several blocks of 16-bit data, each from its own offset, as a single batch.
+	/// @details reads that go past the end of the slot wrap around to the start. When using
+	/// DMA the reads are queued as one chain, check isReadBusy() before using the data.
+	/// @param offsetWords array of offsets in 16-bit words from start of slot
+	/// @param dest array of pointers to the destination for each read
+	/// @param numWords array with the number of 16-bit words to transfer for each read
+	/// @param numReads the number of reads, must be <= MAX_SLOT_BATCH_READS
+	/// @returns true on success, else false on error
+	bool readBatch16(const size_t *offsetWords, int16_t * const *dest, const size_t *numWords, unsigned numReads);
+
+	/// The maximum number of reads in one call to readBatch16(). Each may wrap and become two SPI reads.
+	static constexpr unsigned MAX_SLOT_BATCH_READS = MAX_SPI_MEM_BATCH_READS/2;
+
 	/* 16-bit data transfers */
 
 	/// Read the next in memory during circular operation
@@ -0,0 +1,179 @@
+/**************************************************************************//**
+ *  @file
+ *  @author Steve Lascos
+ *  @company Blackaddr Audio
+ *
+ *  LibSimd is a thin layer over the packed 16-bit (SIMD) and saturating
+ *  instructions of the Cortex-M4/M7 DSP extension. On the target each function
+ *  maps to a single instruction, elsewhere (e.g. a Linux workstation) portable
+ *  code with identical results is used so the library kernels can be tested
+ *  and benchmarked bit-exactly off-target.
+ *
+ *  @copyright This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#ifndef __BALIBRARY_LIBSIMD_H
+#define __BALIBRARY_LIBSIMD_H
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_math.h>
+#define BALIBRARY_SIMD_DSP 1 ///< set when the DSP extension instructions are used
+#else
+#define BALIBRARY_SIMD_DSP 0
+#endif
+
+namespace BALibrary {
+
+/// Packed 16-bit helpers. A packed word holds two Q15 samples, the sample with the
+/// lower address (or the first argument of pack16()) in the low half.
+namespace simd {
+
+/// Saturate a 32-bit value to the Q15 range (SSAT)
+inline int16_t saturate16(int32_t value)
+{
+#if BALIBRARY_SIMD_DSP
+	return static_cast<int16_t>(__SSAT(value, 16));
+#else
+	if (value > 32767)  { return 32767; }
+	if (value < -32768) { return -32768; }
+	return static_cast<int16_t>(value);
+#endif
+}
+
+/// Saturating 32-bit add (QADD)
+inline int32_t qadd(int32_t x, int32_t y)
+{
+#if BALIBRARY_SIMD_DSP
+	return static_cast<int32_t>(__QADD(x, y));
+#else
+	const int64_t sum = static_cast<int64_t>(x) + y;
+	if (sum > INT32_MAX) { return INT32_MAX; }
+	if (sum < INT32_MIN) { return INT32_MIN; }
+	return static_cast<int32_t>(sum);
+#endif
+}
+
+/// Pack the low halves of two words, low in the bottom and high in the top (PKHBT)
+inline int32_t pack16(int32_t low, int32_t high)
+{
+#if BALIBRARY_SIMD_DSP
+	return static_cast<int32_t>(__PKHBT(low, high, 16));
+#else
+	return static_cast<int32_t>((static_cast<uint32_t>(low) & 0xFFFFu) | (static_cast<uint32_t>(high) << 16));
+#endif
+}
+
+/// Get the sign-extended bottom half of a packed word
+inline int32_t unpackLow(int32_t x) { return static_cast<int16_t>(x); }
+
+/// Get the sign-extended top half of a packed word
+inline int32_t unpackHigh(int32_t x) { return x >> 16; }
+
+/// Load two consecutive samples as a packed word. The pointer only needs 16-bit alignment.
+inline int32_t load2(const int16_t *src)
+{
+	int32_t x;
+	memcpy(&x, src, sizeof(x)); // a single LDR on the Cortex-M4/M7
+	return x;
+}
+
+/// Store a packed word as two consecutive samples. The pointer only needs 16-bit alignment.
+inline void store2(int16_t *dest, int32_t x)
+{
+	memcpy(dest, &x, sizeof(x));
+}
+
+/// Dual saturating 16-bit add, each half of x is added to the same half of y (QADD16)
+inline int32_t qadd16(int32_t x, int32_t y)
+{
+#if BALIBRARY_SIMD_DSP
+	return static_cast<int32_t>(__QADD16(x, y));
+#else
+	return pack16(saturate16(unpackLow(x) + unpackLow(y)), saturate16(unpackHigh(x) + unpackHigh(y)));
+#endif
+}
+
+/// Dual 16-bit multiply with 32-bit accumulate, acc + x.low*y.low + x.high*y.high (SMLAD)
+inline int32_t smlad(int32_t x, int32_t y, int32_t acc)
+{
+#if BALIBRARY_SIMD_DSP
+	return static_cast<int32_t>(__SMLAD(x, y, acc));
+#else
+	return static_cast<int32_t>(static_cast<uint32_t>(acc) + static_cast<uint32_t>(unpackLow(x) * unpackLow(y))
+	                            + static_cast<uint32_t>(unpackHigh(x) * unpackHigh(y)));
+#endif
+}
+
+/// Dual 16-bit multiply with 64-bit accumulate, acc + x.low*y.low + x.high*y.high (SMLALD)
+inline int64_t smlald(int32_t x, int32_t y, int64_t acc)
+{
+#if BALIBRARY_SIMD_DSP
+	return static_cast<int64_t>(__SMLALD(static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint64_t>(acc)));
+#else
+	return acc + unpackLow(x) * unpackLow(y) + unpackHigh(x) * unpackHigh(y);
+#endif
+}
+
+/// Dual 16-bit multiply and subtract, x.low*y.low - x.high*y.high (SMUSD). With complex
+/// values packed as {real, imag} this is the real part of x*y.
+inline int32_t smusd(int32_t x, int32_t y)
+{
+#if BALIBRARY_SIMD_DSP
+	return static_cast<int32_t>(__SMUSD(x, y));
+#else
+	return unpackLow(x) * unpackLow(y) - unpackHigh(x) * unpackHigh(y);
+#endif
+}
+
+/// Dual 16-bit exchanged multiply and add, x.low*y.high + x.high*y.low (SMUADX). With complex
+/// values packed as {real, imag} this is the imaginary part of x*y.
+inline int32_t smuadx(int32_t x, int32_t y)
+{
+#if BALIBRARY_SIMD_DSP
+	return static_cast<int32_t>(__SMUADX(x, y));
+#else
+	return unpackLow(x) * unpackHigh(y) + unpackHigh(x) * unpackLow(y);
+#endif
+}
+
+/// Multiply a 1.63 value by a 1.31 value, same as the CMSIS-DSP mult32x64()
+inline int64_t mult32x64(int64_t x, int32_t y)
+{
+	return ((((int64_t)(x & 0x00000000FFFFFFFF)) * y) >> 32) + ((x >> 32) * y);
+}
+
+/// Scale both halves of a packed word by a Q15 gain, sat((x * gain) >> shift) per half.
+/// @param x the packed samples
+/// @param gain the Q15 gain
+/// @param shift the right shift after multiplying, 15 for a unity Q15 scale.
+inline int32_t scale16(int32_t x, int32_t gain, int shift)
+{
+	return pack16(saturate16((unpackLow(x) * gain) >> shift), saturate16((unpackHigh(x) * gain) >> shift));
+}
+
+/// Multiply each half of x by the same half of gains in Q15, sat((x * gain) >> 15) per half.
+/// The 16x16 multiplies are SMULBB/SMULTT on the target.
+inline int32_t multQ15x2(int32_t x, int32_t gains)
+{
+	return pack16(saturate16((unpackLow(x) * unpackLow(gains)) >> 15), saturate16((unpackHigh(x) * unpackHigh(gains)) >> 15));
+}
+
+} // namespace simd
+
+} // namespace BALibrary
+
+#endif /* __BALIBRARY_LIBSIMD_H */
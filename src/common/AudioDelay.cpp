@@ -28,14 +28,9 @@ namespace BALibrary {
 // AudioDelay
 ////////////////////////////////////////////////////
 AudioDelay::AudioDelay(size_t maxSamples)
-: m_slot(nullptr)
+: AudioDelay(AudioDelayBackend::INTERNAL_RING, maxSamples)
 {
-    m_type = (MemType::MEM_INTERNAL);
 
-	// INTERNAL memory consisting of audio_block_t data structures.
-	QueuePosition pos = calcQueuePosition(maxSamples);
-	m_ringBuffer = new RingBuffer<audio_block_t *>(pos.index+2); // If the delay is in queue x, we need to overflow into x+1, thus x+2 total buffers.
-	m_maxDelaySamples = maxSamples;
 }
 
 AudioDelay::AudioDelay(float maxDelayTimeMs)
@@ -45,73 +40,51 @@ AudioDelay::AudioDelay(float maxDelayTimeMs)
 }
 
 AudioDelay::AudioDelay(ExtMemSlot *slot)
+: m_backend(AudioDelayBackend::EXTERNAL_PIO), m_slot(slot), m_extPio(slot), m_extDma(slot)
 {
-	m_type = (MemType::MEM_EXTERNAL);
-	m_slot = slot;
-	m_maxDelaySamples = (slot->size() / sizeof(int16_t)) - AUDIO_BLOCK_SAMPLES;
+}
+
+AudioDelay::AudioDelay(AudioDelayBackend backend, size_t maxSamples)
+{
+	// INTERNAL memory consisting of audio_block_t data structures, or a flat sample buffer.
+	if (backend == AudioDelayBackend::INTERNAL_FLAT) {
+		m_backend = AudioDelayBackend::INTERNAL_FLAT;
+		m_flat = new AudioDelayT<AudioDelayBackend::INTERNAL_FLAT>(maxSamples);
+	} else {
+		if ((backend != AudioDelayBackend::INTERNAL_RING) && Serial) { Serial.println("AudioDelay(): EXTERNAL memory requires a slot, using INTERNAL_RING"); }
+		m_backend = AudioDelayBackend::INTERNAL_RING;
+		m_ring = new AudioDelayT<AudioDelayBackend::INTERNAL_RING>(maxSamples);
+	}
 }
 
 AudioDelay::~AudioDelay()
 {
-    if (m_ringBuffer) delete m_ringBuffer;
+    if (m_ring) delete m_ring;
+    if (m_flat) delete m_flat;
+    if (m_reverseBuffer) delete [] m_reverseBuffer;
 }
 
 audio_block_t* AudioDelay::addBlock(audio_block_t *block)
 {
-	audio_block_t *blockToRelease = nullptr;
-
-	if (m_type == (MemType::MEM_INTERNAL)) {
-		// INTERNAL memory
-
-		// purposefully don't check if block is valid, the ringBuffer can support nullptrs
-		if ( m_ringBuffer->size() >= m_ringBuffer->max_size() ) {
-			// pop before adding
-			blockToRelease = m_ringBuffer->front();
-			m_ringBuffer->pop_front();
-		}
-
-		// add the new buffer
-		m_ringBuffer->push_back(block);
-		return blockToRelease;
-
-	} else {
-		// EXTERNAL memory
-		if (!m_slot) {
-			if (Serial) { Serial.println("addBlock(): m_slot is not valid"); }
-		}
-
-		if (block) {
-
-            // KLUGE! The Teensy Audio Library doesn't support DMA buffers correctly on the T4.0. We need to
-            // use an intermediate copy buffer kluge here.
-#if defined(__IMXRT1062__)
-            // This is a T4.0 build
-            setSpiDmaCopyBuffer();
-#endif
-
-		    m_slot->writeAdvance16(block->data, AUDIO_BLOCK_SAMPLES);
-		}
-		blockToRelease =  block;
+	if ((m_backend == AudioDelayBackend::EXTERNAL_PIO) && !m_slot) {
+		if (Serial) { Serial.println("addBlock(): m_slot is not valid"); }
+		return block;
 	}
-	return blockToRelease;
+	return visit([block](auto *memory) { return memory->addBlock(block); });
 }
 
 audio_block_t* AudioDelay::getBlock(size_t index)
 {
 	audio_block_t *ret = nullptr;
-	if (m_type == (MemType::MEM_INTERNAL)) {
-		ret =  m_ringBuffer->at(m_ringBuffer->get_index_from_back(index));
+	if (m_ring) {
+		ret = m_ring->getBlock(index);
 	}
 	return ret;
 }
 
 size_t AudioDelay::getMaxDelaySamples()
 {
-    if (m_type == MemType::MEM_EXTERNAL) {
-        // update the max delay sample size
-        m_maxDelaySamples = (m_slot->size() / sizeof(int16_t)) - AUDIO_BLOCK_SAMPLES;
-    }
-    return m_maxDelaySamples;
+	return visit([](auto *memory) { return memory->getMaxDelaySamples(); });
 }
 
 bool AudioDelay::getSamples(audio_block_t *dest, size_t offsetSamples, size_t numSamples)
@@ -133,77 +106,76 @@ bool AudioDelay::m_getSamples(int16_t *dest, size_t offsetSamples, size_t numSam
 		if (Serial) { Serial.println("getSamples(): dest is invalid"); }
 		return false;
 	}
+	return visit([=](auto *memory) { return memory->getSamples(dest, offsetSamples, numSamples); });
+}
 
-	if (m_type == (MemType::MEM_INTERNAL)) {
-		QueuePosition position = calcQueuePosition(offsetSamples);
-		size_t index = position.index;
+// Reverse playback works on windows of whole audio blocks. At phase p (in samples) into a window
+// starting at time ws, output sample i is x[ws-1-p-i]. Those samples are contiguous in memory so
+// they are read forwards in one burst at delay offset 2p and then reversed. In the last block of
+// a window, the burst is extended by one block to fetch what would have played next in this window.
+// That tail is crossfaded with the first block of the next window to avoid a click at the boundary.
+size_t AudioDelay::setReverseWindow(size_t windowSamples)
+{
+	// reads reach back (2*window + AUDIO_BLOCK_SAMPLES) samples
+	size_t maxWindow = (getMaxDelaySamples() + AUDIO_BLOCK_SAMPLES) / 2;
+	if (windowSamples > maxWindow) { windowSamples = maxWindow; }
+	windowSamples -= windowSamples % AUDIO_BLOCK_SAMPLES;
 
-		audio_block_t *currentQueue0 = m_ringBuffer->at(m_ringBuffer->get_index_from_back(index));
-		// The latest buffer is at the back. We need index+1 counting from the back.
-		audio_block_t *currentQueue1 = m_ringBuffer->at(m_ringBuffer->get_index_from_back(index+1));
+	if (!m_reverseBuffer) {
+		m_reverseBuffer = new int16_t[3*AUDIO_BLOCK_SAMPLES](); // two blocks for the read, one for the tail
+	}
+	m_reverseWindow = windowSamples;
+	if (m_reversePhase >= m_reverseWindow) { m_reversePhase = 0; }
+	return m_reverseWindow;
+}
 
-		// check if either queue is invalid, if so just zero the destination buffer
-		if ( (!currentQueue0) || (!currentQueue1) ) {
-			// a valid entry is not in all queue positions while it is filling, use zeros
-			memset(static_cast<void*>(dest), 0, numSamples * sizeof(int16_t));
-			return true;
-		}
+bool AudioDelay::requestReverseSamples(void)
+{
+	if (!m_reverseBuffer || !m_reverseWindow) {
+		if (Serial) { Serial.println("requestReverseSamples(): reverse window is not set"); }
+		return false;
+	}
 
-		if ( (position.offset == 0) && numSamples <= AUDIO_BLOCK_SAMPLES ) {
-			// single transfer
-			memcpy(static_cast<void*>(dest), static_cast<void*>(currentQueue0->data), numSamples * sizeof(int16_t));
-			return true;
-		}
+	size_t offsetSamples = 2*m_reversePhase;
+	bool lastBlock = (m_reversePhase + AUDIO_BLOCK_SAMPLES >= m_reverseWindow);
+	m_reverseReadSamples = lastBlock ? 2*AUDIO_BLOCK_SAMPLES : AUDIO_BLOCK_SAMPLES;
 
-		// Otherwise we need to break the transfer into two memcpy because it will go across two source queues.
-		// Audio is stored in reverse order. That means the first sample (in time) goes in the last location in the audio block.
-		int16_t *destStart = dest;
-		int16_t *srcStart;
+	if (lastBlock && (getBackendType() != AudioDelayBackend::INTERNAL_FLAT)) {
+		// the ring can only return one block per read, and on the T4 an EXTERNAL read must fit
+		// in the one block DMA copy buffer
+		return m_getSamples(m_reverseBuffer + AUDIO_BLOCK_SAMPLES, offsetSamples, AUDIO_BLOCK_SAMPLES) &&
+		       m_getSamples(m_reverseBuffer, offsetSamples + AUDIO_BLOCK_SAMPLES, AUDIO_BLOCK_SAMPLES);
+	}
+	return m_getSamples(m_reverseBuffer, offsetSamples, m_reverseReadSamples);
+}
 
-		// Break the transfer into two. Copy the 'older' data first then the 'newer' data with respect to current time.
-		// TODO: should AUDIO_BLOCK_SAMPLES on the next line be numSamples?
-		srcStart  = (currentQueue1->data + AUDIO_BLOCK_SAMPLES - position.offset);
-		size_t numData = position.offset;
-		memcpy(static_cast<void*>(destStart), static_cast<void*>(srcStart), numData * sizeof(int16_t));
+bool AudioDelay::getReverseSamples(int16_t *dest)
+{
+	if (!m_reverseBuffer || !dest) { return false; }
+	visit([](auto *memory) { memory->waitForRead(); });
 
-		destStart += numData; // we already wrote numData so advance by this much.
-		srcStart  = (currentQueue0->data);
-		numData = numSamples - numData;
-		memcpy(static_cast<void*>(destStart), static_cast<void*>(srcStart), numData * sizeof(int16_t));
+	int16_t *tail = m_reverseBuffer + 2*AUDIO_BLOCK_SAMPLES;
+	bool firstBlock = (m_reversePhase == 0);
 
-		return true;
+	// the most recent samples in the read are the first to play
+	reverseSamples(dest, m_reverseBuffer + m_reverseReadSamples - AUDIO_BLOCK_SAMPLES, AUDIO_BLOCK_SAMPLES);
 
-	} else {
-		// EXTERNAL Memory
-		if (numSamples*sizeof(int16_t) <= m_slot->size() ) { // check for overflow
-
-			// current position is considered the write position subtracted by the number of samples we're going
-			// to read since this is the smallest delay we can get without reading past the write position into
-			// the "future".
-			int currentPositionBytes = (int)m_slot->getWritePosition() - (int)(numSamples*sizeof(int16_t));
-			size_t offsetBytes = offsetSamples * sizeof(int16_t);
-
-			if ((int)offsetBytes <= currentPositionBytes) {
-				// when we back up to read, we won't wrap over the beginning of the slot
-				m_slot->setReadPosition(currentPositionBytes - offsetBytes);
-			} else {
-				// It's going to wrap around to the from the beginning to the end of the slot.
-				int readPosition = (int)m_slot->size() + currentPositionBytes - offsetBytes;
-				m_slot->setReadPosition((size_t)readPosition);
-			}
-
-			// Read the number of samples
-			m_slot->readAdvance16(dest, numSamples);
-
-			return true;
-		} else {
-			// numSamples is > than total slot size
-			if (Serial) { Serial.println("getSamples(): ERROR numSamples > total slot size"); }
-			if (Serial) { Serial.println(numSamples + String(" > ") + m_slot->size()); }
-			return false;
+	if (firstBlock) {
+		// crossfade from the end of the previous window
+		for (unsigned i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			int32_t gain = (i << 15) / AUDIO_BLOCK_SAMPLES;
+			dest[i] = static_cast<int16_t>((dest[i]*gain + tail[i]*(32768 - gain)) >> 15);
 		}
 	}
 
+	if (m_reverseReadSamples > AUDIO_BLOCK_SAMPLES) {
+		// save the tail of this window for the crossfade
+		reverseSamples(tail, m_reverseBuffer, AUDIO_BLOCK_SAMPLES);
+	}
+
+	m_reversePhase += AUDIO_BLOCK_SAMPLES;
+	if (m_reversePhase >= m_reverseWindow) { m_reversePhase = 0; }
+	return true;
 }
 
 bool AudioDelay::interpolateDelay(int16_t *extendedSourceBuffer, int16_t *destBuffer, float fraction, size_t numSamples)
@@ -223,16 +195,192 @@ bool AudioDelay::interpolateDelay(int16_t *extendedSourceBuffer, int16_t *destBu
 }
 
 bool AudioDelay::setSpiDmaCopyBuffer(void)
+{
+    return BALibrary::setSpiDmaCopyBuffer(m_slot);
+}
+
+////////////////////////////////////////////////////
+// AudioDelayF32
+////////////////////////////////////////////////////
+AudioDelayF32::AudioDelayF32(size_t maxSamples)
+: m_bufferSize(maxSamples + AUDIO_BLOCK_SAMPLES), m_maxDelaySamples(maxSamples)
+{
+	m_buffer = new float[m_bufferSize]();
+}
+
+AudioDelayF32::AudioDelayF32(float maxDelayTimeMs)
+: AudioDelayF32(calcAudioSamples(maxDelayTimeMs))
+{
+
+}
+
+AudioDelayF32::AudioDelayF32(ExtMemSlot *slot)
+: m_slot(slot), m_extMem(slot)
+{
+	m_writeBuffer = new int16_t[AUDIO_BLOCK_SAMPLES]();
+	m_readBuffer  = new int16_t[MAX_EXTERNAL_READ_SAMPLES]();
+}
+
+AudioDelayF32::~AudioDelayF32()
+{
+	if (m_buffer) delete [] m_buffer;
+	if (m_writeBuffer) delete [] m_writeBuffer;
+	if (m_readBuffer)  delete [] m_readBuffer;
+	if (m_reverseBuffer) delete [] m_reverseBuffer;
+}
+
+void AudioDelayF32::addBlock(const float *samples)
+{
+	if (m_slot) {
+		// the write buffer is not reused until the next block, long after the transfer completes
+		if (samples) { convertFloatToQ15(m_writeBuffer, samples, AUDIO_BLOCK_SAMPLES); }
+		else { memset(m_writeBuffer, 0, AUDIO_BLOCK_SAMPLES * sizeof(int16_t)); }
+#if defined(__IMXRT1062__)
+		// KLUGE! The Teensy Audio Library doesn't support DMA buffers correctly on the T4.0.
+		BALibrary::setSpiDmaCopyBuffer(m_slot);
+#endif
+		m_slot->writeAdvance16(m_writeBuffer, AUDIO_BLOCK_SAMPLES);
+		return;
+	}
+
+	// a missing block is stored as silence
+	size_t numData = m_bufferSize - m_writePosition;
+	if (numData > AUDIO_BLOCK_SAMPLES) { numData = AUDIO_BLOCK_SAMPLES; }
+	if (samples) {
+		memcpy(m_buffer + m_writePosition, samples, numData * sizeof(float));
+		memcpy(m_buffer, samples + numData, (AUDIO_BLOCK_SAMPLES - numData) * sizeof(float));
+	} else {
+		memset(m_buffer + m_writePosition, 0, numData * sizeof(float));
+		memset(m_buffer, 0, (AUDIO_BLOCK_SAMPLES - numData) * sizeof(float));
+	}
+	m_writePosition += AUDIO_BLOCK_SAMPLES;
+	if (m_writePosition >= m_bufferSize) { m_writePosition -= m_bufferSize; }
+}
+
+size_t AudioDelayF32::getMaxDelaySamples() const
+{
+	return m_slot ? m_extMem.getMaxDelaySamples() : m_maxDelaySamples;
+}
+
+bool AudioDelayF32::getSamples(float *dest, size_t offsetSamples, size_t numSamples)
+{
+	if (!dest) {
+		if (Serial) { Serial.println("getSamples(): dest is invalid"); }
+		return false;
+	}
+
+	if (m_slot) {
+		if (numSamples > MAX_EXTERNAL_READ_SAMPLES) {
+			if (Serial) { Serial.println("getSamples(): ERROR numSamples > MAX_EXTERNAL_READ_SAMPLES"); }
+			return false;
+		}
+		waitForRead(); // only one read can be pending
+		if (!m_extMem.getSamples(m_readBuffer, offsetSamples, numSamples)) { return false; }
+		m_readDest = dest;
+		m_readSamples = numSamples;
+		if (!m_slot->isUseDma()) { waitForRead(); } // the samples are already here
+		return true;
+	}
+
+	if (offsetSamples + numSamples > m_bufferSize) { return false; }
+
+	// the newest numSamples are the smallest delay, back up from there by the offset
+	int readPosition = (int)m_writePosition - (int)(numSamples + offsetSamples);
+	if (readPosition < 0) { readPosition += m_bufferSize; }
+
+	size_t numData = m_bufferSize - readPosition;
+	if (numData > numSamples) { numData = numSamples; }
+	memcpy(dest, m_buffer + readPosition, numData * sizeof(float));
+	memcpy(dest + numData, m_buffer, (numSamples - numData) * sizeof(float));
+	return true;
+}
+
+void AudioDelayF32::waitForRead()
+{
+	if (!m_readDest) { return; }
+	m_extMem.waitForRead();
+	convertQ15ToFloat(m_readDest, m_readBuffer, m_readSamples);
+	m_readDest = nullptr;
+}
+
+// Reverse playback works the same as AudioDelay::setReverseWindow(), the forward
+// reads are never more than two blocks and EXTERNAL memory reads them one at a time.
+size_t AudioDelayF32::setReverseWindow(size_t windowSamples)
+{
+	size_t maxWindow = (getMaxDelaySamples() + AUDIO_BLOCK_SAMPLES) / 2;
+	if (windowSamples > maxWindow) { windowSamples = maxWindow; }
+	windowSamples -= windowSamples % AUDIO_BLOCK_SAMPLES;
+
+	if (!m_reverseBuffer) {
+		m_reverseBuffer = new float[3*AUDIO_BLOCK_SAMPLES](); // two blocks for the read, one for the tail
+	}
+	m_reverseWindow = windowSamples;
+	if (m_reversePhase >= m_reverseWindow) { m_reversePhase = 0; }
+	return m_reverseWindow;
+}
+
+bool AudioDelayF32::requestReverseSamples(void)
+{
+	if (!m_reverseBuffer || !m_reverseWindow) {
+		if (Serial) { Serial.println("requestReverseSamples(): reverse window is not set"); }
+		return false;
+	}
+
+	size_t offsetSamples = 2*m_reversePhase;
+	bool lastBlock = (m_reversePhase + AUDIO_BLOCK_SAMPLES >= m_reverseWindow);
+	m_reverseReadSamples = lastBlock ? 2*AUDIO_BLOCK_SAMPLES : AUDIO_BLOCK_SAMPLES;
+
+	if (lastBlock && m_slot) {
+		// EXTERNAL reads are limited to MAX_EXTERNAL_READ_SAMPLES, the second waits for the first
+		return getSamples(m_reverseBuffer + AUDIO_BLOCK_SAMPLES, offsetSamples, AUDIO_BLOCK_SAMPLES) &&
+		       getSamples(m_reverseBuffer, offsetSamples + AUDIO_BLOCK_SAMPLES, AUDIO_BLOCK_SAMPLES);
+	}
+	return getSamples(m_reverseBuffer, offsetSamples, m_reverseReadSamples);
+}
+
+bool AudioDelayF32::getReverseSamples(float *dest)
+{
+	if (!m_reverseBuffer || !dest) { return false; }
+	waitForRead();
+
+	float *tail = m_reverseBuffer + 2*AUDIO_BLOCK_SAMPLES;
+	bool firstBlock = (m_reversePhase == 0);
+
+	// the most recent samples in the read are the first to play
+	reverseSamples(dest, m_reverseBuffer + m_reverseReadSamples - AUDIO_BLOCK_SAMPLES, AUDIO_BLOCK_SAMPLES);
+
+	if (firstBlock) {
+		// crossfade from the end of the previous window
+		constexpr float STEP = 1.0f / AUDIO_BLOCK_SAMPLES;
+		for (unsigned i=0; i < AUDIO_BLOCK_SAMPLES; i++) {
+			const float gain = STEP * i;
+			dest[i] = gain*dest[i] + (1.0f - gain)*tail[i];
+		}
+	}
+
+	if (m_reverseReadSamples > AUDIO_BLOCK_SAMPLES) {
+		// save the tail of this window for the crossfade
+		reverseSamples(tail, m_reverseBuffer, AUDIO_BLOCK_SAMPLES);
+	}
+
+	m_reversePhase += AUDIO_BLOCK_SAMPLES;
+	if (m_reversePhase >= m_reverseWindow) { m_reversePhase = 0; }
+	return true;
+}
+
+bool setSpiDmaCopyBuffer(ExtMemSlot *slot, size_t numBytes)
 {
     bool returnValue = false;
 
-    if (m_slot->isUseDma()) {
+    if (slot->isUseDma()) {
         // For DMA use on T4.0 we need this kluge
-        BASpiMemoryDMA * spiDma = static_cast<BASpiMemoryDMA*>(m_slot->getSpiMemoryHandle());
+        BASpiMemoryDMA * spiDma = static_cast<BASpiMemoryDMA*>(slot->getSpiMemoryHandle());
         if (spiDma) {
-            // Check if the size is already set
-            if (spiDma->getDmaCopyBufferSize() == 0) {
-              spiDma->setDmaCopyBufferSize(sizeof(int16_t) * AUDIO_BLOCK_SAMPLES);
+            // Check if the size is already large enough
+            if (spiDma->getDmaCopyBufferSize() < numBytes) {
+              // the copy buffers are freed and reallocated, they must not be in use
+              while (spiDma->isWriteBusy() || spiDma->isReadBusy()) {}
+              spiDma->setDmaCopyBufferSize(numBytes);
               returnValue = true;
             }
         }
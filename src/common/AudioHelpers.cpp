@@ -20,6 +20,8 @@
 
 #include "Audio.h"
 #include "LibBasicFunctions.h"
+#include "LibBlockOps.h"
+#include "LibSimd.h"
 
 namespace BALibrary {
 
@@ -52,26 +54,122 @@ size_t calcOffset(QueuePosition position)
 
 void alphaBlend(audio_block_t *out, audio_block_t *dry, audio_block_t* wet, float mix)
 {
-	// ARM DSP optimized
-	int16_t wetBuffer[AUDIO_BLOCK_SAMPLES];
-	int16_t dryBuffer[AUDIO_BLOCK_SAMPLES];
-	int16_t scaleFractWet = (int16_t)(mix * 32767.0f);
-	int16_t scaleFractDry = 32767-scaleFractWet;
-
-	arm_scale_q15(dry->data, scaleFractDry, 0, dryBuffer, AUDIO_BLOCK_SAMPLES);
-	arm_scale_q15(wet->data, scaleFractWet, 0, wetBuffer, AUDIO_BLOCK_SAMPLES);
-	arm_add_q15(wetBuffer, dryBuffer, out->data, AUDIO_BLOCK_SAMPLES);
+	// both scales and the add are done in one pass
+	blockOps::evaluate(out, blockOps::mix(dry, wet, mix));
 }
 
 void gainAdjust(audio_block_t *out, audio_block_t *in, float vol, int coeffShift)
 {
 	int16_t scale = (int16_t)(vol * 32767.0f);
-	arm_scale_q15(in->data, scale, coeffShift, out->data, AUDIO_BLOCK_SAMPLES);
+	scaleSamples(out->data, in->data, scale, coeffShift, AUDIO_BLOCK_SAMPLES);
 }
 
 void combine(audio_block_t *out, audio_block_t *in0, audio_block_t *in1)
 {
-    arm_add_q15 (in0->data, in1->data, out->data, AUDIO_BLOCK_SAMPLES);
+	addSamples(out->data, in0->data, in1->data, AUDIO_BLOCK_SAMPLES);
+}
+
+void scaleSamples(int16_t *dest, const int16_t *src, int16_t scale, int coeffShift, size_t numSamples)
+{
+	// same as arm_scale_q15(), two samples per load and store
+	const int shift = 15 - coeffShift;
+	size_t i = 0;
+	for (; i+1 < numSamples; i+=2) {
+		simd::store2(&dest[i], simd::scale16(simd::load2(&src[i]), scale, shift));
+	}
+	if (i < numSamples) { dest[i] = simd::saturate16((src[i] * scale) >> shift); }
+}
+
+void addSamples(int16_t *dest, const int16_t *src0, const int16_t *src1, size_t numSamples)
+{
+	// same as arm_add_q15(), two samples per load and store
+	size_t i = 0;
+	for (; i+1 < numSamples; i+=2) {
+		simd::store2(&dest[i], simd::qadd16(simd::load2(&src0[i]), simd::load2(&src1[i])));
+	}
+	if (i < numSamples) { dest[i] = simd::saturate16(src0[i] + src1[i]); }
+}
+
+void modulateSamples(int16_t *dest, const int16_t *src, const int16_t *gains, size_t numSamples)
+{
+	// two samples per load and store
+	size_t i = 0;
+	for (; i+1 < numSamples; i+=2) {
+		simd::store2(&dest[i], simd::multQ15x2(simd::load2(&src[i]), simd::load2(&gains[i])));
+	}
+	if (i < numSamples) { dest[i] = simd::saturate16((src[i] * gains[i]) >> 15); }
+}
+
+void measureSamples(const int16_t *src, size_t numSamples, int32_t *peak, int64_t *sumOfSquares)
+{
+	// the squares of a pair of samples are accumulated with one dual multiply
+	int32_t maxValue = 0;
+	int32_t minValue = 0;
+	int64_t sum = 0;
+	size_t i = 0;
+	for (; i+1 < numSamples; i+=2) {
+		const int32_t pair = simd::load2(&src[i]);
+		sum = simd::smlald(pair, pair, sum);
+		const int32_t low = simd::unpackLow(pair);
+		const int32_t high = simd::unpackHigh(pair);
+		maxValue = (low  > maxValue) ? low  : maxValue;
+		maxValue = (high > maxValue) ? high : maxValue;
+		minValue = (low  < minValue) ? low  : minValue;
+		minValue = (high < minValue) ? high : minValue;
+	}
+	if (i < numSamples) {
+		const int32_t value = src[i];
+		sum += value*value;
+		maxValue = (value > maxValue) ? value : maxValue;
+		minValue = (value < minValue) ? value : minValue;
+	}
+
+	if (peak) { *peak = (-minValue > maxValue) ? -minValue : maxValue; }
+	if (sumOfSquares) { *sumOfSquares = sum; }
+}
+
+void reverseSamples(int16_t *dest, const int16_t *src, size_t numSamples)
+{
+	if (((((uintptr_t)dest | (uintptr_t)src) & 0x3) == 0) && ((numSamples & 0x1) == 0)) {
+		// Swap the pair of samples in each word and store the words in reverse order. The
+		// halfword swap compiles to a single rotate.
+		const uint32_t *srcWord = reinterpret_cast<const uint32_t *>(src);
+		uint32_t *destWord = reinterpret_cast<uint32_t *>(dest + numSamples) - 1;
+		for (size_t i=0; i < numSamples/2; i++) {
+			uint32_t word = *srcWord++;
+			*destWord-- = (word >> 16) | (word << 16);
+		}
+		return;
+	}
+
+	for (size_t i=0; i < numSamples; i++) {
+		dest[numSamples-1-i] = src[i];
+	}
+}
+
+void reverseSamples(float *dest, const float *src, size_t numSamples)
+{
+	for (size_t i=0; i < numSamples; i++) {
+		dest[numSamples-1-i] = src[i];
+	}
+}
+
+void convertQ15ToFloat(float *dest, const int16_t *src, size_t numSamples)
+{
+	constexpr float SCALE = 1.0f / 32768.0f;
+	for (size_t i=0; i < numSamples; i++) {
+		dest[i] = SCALE * static_cast<float>(src[i]);
+	}
+}
+
+void convertFloatToQ15(int16_t *dest, const float *src, size_t numSamples)
+{
+	for (size_t i=0; i < numSamples; i++) {
+		// clamp before converting since the float may be well outside the Q15 range
+		float value = 32768.0f * src[i];
+		value = (value > 32767.0f) ? 32767.0f : ((value < -32768.0f) ? -32768.0f : value);
+		dest[i] = static_cast<int16_t>(static_cast<int32_t>(value + ((value >= 0.0f) ? 0.5f : -0.5f)));
+	}
 }
 
 void clearAudioBlock(audio_block_t *block)
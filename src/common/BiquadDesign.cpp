@@ -0,0 +1,119 @@
+/*
+ * BiquadDesign.cpp
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include "Audio.h"
+#include "LibBasicFunctions.h"
+
+namespace BALibrary {
+
+// Compute the normalized coefficients {b0, b1, b2, a1, a2} with the 'a' coefficients negated.
+// Double-precision is used since low cutoff frequencies push the poles very close to the unit
+// circle and the result is destined for 31-bit coefficients.
+static bool designBiquadDouble(BiquadType type, float fc, float q, float gainDb, double *coeffs)
+{
+	const double fs = AUDIO_SAMPLE_RATE_EXACT;
+	if ((fc <= 0.0f) || (fc >= fs/2.0) || (q <= 0.0f)) { return false; }
+
+	const double w0    = 2.0 * M_PI * fc / fs;
+	const double cosw  = cos(w0);
+	const double alpha = sin(w0) / (2.0 * q);
+	const double A     = pow(10.0, gainDb / 40.0);
+	const double sqA   = 2.0 * sqrt(A) * alpha;
+
+	double b0, b1, b2, a0, a1, a2;
+	switch (type) {
+	case BiquadType::LOW_PASS :
+		b0 = (1.0 - cosw) / 2.0; b1 = 1.0 - cosw; b2 = b0;
+		a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+		break;
+	case BiquadType::HIGH_PASS :
+		b0 = (1.0 + cosw) / 2.0; b1 = -(1.0 + cosw); b2 = b0;
+		a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+		break;
+	case BiquadType::BAND_PASS :
+		b0 = alpha; b1 = 0.0; b2 = -alpha;
+		a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+		break;
+	case BiquadType::NOTCH :
+		b0 = 1.0; b1 = -2.0 * cosw; b2 = 1.0;
+		a0 = 1.0 + alpha; a1 = -2.0 * cosw; a2 = 1.0 - alpha;
+		break;
+	case BiquadType::PEAKING :
+		b0 = 1.0 + alpha * A; b1 = -2.0 * cosw; b2 = 1.0 - alpha * A;
+		a0 = 1.0 + alpha / A; a1 = -2.0 * cosw; a2 = 1.0 - alpha / A;
+		break;
+	case BiquadType::LOW_SHELF :
+		b0 =        A * ((A + 1.0) - (A - 1.0) * cosw + sqA);
+		b1 =  2.0 * A * ((A - 1.0) - (A + 1.0) * cosw);
+		b2 =        A * ((A + 1.0) - (A - 1.0) * cosw - sqA);
+		a0 =             (A + 1.0) + (A - 1.0) * cosw + sqA;
+		a1 = -2.0 *     ((A - 1.0) + (A + 1.0) * cosw);
+		a2 =             (A + 1.0) + (A - 1.0) * cosw - sqA;
+		break;
+	case BiquadType::HIGH_SHELF :
+		b0 =        A * ((A + 1.0) + (A - 1.0) * cosw + sqA);
+		b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw);
+		b2 =        A * ((A + 1.0) + (A - 1.0) * cosw - sqA);
+		a0 =             (A + 1.0) - (A - 1.0) * cosw + sqA;
+		a1 =  2.0 *     ((A - 1.0) - (A + 1.0) * cosw);
+		a2 =             (A + 1.0) - (A - 1.0) * cosw - sqA;
+		break;
+	default :
+		return false;
+	}
+
+	coeffs[0] =  b0 / a0;
+	coeffs[1] =  b1 / a0;
+	coeffs[2] =  b2 / a0;
+	coeffs[3] = -a1 / a0;
+	coeffs[4] = -a2 / a0;
+	return true;
+}
+
+bool designBiquad(BiquadType type, float fc, float q, float gainDb, float *coeffs)
+{
+	double result[5];
+	if (!coeffs || !designBiquadDouble(type, fc, q, gainDb, result)) { return false; }
+
+	for (unsigned i=0; i<5; i++) {
+		coeffs[i] = static_cast<float>(result[i]);
+	}
+	return true;
+}
+
+bool designBiquad(BiquadType type, float fc, float q, float gainDb, int32_t *coeffs, int coeffShift)
+{
+	double result[5];
+	if (!coeffs || (coeffShift < 0) || (coeffShift > 30)) { return false; }
+	if (!designBiquadDouble(type, fc, q, gainDb, result)) { return false; }
+
+	const double scale = 2147483648.0 / static_cast<double>(1 << coeffShift);
+	int32_t q31[5];
+	for (unsigned i=0; i<5; i++) {
+		const double value = round(result[i] * scale);
+		if ((value >= 2147483648.0) || (value < -2147483648.0)) {
+			if (Serial) { Serial.println("designBiquad(): coefficient out of range, increase coeffShift"); }
+			return false;
+		}
+		q31[i] = static_cast<int32_t>(value);
+	}
+	memcpy(coeffs, q31, sizeof(q31));
+	return true;
+}
+
+}
@@ -230,6 +230,32 @@ bool ExtMemSlot::read16(size_t offsetWords, int16_t *dest, size_t numWords)
 	}
 }
 
+bool ExtMemSlot::readBatch16(const size_t *offsetWords, int16_t * const *dest, const size_t *numWords, unsigned numReads)
+{
+	if (!m_valid || (numReads > MAX_SLOT_BATCH_READS)) { return false; }
+
+	SpiMemReadRequest requests[MAX_SPI_MEM_BATCH_READS];
+	unsigned numRequests = 0;
+
+	for (unsigned i=0; i<numReads; i++) {
+		if (!dest[i]) { return false; } // invalid destination
+		size_t readOffset = m_start + sizeof(int16_t)*offsetWords[i];
+		size_t numBytes = sizeof(int16_t)*numWords[i];
+		if ((readOffset > m_end) || (numBytes > m_size)) { return false; }
+
+		if (readOffset + numBytes-1 <= m_end) {
+			// entire block fits in memory slot without wrapping
+			requests[numRequests++] = {readOffset, reinterpret_cast<uint16_t*>(dest[i]), numWords[i]};
+		} else {
+			// this read will wrap the memory slot
+			size_t rdDataNum = (m_end - readOffset + 1) >> 1;
+			requests[numRequests++] = {readOffset, reinterpret_cast<uint16_t*>(dest[i]), rdDataNum};
+			requests[numRequests++] = {m_start, reinterpret_cast<uint16_t*>(dest[i] + rdDataNum), numWords[i] - rdDataNum};
+		}
+	}
+	return m_spi->readBatch16(requests, numRequests);
+}
+
 uint16_t ExtMemSlot::readAdvance16()
 {
 	uint16_t val = m_spi->read16(m_currentRdPosition);
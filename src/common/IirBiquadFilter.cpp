@@ -18,8 +18,11 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cmath>
+
 #include "Audio.h"
 #include "LibBasicFunctions.h"
+#include "LibSimd.h"
 
 namespace BALibrary {
 
@@ -28,13 +31,199 @@ namespace BALibrary {
 ////////////////////////////////////////////////////
 constexpr int NUM_COEFFS_PER_STAGE = 5;
 constexpr int NUM_STATES_PER_STAGE = 4;
+constexpr int NUM_Q15_COEFFS_PER_STAGE = 6;
+
+using simd::saturate16;
+using simd::mult32x64;
+
+////////////////////////////////////////////////////
+// IirBiQuadMorph
+////////////////////////////////////////////////////
+IirBiQuadMorph::IirBiQuadMorph(unsigned maxNumStages)
+: NUM_STAGES(maxNumStages), m_pending(-1)
+{
+	m_published[0] = new int32_t[NUM_COEFFS_PER_STAGE*maxNumStages];
+	m_published[1] = new int32_t[NUM_COEFFS_PER_STAGE*maxNumStages];
+	m_target = new int32_t[NUM_COEFFS_PER_STAGE*maxNumStages];
+	m_coeffs = new int32_t[NUM_COEFFS_PER_STAGE*maxNumStages];
+	m_delta  = new int32_t[NUM_COEFFS_PER_STAGE*maxNumStages];
+}
+
+IirBiQuadMorph::~IirBiQuadMorph()
+{
+	if (m_published[0]) delete [] m_published[0];
+	if (m_published[1]) delete [] m_published[1];
+	if (m_target) delete [] m_target;
+	if (m_coeffs) delete [] m_coeffs;
+	if (m_delta)  delete [] m_delta;
+}
+
+bool IirBiQuadMorph::publish(unsigned numStages, const int32_t *coeffs, int coeffShift, Transition transition)
+{
+	if (numStages > NUM_STAGES) { return false; }
+
+	// The buffer being written is never the one marked as pending. The audio interrupt
+	// copies the pending buffer in one go and cannot be preempted by this function.
+	// The filter has not reached a pending crossfade's coefficients yet, so interpolating
+	// would start from the old filter. Keep the crossfade. If the audio interrupt picks it
+	// up meanwhile, the extra crossfade is still safe.
+	const int pending = m_pending.load();
+	if ((pending >= 0) && (m_publishedTransition[pending] == Transition::CROSSFADE)) {
+		transition = Transition::CROSSFADE;
+	}
+
+	const unsigned index = m_writeIndex;
+	memcpy(m_published[index], coeffs, NUM_COEFFS_PER_STAGE*numStages * sizeof(int32_t));
+	m_publishedStages[index] = numStages;
+	m_publishedShift[index]  = coeffShift;
+	m_publishedTransition[index] = transition;
+	m_pending.store(static_cast<int>(index));
+	m_writeIndex = index ^ 1;
+	return true;
+}
+
+// Get a pass-through stage coefficient with the specified shift
+static inline int32_t passThroughCoeff(unsigned coeffIndex, int coeffShift)
+{
+	if (coeffIndex != 0) { return 0; }
+	return (coeffShift > 0) ? (1 << (31-coeffShift)) : 0x7FFFFFFF;
+}
+
+unsigned IirBiQuadMorph::start(unsigned numStages, int coeffShift, const int32_t *coeffs, size_t numSamples)
+{
+	const int index = m_pending.exchange(-1);
+	if (index < 0) { return 0; }
+
+	m_targetStages = m_publishedStages[index];
+	m_targetShift  = m_publishedShift[index];
+	m_transition   = m_publishedTransition[index];
+	memcpy(m_target, m_published[index], NUM_COEFFS_PER_STAGE*m_targetStages * sizeof(int32_t));
+
+	if (m_transition == Transition::CROSSFADE) {
+		// the new filter is run as is alongside the old one
+		memcpy(m_coeffs, m_target, NUM_COEFFS_PER_STAGE*m_targetStages * sizeof(int32_t));
+		m_numStages  = m_targetStages;
+		m_coeffShift = m_targetShift;
+		return m_numStages;
+	}
+
+	// The filter state is independent of the coefficient shift so interpolate using the
+	// larger of the two shifts.
+	m_numStages  = (numStages > m_targetStages) ? numStages : m_targetStages;
+	m_coeffShift = (coeffShift > m_targetShift) ? coeffShift : m_targetShift;
+	if (numSamples == 0) { numSamples = 1; }
+
+	for (unsigned stage=0; stage<m_numStages; stage++) {
+		for (unsigned i=0; i<NUM_COEFFS_PER_STAGE; i++) {
+			const unsigned idx = NUM_COEFFS_PER_STAGE*stage + i;
+			int32_t from = (stage < numStages)      ? (coeffs[idx]   >> (m_coeffShift - coeffShift))    : passThroughCoeff(i, m_coeffShift);
+			int32_t to   = (stage < m_targetStages) ? (m_target[idx] >> (m_coeffShift - m_targetShift)) : passThroughCoeff(i, m_coeffShift);
+			m_coeffs[idx] = from;
+			m_delta[idx]  = static_cast<int32_t>(((int64_t)to - (int64_t)from) / (int64_t)numSamples);
+		}
+	}
+	return m_numStages;
+}
+
+void IirBiQuadMorph::step()
+{
+	for (unsigned i=0; i<NUM_COEFFS_PER_STAGE*m_numStages; i++) {
+		m_coeffs[i] += m_delta[i];
+	}
+}
+
+unsigned IirBiQuadMorph::finish(int32_t *coeffs, int &coeffShift)
+{
+	memcpy(coeffs, m_target, NUM_COEFFS_PER_STAGE*m_targetStages * sizeof(int32_t));
+	coeffShift = m_targetShift;
+	return m_targetStages;
+}
+
+// Run one sample through all the stages, same arithmetic as arm_biquad_cascade_df1_fast_q31().
+// Each multiply-accumulate keeps the rounded upper 32 bits, as CMSIS mult_32x32_keep32_R() does.
+// The state is {x[n-1], x[n-2], y[n-1], y[n-2]} per stage.
+static inline int32_t filterSampleQ31(int32_t x, const int32_t *coeffs, int32_t *state, unsigned numStages, int shift)
+{
+	constexpr int64_t ROUND = 0x80000000LL;
+	for (unsigned stage=0; stage<numStages; stage++) {
+		int32_t acc;
+		acc = (int32_t)((((int64_t)coeffs[1] * state[0]) + ROUND) >> 32);
+		acc = (int32_t)((((int64_t)acc << 32) + ((int64_t)coeffs[0] * x) + ROUND) >> 32);
+		acc = (int32_t)((((int64_t)acc << 32) + ((int64_t)coeffs[2] * state[1]) + ROUND) >> 32);
+		acc = (int32_t)((((int64_t)acc << 32) + ((int64_t)coeffs[3] * state[2]) + ROUND) >> 32);
+		acc = (int32_t)((((int64_t)acc << 32) + ((int64_t)coeffs[4] * state[3]) + ROUND) >> 32);
+		acc = acc << shift;
+
+		state[1] = state[0]; state[0] = x;
+		state[3] = state[2]; state[2] = acc;
+		x = acc;
+
+		coeffs += NUM_COEFFS_PER_STAGE;
+		state  += NUM_STATES_PER_STAGE;
+	}
+	return x;
+}
+
+// Run one sample through all the stages, same arithmetic as arm_biquad_cas_df1_32x64_q31().
+// The state is {x[n-1], x[n-2], y[n-1], y[n-2]} per stage with y in 1.63 format.
+static inline int32_t filterSampleHQ(int32_t x, const int32_t *coeffs, int64_t *state, unsigned numStages, int uShift)
+{
+	const int lShift = 32 - uShift;
+	for (unsigned stage=0; stage<numStages; stage++) {
+		int32_t x1 = (int32_t)state[0];
+		int32_t x2 = (int32_t)state[1];
+		int64_t acc = (int64_t)coeffs[0]*x + (int64_t)coeffs[1]*x1 + (int64_t)coeffs[2]*x2 +
+		              mult32x64(state[2], coeffs[3]) + mult32x64(state[3], coeffs[4]);
+
+		state[1] = x1; state[0] = x;
+		state[3] = state[2]; state[2] = acc << uShift;
+		x = (int32_t)(acc >> lShift);
+
+		coeffs += NUM_COEFFS_PER_STAGE;
+		state  += NUM_STATES_PER_STAGE;
+	}
+	return x;
+}
+
+// Process a block while transitioning to the coefficients picked up by morph.start(). When
+// crossfading, the new filter runs in fadeState and the caller must swap the state arrays.
+template <typename T, int32_t (*filterSample)(int32_t, const int32_t *, T *, unsigned, int)>
+static void processTransition(IirBiQuadMorph &morph, unsigned morphStages, unsigned numStages, int coeffShift,
+                              const int32_t *coeffs, T *state, T *fadeState,
+                              int16_t *output, const int16_t *input, size_t numSamples)
+{
+	if (morph.isCrossfade()) {
+		// the new filter starts from rest and its output is faded in with a Q15 ramp
+		memset(fadeState, 0, sizeof(T) * NUM_STATES_PER_STAGE * morphStages);
+		const int oldShift = coeffShift + 1;
+		const int newShift = morph.getCoeffShift() + 1;
+		for (size_t i=0; i<numSamples; i++) {
+			const int32_t oldOut = filterSample(input[i], coeffs, state, numStages, oldShift);
+			const int32_t newOut = filterSample(input[i], morph.getCoeffs(), fadeState, morphStages, newShift);
+			const int64_t gain = (static_cast<int64_t>(i+1) << 15) / numSamples;
+			output[i] = saturate16(oldOut + static_cast<int32_t>((((int64_t)newOut - oldOut) * gain) >> 15));
+		}
+	} else {
+		// stages being added start from rest
+		if (morphStages > numStages) {
+			memset(&state[NUM_STATES_PER_STAGE*numStages], 0, sizeof(T) * NUM_STATES_PER_STAGE * (morphStages-numStages));
+		}
+		const int shift = morph.getCoeffShift() + 1;
+		for (size_t i=0; i<numSamples; i++) {
+			output[i] = saturate16(filterSample(input[i], morph.getCoeffs(), state, morphStages, shift));
+			morph.step();
+		}
+	}
+}
+
 IirBiQuadFilter::IirBiQuadFilter(unsigned maxNumStages, const int32_t *coeffs, int coeffShift)
-: NUM_STAGES(maxNumStages)
+: NUM_STAGES(maxNumStages), m_morph(maxNumStages)
 {
 	m_coeffs = new int32_t[NUM_COEFFS_PER_STAGE*maxNumStages];
 	//memcpy(m_coeffs, coeffs, 5*numStages * sizeof(int32_t));
 
 	m_state  = new int32_t[NUM_STATES_PER_STAGE*maxNumStages];
+	m_fadeState = new int32_t[NUM_STATES_PER_STAGE*maxNumStages];
 	//arm_biquad_cascade_df1_init_q31(&m_iirCfg, numStages, m_coeffs, m_state, coeffShift);
 	changeFilterCoeffs(maxNumStages, coeffs, coeffShift);
 }
@@ -43,38 +232,56 @@ IirBiQuadFilter::~IirBiQuadFilter()
 {
 	if (m_coeffs) delete [] m_coeffs;
 	if (m_state)  delete [] m_state;
+	if (m_fadeState) delete [] m_fadeState;
 }
 
 void IirBiQuadFilter::changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift)
 {
+	// any previously published coefficients are now stale
+	m_morph.cancel();
 	// clear the state
-	memset(m_state, 0, sizeof(int32_t) * NUM_COEFFS_PER_STAGE * numStages);
+	memset(m_state, 0, sizeof(int32_t) * NUM_STATES_PER_STAGE * numStages);
 	// copy the coeffs
 	memcpy(m_coeffs, coeffs, NUM_COEFFS_PER_STAGE*numStages * sizeof(int32_t));
 	arm_biquad_cascade_df1_init_q31(&m_iirCfg, numStages, m_coeffs, m_state, coeffShift);
 }
 
 
+// This matches arm_biquad_cascade_df1_fast_q31() but reads and writes the 16-bit samples
+// directly. Each sample is run through all the stages before moving to the next so no
+// intermediate buffers are needed.
 bool IirBiQuadFilter::process(int16_t *output, int16_t *input, size_t numSamples)
 {
 	if (!output) return false;
 	if (!input) {
 		// send zeros
 		memset(output, 0, numSamples * sizeof(int16_t));
-	} else {
+		return true;
+	}
 
-		// create convertion buffers on teh stack
-		int32_t input32[numSamples];
-		int32_t output32[numSamples];
-		for (size_t i=0; i<numSamples; i++) {
-			input32[i] = (int32_t)(input[i]);
+	if (m_morph.isPending()) {
+		const unsigned numStages = m_iirCfg.numStages;
+		const unsigned morphStages = m_morph.start(numStages, m_iirCfg.postShift, m_coeffs, numSamples);
+		if (morphStages) {
+			processTransition<int32_t, filterSampleQ31>(m_morph, morphStages, numStages, m_iirCfg.postShift, m_coeffs,
+				m_state, m_fadeState, output, input, numSamples);
+			if (m_morph.isCrossfade()) {
+				int32_t *state = m_state;
+				m_state = m_fadeState;
+				m_fadeState = state;
+				m_iirCfg.pState = m_state;
+			}
+			int coeffShift;
+			m_iirCfg.numStages = m_morph.finish(m_coeffs, coeffShift);
+			m_iirCfg.postShift = coeffShift;
+			return true;
 		}
+	}
 
-		arm_biquad_cascade_df1_fast_q31(&m_iirCfg, input32, output32, numSamples);
-
-		for (size_t i=0; i<numSamples; i++) {
-			output[i] = (int16_t)(output32[i] & 0xffff);
-		}
+	const unsigned numStages = m_iirCfg.numStages;
+	const int shift = m_iirCfg.postShift + 1;
+	for (size_t i=0; i<numSamples; i++) {
+		output[i] = saturate16(filterSampleQ31(input[i], m_coeffs, m_state, numStages, shift));
 	}
 	return true;
 }
@@ -83,12 +290,13 @@ bool IirBiQuadFilter::process(int16_t *output, int16_t *input, size_t numSamples
 // HIGH QUALITY
 ///////////////////////////////////
 IirBiQuadFilterHQ::IirBiQuadFilterHQ(unsigned maxNumStages, const int32_t *coeffs, int coeffShift)
-: NUM_STAGES(maxNumStages)
+: NUM_STAGES(maxNumStages), m_morph(maxNumStages)
 {
 	m_coeffs = new int32_t[NUM_COEFFS_PER_STAGE*maxNumStages];
 	//memcpy(m_coeffs, coeffs, 5*numStages * sizeof(int32_t));
 
-	m_state = new int64_t[NUM_STATES_PER_STAGE*maxNumStages];;
+	m_state = new int64_t[NUM_STATES_PER_STAGE*maxNumStages];
+	m_fadeState = new int64_t[NUM_STATES_PER_STAGE*maxNumStages];
 	//arm_biquad_cas_df1_32x64_init_q31(&m_iirCfg, numStages, m_coeffs, m_state, coeffShift);
 	changeFilterCoeffs(maxNumStages, coeffs, coeffShift);
 }
@@ -97,47 +305,159 @@ IirBiQuadFilterHQ::~IirBiQuadFilterHQ()
 {
 	if (m_coeffs) delete [] m_coeffs;
 	if (m_state)  delete [] m_state;
+	if (m_fadeState) delete [] m_fadeState;
 }
 
 void IirBiQuadFilterHQ::changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift)
 {
+	// any previously published coefficients are now stale
+	m_morph.cancel();
 	// clear the state
-	memset(m_state, 0, sizeof(int32_t) * NUM_COEFFS_PER_STAGE * numStages);
+	memset(m_state, 0, sizeof(int64_t) * NUM_STATES_PER_STAGE * numStages);
 	// copy the coeffs
 	memcpy(m_coeffs, coeffs, NUM_COEFFS_PER_STAGE*numStages * sizeof(int32_t));
 	arm_biquad_cas_df1_32x64_init_q31(&m_iirCfg, numStages, m_coeffs, m_state, coeffShift);
 }
 
 
+// This matches arm_biquad_cas_df1_32x64_q31() but reads and writes the 16-bit samples
+// directly. Each sample is run through all the stages before moving to the next so no
+// intermediate buffers are needed.
 bool IirBiQuadFilterHQ::process(int16_t *output, int16_t *input, size_t numSamples)
 {
 	if (!output) return false;
 	if (!input) {
 		// send zeros
 		memset(output, 0, numSamples * sizeof(int16_t));
-	} else {
+		return true;
+	}
 
-		// create convertion buffers on teh stack
-		int32_t input32[numSamples];
-		int32_t output32[numSamples];
-		for (size_t i=0; i<numSamples; i++) {
-			input32[i] = (int32_t)(input[i]);
+	if (m_morph.isPending()) {
+		const unsigned numStages = m_iirCfg.numStages;
+		const unsigned morphStages = m_morph.start(numStages, m_iirCfg.postShift, m_coeffs, numSamples);
+		if (morphStages) {
+			processTransition<int64_t, filterSampleHQ>(m_morph, morphStages, numStages, m_iirCfg.postShift, m_coeffs,
+				m_state, m_fadeState, output, input, numSamples);
+			if (m_morph.isCrossfade()) {
+				int64_t *state = m_state;
+				m_state = m_fadeState;
+				m_fadeState = state;
+				m_iirCfg.pState = m_state;
+			}
+			int coeffShift;
+			m_iirCfg.numStages = m_morph.finish(m_coeffs, coeffShift);
+			m_iirCfg.postShift = coeffShift;
+			return true;
 		}
+	}
 
-		arm_biquad_cas_df1_32x64_q31(&m_iirCfg, input32, output32, numSamples);
+	const unsigned numStages = m_iirCfg.numStages;
+	const int uShift = m_iirCfg.postShift + 1;
+	for (size_t i=0; i<numSamples; i++) {
+		output[i] = saturate16(filterSampleHQ(input[i], m_coeffs, m_state, numStages, uShift));
+	}
+	return true;
+}
 
-		for (size_t i=0; i<numSamples; i++) {
-			output[i] = (int16_t)(output32[i] & 0xffff);
+////////////////////////////
+// NATIVE Q15
+////////////////////////////
+IirBiQuadFilterQ15::IirBiQuadFilterQ15(unsigned maxNumStages, const int16_t *coeffs, int coeffShift)
+: NUM_STAGES(maxNumStages)
+{
+	m_coeffs = new int16_t[NUM_Q15_COEFFS_PER_STAGE*maxNumStages];
+	m_state  = new int16_t[NUM_STATES_PER_STAGE*maxNumStages];
+	changeFilterCoeffs(maxNumStages, coeffs, coeffShift);
+}
+
+IirBiQuadFilterQ15::IirBiQuadFilterQ15(unsigned maxNumStages, const int32_t *coeffs, int coeffShift)
+: NUM_STAGES(maxNumStages)
+{
+	m_coeffs = new int16_t[NUM_Q15_COEFFS_PER_STAGE*maxNumStages];
+	m_state  = new int16_t[NUM_STATES_PER_STAGE*maxNumStages];
+	changeFilterCoeffs(maxNumStages, coeffs, coeffShift);
+}
+
+IirBiQuadFilterQ15::~IirBiQuadFilterQ15()
+{
+	if (m_coeffs) delete [] m_coeffs;
+	if (m_state)  delete [] m_state;
+}
+
+void IirBiQuadFilterQ15::changeFilterCoeffs(unsigned numStages, const int16_t *coeffs, int coeffShift)
+{
+	// clear the state
+	memset(m_state, 0, sizeof(int16_t) * NUM_STATES_PER_STAGE * numStages);
+	// copy the coeffs
+	memcpy(m_coeffs, coeffs, NUM_Q15_COEFFS_PER_STAGE*numStages * sizeof(int16_t));
+	arm_biquad_cascade_df1_init_q15(&m_iirCfg, numStages, m_coeffs, m_state, coeffShift);
+}
+
+// Round to nearest in 64 bits, adding the half LSB would overflow a Q31 value near full scale
+static inline int16_t roundQ31ToQ15(int32_t value)
+{
+	return saturate16(static_cast<int32_t>((static_cast<int64_t>(value) + 0x8000) >> 16));
+}
+
+void IirBiQuadFilterQ15::changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift)
+{
+	// clear the state
+	memset(m_state, 0, sizeof(int16_t) * NUM_STATES_PER_STAGE * numStages);
+
+	// round each Q31 coefficient to Q15 and insert the extra zero after b0
+	for (unsigned stage=0; stage<numStages; stage++) {
+		const int32_t *src = &coeffs[NUM_COEFFS_PER_STAGE*stage];
+		int16_t *dest = &m_coeffs[NUM_Q15_COEFFS_PER_STAGE*stage];
+		dest[0] = roundQ31ToQ15(src[0]);
+		dest[1] = 0;
+		for (unsigned i=1; i<NUM_COEFFS_PER_STAGE; i++) {
+			dest[i+1] = roundQ31ToQ15(src[i]);
 		}
 	}
+	arm_biquad_cascade_df1_init_q15(&m_iirCfg, numStages, m_coeffs, m_state, coeffShift);
+}
+
+bool IirBiQuadFilterQ15::process(int16_t *output, int16_t *input, size_t numSamples)
+{
+	if (!output) return false;
+	if (!input) {
+		// send zeros
+		memset(output, 0, numSamples * sizeof(int16_t));
+	} else {
+		arm_biquad_cascade_df1_q15(&m_iirCfg, input, output, numSamples);
+	}
 	return true;
 }
 
 ///////////////////////
 // FLOAT
 ///////////////////////
+// Convert Q31 coefficients with a shift to floating-point
+static void convertQ31Coeffs(float *dest, const int32_t *src, unsigned numCoeffs, int coeffShift)
+{
+	const float scale = ldexpf(1.0f, coeffShift - 31);
+	for (unsigned i=0; i<numCoeffs; i++) {
+		dest[i] = scale * static_cast<float>(src[i]);
+	}
+}
+
+// One sample through all stages of a transposed direct form II cascade, the same as
+// arm_biquad_cascade_df2T_f32().
+static inline float filterSampleFloat(float x, const float *coeffs, float *state, unsigned numStages)
+{
+	for (unsigned stage=0; stage<numStages; stage++) {
+		const float *c = &coeffs[NUM_COEFFS_PER_STAGE*stage];
+		float *d = &state[2*stage];
+		const float y = c[0]*x + d[0];
+		d[0] = c[1]*x + c[3]*y + d[1];
+		d[1] = c[2]*x + c[4]*y;
+		x = y;
+	}
+	return x;
+}
+
 IirBiQuadFilterFloat::IirBiQuadFilterFloat(unsigned maxNumStages, const float *coeffs)
-: NUM_STAGES(maxNumStages)
+: NUM_STAGES(maxNumStages), m_pending(-1)
 {
 	m_coeffs = new float[NUM_COEFFS_PER_STAGE*maxNumStages];
 	//memcpy(m_coeffs, coeffs, NUM_COEFFS_PER_STAGE*maxNumStages * sizeof(float));
@@ -147,22 +467,130 @@ IirBiQuadFilterFloat::IirBiQuadFilterFloat(unsigned maxNumStages, const float *c
 	changeFilterCoeffs(maxNumStages, coeffs);
 }
 
+IirBiQuadFilterFloat::IirBiQuadFilterFloat(unsigned maxNumStages, const int32_t *coeffs, int coeffShift)
+: NUM_STAGES(maxNumStages), m_pending(-1)
+{
+	m_coeffs = new float[NUM_COEFFS_PER_STAGE*maxNumStages];
+	m_state  = new float[NUM_STATES_PER_STAGE*maxNumStages];
+	changeFilterCoeffs(maxNumStages, coeffs, coeffShift);
+}
+
 IirBiQuadFilterFloat::~IirBiQuadFilterFloat()
 {
 	if (m_coeffs) delete [] m_coeffs;
 	if (m_state)  delete [] m_state;
+	if (m_published[0]) delete [] m_published[0];
+	if (m_published[1]) delete [] m_published[1];
+	if (m_delta)     delete [] m_delta;
+	if (m_fadeState) delete [] m_fadeState;
 }
 
 
 void IirBiQuadFilterFloat::changeFilterCoeffs(unsigned numStages, const float *coeffs)
 {
 	// clear the state
-	memset(m_state, 0, sizeof(float) * NUM_COEFFS_PER_STAGE * numStages);
+	memset(m_state, 0, sizeof(float) * NUM_STATES_PER_STAGE * numStages);
 	// copy the coeffs
 	memcpy(m_coeffs, coeffs, NUM_COEFFS_PER_STAGE*numStages * sizeof(float));
 	arm_biquad_cascade_df2T_init_f32(&m_iirCfg, numStages, m_coeffs, m_state);
 }
 
+void IirBiQuadFilterFloat::changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift)
+{
+	// clear the state
+	memset(m_state, 0, sizeof(float) * NUM_STATES_PER_STAGE * numStages);
+	convertQ31Coeffs(m_coeffs, coeffs, NUM_COEFFS_PER_STAGE*numStages, coeffShift);
+	arm_biquad_cascade_df2T_init_f32(&m_iirCfg, numStages, m_coeffs, m_state);
+}
+
+bool IirBiQuadFilterFloat::morphFilterCoeffs(unsigned numStages, const float *coeffs, IirBiQuadMorph::Transition transition)
+{
+	if (numStages > NUM_STAGES) { return false; }
+	memcpy(m_publishBuffer(), coeffs, NUM_COEFFS_PER_STAGE*numStages * sizeof(float));
+	m_publish(numStages, transition);
+	return true;
+}
+
+bool IirBiQuadFilterFloat::morphFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift, IirBiQuadMorph::Transition transition)
+{
+	if (numStages > NUM_STAGES) { return false; }
+	convertQ31Coeffs(m_publishBuffer(), coeffs, NUM_COEFFS_PER_STAGE*numStages, coeffShift);
+	m_publish(numStages, transition);
+	return true;
+}
+
+float *IirBiQuadFilterFloat::m_publishBuffer(void)
+{
+	if (!m_published[0]) {
+		// allocated on first use so filters that are never morphed don't pay for it
+		m_published[0] = new float[NUM_COEFFS_PER_STAGE*NUM_STAGES];
+		m_published[1] = new float[NUM_COEFFS_PER_STAGE*NUM_STAGES];
+		m_delta        = new float[NUM_COEFFS_PER_STAGE*NUM_STAGES];
+		m_fadeState    = new float[NUM_STATES_PER_STAGE*NUM_STAGES];
+	}
+	return m_published[m_writeIndex];
+}
+
+// The buffer being written is never the one marked as pending, see IirBiQuadMorph::publish()
+void IirBiQuadFilterFloat::m_publish(unsigned numStages, IirBiQuadMorph::Transition transition)
+{
+	// keep a pending crossfade, see IirBiQuadMorph::publish()
+	const int pending = m_pending.load();
+	if ((pending >= 0) && (m_publishedTransition[pending] == IirBiQuadMorph::Transition::CROSSFADE)) {
+		transition = IirBiQuadMorph::Transition::CROSSFADE;
+	}
+
+	const unsigned index = m_writeIndex;
+	m_publishedStages[index] = numStages;
+	m_publishedTransition[index] = transition;
+	m_pending.store(static_cast<int>(index));
+	m_writeIndex = index ^ 1;
+}
+
+void IirBiQuadFilterFloat::m_processTransition(float *output, const float *input, size_t numSamples)
+{
+	const int index = m_pending.exchange(-1);
+	const float *target = m_published[index];
+	const unsigned targetStages = m_publishedStages[index];
+	const unsigned numStages = m_iirCfg.numStages;
+	const float step = 1.0f / static_cast<float>(numSamples ? numSamples : 1);
+
+	if (m_publishedTransition[index] == IirBiQuadMorph::Transition::CROSSFADE) {
+		// start the new filter from rest and crossfade to it
+		memset(m_fadeState, 0, sizeof(float) * NUM_STATES_PER_STAGE * targetStages);
+		for (size_t i=0; i<numSamples; i++) {
+			const float oldSample = filterSampleFloat(input[i], m_coeffs, m_state, numStages);
+			const float newSample = filterSampleFloat(input[i], target, m_fadeState, targetStages);
+			output[i] = oldSample + step*static_cast<float>(i+1)*(newSample - oldSample);
+		}
+		float *state = m_state;
+		m_state = m_fadeState;
+		m_fadeState = state;
+	} else {
+		// interpolate the coefficients, missing stages are pass-through
+		const unsigned morphStages = (numStages > targetStages) ? numStages : targetStages;
+		for (unsigned stage=numStages; stage<morphStages; stage++) {
+			float *c = &m_coeffs[NUM_COEFFS_PER_STAGE*stage];
+			c[0] = 1.0f; c[1] = c[2] = c[3] = c[4] = 0.0f;
+			m_state[2*stage] = m_state[2*stage+1] = 0.0f;
+		}
+		for (unsigned i=0; i<NUM_COEFFS_PER_STAGE*morphStages; i++) {
+			const float passThrough = ((i % NUM_COEFFS_PER_STAGE) == 0) ? 1.0f : 0.0f;
+			const float to = (i < NUM_COEFFS_PER_STAGE*targetStages) ? target[i] : passThrough;
+			m_delta[i] = step * (to - m_coeffs[i]);
+		}
+		for (size_t i=0; i<numSamples; i++) {
+			output[i] = filterSampleFloat(input[i], m_coeffs, m_state, morphStages);
+			for (unsigned j=0; j<NUM_COEFFS_PER_STAGE*morphStages; j++) { m_coeffs[j] += m_delta[j]; }
+		}
+	}
+
+	// finish on the exact coefficients, without the init function which would clear the state
+	memcpy(m_coeffs, target, NUM_COEFFS_PER_STAGE*targetStages * sizeof(float));
+	m_iirCfg.numStages = targetStages;
+	m_iirCfg.pCoeffs = m_coeffs;
+	m_iirCfg.pState = m_state;
+}
 
 bool IirBiQuadFilterFloat::process(float *output, float *input, size_t numSamples)
 {
@@ -170,6 +598,8 @@ bool IirBiQuadFilterFloat::process(float *output, float *input, size_t numSample
 	if (!input) {
 		// send zeros
 		memset(output, 0, numSamples * sizeof(float));
+	} else if (m_pending.load() >= 0) {
+		m_processTransition(output, input, numSamples);
 	} else {
 
 		arm_biquad_cascade_df2T_f32(&m_iirCfg, input, output, numSamples);
@@ -178,5 +608,321 @@ bool IirBiQuadFilterFloat::process(float *output, float *input, size_t numSample
 	return true;
 }
 
+////////////////////////////
+// MULTI-CHANNEL
+////////////////////////////
+
+constexpr int NUM_PACKED_Q15_COEFFS_PER_STAGE = 3;
+constexpr int NUM_PACKED_Q15_STATES_PER_CHANNEL = 2;
+constexpr int NUM_X_STATES_PER_CHANNEL = 2;
+
+// Q15
+template <unsigned NUM_CHANNELS>
+IirBiQuadFilterMultiQ15<NUM_CHANNELS>::IirBiQuadFilterMultiQ15(unsigned maxNumStages, const int16_t *coeffs, int coeffShift)
+: NUM_STAGES(maxNumStages)
+{
+	m_coeffs = new int32_t[NUM_PACKED_Q15_COEFFS_PER_STAGE*maxNumStages];
+	m_state  = new int32_t[NUM_PACKED_Q15_STATES_PER_CHANNEL*NUM_CHANNELS*maxNumStages];
+	changeFilterCoeffs(maxNumStages, coeffs, coeffShift);
+}
+
+template <unsigned NUM_CHANNELS>
+IirBiQuadFilterMultiQ15<NUM_CHANNELS>::~IirBiQuadFilterMultiQ15()
+{
+	if (m_coeffs) delete [] m_coeffs;
+	if (m_state)  delete [] m_state;
+}
+
+template <unsigned NUM_CHANNELS>
+void IirBiQuadFilterMultiQ15<NUM_CHANNELS>::changeFilterCoeffs(unsigned numStages, const int16_t *coeffs, int coeffShift)
+{
+	if (numStages > NUM_STAGES) { numStages = NUM_STAGES; }
+
+	// clear the state
+	memset(m_state, 0, sizeof(int32_t) * NUM_PACKED_Q15_STATES_PER_CHANNEL * NUM_CHANNELS * numStages);
+
+	// {b0, 0, b1, b2, a1, a2} is stored as {b0, b1|b2, a1|a2}
+	for (unsigned stage=0; stage<numStages; stage++) {
+		const int16_t *src = &coeffs[NUM_Q15_COEFFS_PER_STAGE*stage];
+		int32_t *dest = &m_coeffs[NUM_PACKED_Q15_COEFFS_PER_STAGE*stage];
+		dest[0] = src[0];
+		dest[1] = simd::pack16(src[2], src[3]);
+		dest[2] = simd::pack16(src[4], src[5]);
+	}
+	m_numStages = numStages;
+	m_postShift = coeffShift;
 }
 
+// This matches arm_biquad_cascade_df1_q15(). Each channel's state is kept packed as
+// {x[n-1]|x[n-2]} and {y[n-1]|y[n-2]} so the feed-forward and feedback terms are each
+// a single dual multiply-accumulate.
+template <unsigned NUM_CHANNELS>
+void IirBiQuadFilterMultiQ15<NUM_CHANNELS>::m_process(int16_t * const *outputs, const int16_t * const *inputs,
+                                                      size_t stride, size_t numSamples)
+{
+	const int shift = 15 - m_postShift;
+
+	for (size_t i=0; i<numSamples; i++) {
+		const size_t index = i*stride;
+		int32_t x[NUM_CHANNELS];
+		for (unsigned ch=0; ch<NUM_CHANNELS; ch++) { x[ch] = inputs[ch][index]; }
+
+		const int32_t *coeffs = m_coeffs;
+		int32_t *state = m_state;
+		for (unsigned stage=0; stage<m_numStages; stage++) {
+			const int32_t b0 = coeffs[0], b12 = coeffs[1], a12 = coeffs[2];
+			for (unsigned ch=0; ch<NUM_CHANNELS; ch++) {
+				int32_t &xState = state[NUM_PACKED_Q15_STATES_PER_CHANNEL*ch];
+				int32_t &yState = state[NUM_PACKED_Q15_STATES_PER_CHANNEL*ch + 1];
+
+				int64_t acc = static_cast<int64_t>(b0) * x[ch];
+				acc = simd::smlald(b12, xState, acc);
+				acc = simd::smlald(a12, yState, acc);
+				const int32_t out = saturate16(static_cast<int32_t>(acc >> shift));
+
+				xState = simd::pack16(x[ch], xState);
+				yState = simd::pack16(out, yState);
+				x[ch] = out;
+			}
+			coeffs += NUM_PACKED_Q15_COEFFS_PER_STAGE;
+			state  += NUM_PACKED_Q15_STATES_PER_CHANNEL*NUM_CHANNELS;
+		}
+
+		for (unsigned ch=0; ch<NUM_CHANNELS; ch++) { outputs[ch][index] = static_cast<int16_t>(x[ch]); }
+	}
+}
+
+template <unsigned NUM_CHANNELS>
+bool IirBiQuadFilterMultiQ15<NUM_CHANNELS>::process(int16_t *output, const int16_t *input, size_t numFrames)
+{
+	if (!output) return false;
+	if (!input) {
+		// send zeros
+		memset(output, 0, NUM_CHANNELS * numFrames * sizeof(int16_t));
+		return true;
+	}
+
+	int16_t *outputs[NUM_CHANNELS];
+	const int16_t *inputs[NUM_CHANNELS];
+	for (unsigned ch=0; ch<NUM_CHANNELS; ch++) {
+		outputs[ch] = output + ch;
+		inputs[ch]  = input + ch;
+	}
+	m_process(outputs, inputs, NUM_CHANNELS, numFrames);
+	return true;
+}
+
+template <unsigned NUM_CHANNELS>
+bool IirBiQuadFilterMultiQ15<NUM_CHANNELS>::process(int16_t * const *outputs, const int16_t * const *inputs, size_t numSamples)
+{
+	if (!outputs || !inputs) return false;
+	for (unsigned ch=0; ch<NUM_CHANNELS; ch++) {
+		if (!outputs[ch] || !inputs[ch]) return false;
+	}
+	m_process(outputs, inputs, 1, numSamples);
+	return true;
+}
+
+template class IirBiQuadFilterMultiQ15<2>;
+template class IirBiQuadFilterMultiQ15<4>;
+
+// HIGH QUALITY Q31
+template <unsigned NUM_CHANNELS>
+IirBiQuadFilterMultiHQ<NUM_CHANNELS>::IirBiQuadFilterMultiHQ(unsigned maxNumStages, const int32_t *coeffs, int coeffShift)
+: NUM_STAGES(maxNumStages)
+{
+	m_coeffs = new int32_t[NUM_COEFFS_PER_STAGE*maxNumStages];
+	m_xState = new int32_t[NUM_X_STATES_PER_CHANNEL*NUM_CHANNELS*maxNumStages];
+	m_yState = new int64_t[NUM_X_STATES_PER_CHANNEL*NUM_CHANNELS*maxNumStages];
+	changeFilterCoeffs(maxNumStages, coeffs, coeffShift);
+}
+
+template <unsigned NUM_CHANNELS>
+IirBiQuadFilterMultiHQ<NUM_CHANNELS>::~IirBiQuadFilterMultiHQ()
+{
+	if (m_coeffs) delete [] m_coeffs;
+	if (m_xState) delete [] m_xState;
+	if (m_yState) delete [] m_yState;
+}
+
+template <unsigned NUM_CHANNELS>
+void IirBiQuadFilterMultiHQ<NUM_CHANNELS>::changeFilterCoeffs(unsigned numStages, const int32_t *coeffs, int coeffShift)
+{
+	if (numStages > NUM_STAGES) { numStages = NUM_STAGES; }
+
+	// clear the state
+	memset(m_xState, 0, sizeof(int32_t) * NUM_X_STATES_PER_CHANNEL * NUM_CHANNELS * numStages);
+	memset(m_yState, 0, sizeof(int64_t) * NUM_X_STATES_PER_CHANNEL * NUM_CHANNELS * numStages);
+	// copy the coeffs
+	memcpy(m_coeffs, coeffs, NUM_COEFFS_PER_STAGE*numStages * sizeof(int32_t));
+	m_numStages = numStages;
+	m_postShift = coeffShift;
+}
+
+// This matches arm_biquad_cas_df1_32x64_q31(), with all channels run through each stage
+// before moving to the next.
+template <unsigned NUM_CHANNELS>
+void IirBiQuadFilterMultiHQ<NUM_CHANNELS>::m_process(int16_t * const *outputs, const int16_t * const *inputs,
+                                                     size_t stride, size_t numSamples)
+{
+	const int uShift = m_postShift + 1;
+	const int lShift = 32 - uShift;
+
+	for (size_t i=0; i<numSamples; i++) {
+		const size_t index = i*stride;
+		int32_t x[NUM_CHANNELS];
+		for (unsigned ch=0; ch<NUM_CHANNELS; ch++) { x[ch] = inputs[ch][index]; }
+
+		const int32_t *coeffs = m_coeffs;
+		int32_t *xState = m_xState;
+		int64_t *yState = m_yState;
+		for (unsigned stage=0; stage<m_numStages; stage++) {
+			const int32_t b0 = coeffs[0], b1 = coeffs[1], b2 = coeffs[2], a1 = coeffs[3], a2 = coeffs[4];
+			for (unsigned ch=0; ch<NUM_CHANNELS; ch++) {
+				int32_t *xs = &xState[NUM_X_STATES_PER_CHANNEL*ch];
+				int64_t *ys = &yState[NUM_X_STATES_PER_CHANNEL*ch];
+
+				const int64_t acc = (int64_t)b0*x[ch] + (int64_t)b1*xs[0] + (int64_t)b2*xs[1] +
+				                    mult32x64(ys[0], a1) + mult32x64(ys[1], a2);
+
+				xs[1] = xs[0]; xs[0] = x[ch];
+				ys[1] = ys[0]; ys[0] = acc << uShift;
+				x[ch] = (int32_t)(acc >> lShift);
+			}
+			coeffs += NUM_COEFFS_PER_STAGE;
+			xState += NUM_X_STATES_PER_CHANNEL*NUM_CHANNELS;
+			yState += NUM_X_STATES_PER_CHANNEL*NUM_CHANNELS;
+		}
+
+		for (unsigned ch=0; ch<NUM_CHANNELS; ch++) { outputs[ch][index] = saturate16(x[ch]); }
+	}
+}
+
+template <unsigned NUM_CHANNELS>
+bool IirBiQuadFilterMultiHQ<NUM_CHANNELS>::process(int16_t *output, const int16_t *input, size_t numFrames)
+{
+	if (!output) return false;
+	if (!input) {
+		// send zeros
+		memset(output, 0, NUM_CHANNELS * numFrames * sizeof(int16_t));
+		return true;
+	}
+
+	int16_t *outputs[NUM_CHANNELS];
+	const int16_t *inputs[NUM_CHANNELS];
+	for (unsigned ch=0; ch<NUM_CHANNELS; ch++) {
+		outputs[ch] = output + ch;
+		inputs[ch]  = input + ch;
+	}
+	m_process(outputs, inputs, NUM_CHANNELS, numFrames);
+	return true;
+}
+
+template <unsigned NUM_CHANNELS>
+bool IirBiQuadFilterMultiHQ<NUM_CHANNELS>::process(int16_t * const *outputs, const int16_t * const *inputs, size_t numSamples)
+{
+	if (!outputs || !inputs) return false;
+	for (unsigned ch=0; ch<NUM_CHANNELS; ch++) {
+		if (!outputs[ch] || !inputs[ch]) return false;
+	}
+	m_process(outputs, inputs, 1, numSamples);
+	return true;
+}
+
+template class IirBiQuadFilterMultiHQ<2>;
+template class IirBiQuadFilterMultiHQ<4>;
+
+// FLOAT
+template <unsigned NUM_CHANNELS>
+IirBiQuadFilterMultiFloat<NUM_CHANNELS>::IirBiQuadFilterMultiFloat(unsigned maxNumStages, const float *coeffs)
+: NUM_STAGES(maxNumStages)
+{
+	m_coeffs = new float[NUM_COEFFS_PER_STAGE*maxNumStages];
+	m_state  = new float[NUM_X_STATES_PER_CHANNEL*NUM_CHANNELS*maxNumStages];
+	changeFilterCoeffs(maxNumStages, coeffs);
+}
+
+template <unsigned NUM_CHANNELS>
+IirBiQuadFilterMultiFloat<NUM_CHANNELS>::~IirBiQuadFilterMultiFloat()
+{
+	if (m_coeffs) delete [] m_coeffs;
+	if (m_state)  delete [] m_state;
+}
+
+template <unsigned NUM_CHANNELS>
+void IirBiQuadFilterMultiFloat<NUM_CHANNELS>::changeFilterCoeffs(unsigned numStages, const float *coeffs)
+{
+	if (numStages > NUM_STAGES) { numStages = NUM_STAGES; }
+
+	// clear the state
+	memset(m_state, 0, sizeof(float) * NUM_X_STATES_PER_CHANNEL * NUM_CHANNELS * numStages);
+	// copy the coeffs
+	memcpy(m_coeffs, coeffs, NUM_COEFFS_PER_STAGE*numStages * sizeof(float));
+	m_numStages = numStages;
+}
+
+// This matches arm_biquad_cascade_df2T_f32(), with all channels run through each stage
+// before moving to the next.
+template <unsigned NUM_CHANNELS>
+void IirBiQuadFilterMultiFloat<NUM_CHANNELS>::m_process(float * const *outputs, const float * const *inputs,
+                                                        size_t stride, size_t numSamples)
+{
+	for (size_t i=0; i<numSamples; i++) {
+		const size_t index = i*stride;
+		float x[NUM_CHANNELS];
+		for (unsigned ch=0; ch<NUM_CHANNELS; ch++) { x[ch] = inputs[ch][index]; }
+
+		const float *coeffs = m_coeffs;
+		float *state = m_state;
+		for (unsigned stage=0; stage<m_numStages; stage++) {
+			const float b0 = coeffs[0], b1 = coeffs[1], b2 = coeffs[2], a1 = coeffs[3], a2 = coeffs[4];
+			for (unsigned ch=0; ch<NUM_CHANNELS; ch++) {
+				float *d = &state[NUM_X_STATES_PER_CHANNEL*ch];
+				const float y = b0*x[ch] + d[0];
+				d[0] = b1*x[ch] + a1*y + d[1];
+				d[1] = b2*x[ch] + a2*y;
+				x[ch] = y;
+			}
+			coeffs += NUM_COEFFS_PER_STAGE;
+			state  += NUM_X_STATES_PER_CHANNEL*NUM_CHANNELS;
+		}
+
+		for (unsigned ch=0; ch<NUM_CHANNELS; ch++) { outputs[ch][index] = x[ch]; }
+	}
+}
+
+template <unsigned NUM_CHANNELS>
+bool IirBiQuadFilterMultiFloat<NUM_CHANNELS>::process(float *output, const float *input, size_t numFrames)
+{
+	if (!output) return false;
+	if (!input) {
+		// send zeros
+		memset(output, 0, NUM_CHANNELS * numFrames * sizeof(float));
+		return true;
+	}
+
+	float *outputs[NUM_CHANNELS];
+	const float *inputs[NUM_CHANNELS];
+	for (unsigned ch=0; ch<NUM_CHANNELS; ch++) {
+		outputs[ch] = output + ch;
+		inputs[ch]  = input + ch;
+	}
+	m_process(outputs, inputs, NUM_CHANNELS, numFrames);
+	return true;
+}
+
+template <unsigned NUM_CHANNELS>
+bool IirBiQuadFilterMultiFloat<NUM_CHANNELS>::process(float * const *outputs, const float * const *inputs, size_t numSamples)
+{
+	if (!outputs || !inputs) return false;
+	for (unsigned ch=0; ch<NUM_CHANNELS; ch++) {
+		if (!outputs[ch] || !inputs[ch]) return false;
+	}
+	m_process(outputs, inputs, 1, numSamples);
+	return true;
+}
+
+template class IirBiQuadFilterMultiFloat<2>;
+template class IirBiQuadFilterMultiFloat<4>;
+
+}
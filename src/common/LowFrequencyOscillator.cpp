@@ -21,126 +21,243 @@
 #include <assert.h>
 #include "Audio.h"
 #include "LibBasicFunctions.h"
+#include "LibFilterDesign.h"
 
 namespace BALibrary {
 
-template <class T>
-void LowFrequencyOscillatorVector<T>::m_initPhase(T radiansPerSample)
+constexpr unsigned SINE_TABLE_BITS = 9;
+constexpr unsigned SINE_TABLE_SIZE = 1U << SINE_TABLE_BITS;
+constexpr unsigned SINE_INDEX_SHIFT = 32 - SINE_TABLE_BITS;
+constexpr uint32_t QUARTER_CYCLE = 0x40000000; ///< PI/2 radians of phase
+constexpr uint32_t HALF_CYCLE    = 0x80000000; ///< PI radians of phase
+constexpr float PHASE_PER_CYCLE = 4294967296.0f; ///< 2^32
+constexpr float Q15_TO_FLOAT = 1.0f / 32767.0f;
+
+// The extra entry at the end is a copy of the first so interpolation never needs to wrap
+struct SineTable {
+	int16_t values[SINE_TABLE_SIZE+1];
+};
+
+constexpr SineTable makeSineTable()
 {
-	// Initialize the phase vector starting at 0 radians, and incrementing
-	// by radiansPerSample for each element in the vector.
-	T initialPhase[AUDIO_BLOCK_SAMPLES];
-	for (auto i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
-		initialPhase[i] = (T)i * radiansPerSample;
+	SineTable table = {};
+	for (unsigned i=0; i <= SINE_TABLE_SIZE; i++) {
+		const double value = 32767.0 * constexprMath::sin((2.0 * constexprMath::PI_DOUBLE * i) / SINE_TABLE_SIZE);
+		table.values[i] = static_cast<int16_t>(constexprMath::roundNearest(value));
 	}
-	m_radiansPerBlock = radiansPerSample * (T)AUDIO_BLOCK_SAMPLES;
+	return table;
+}
 
-	// there could be different threads controlling the LFO rate and consuming
-	// the LFO output, so we need to protected the m_phaseVec for thread-safety.
-	while (m_phaseLock.test_and_set()) {}
-	memcpy(m_phaseVec, initialPhase, sizeof(T)*AUDIO_BLOCK_SAMPLES);
-	m_phaseLock.clear();
+static constexpr SineTable SINE_TABLE = makeSineTable();
+
+// Linearly interpolate the sine table. The top bits of the phase select the table
+// entry and the next 15 bits are the fraction between entries.
+static inline int32_t sineLookup(uint32_t phase)
+{
+	const unsigned index = phase >> SINE_INDEX_SHIFT;
+	const int32_t fraction = (phase >> (SINE_INDEX_SHIFT - 15)) & 0x7FFF;
+	const int32_t a = SINE_TABLE.values[index];
+	const int32_t b = SINE_TABLE.values[index+1];
+	return a + (((b - a) * fraction) >> 15);
 }
 
 // This function takes in the frequency of the LFO in hertz and uses knowledge
-// about the the audio sample rate to calcuate the correct radians per sample.
+// about the the audio sample rate to calcuate the correct phase change per sample.
 template <class T>
 void LowFrequencyOscillatorVector<T>::setRateAudio(float frequencyHz)
 {
-	T radiansPerSample;
-	if (frequencyHz == 0) {
-		radiansPerSample = 0;
-	} else {
-		T periodSamples = AUDIO_SAMPLE_RATE_EXACT / frequencyHz;
-		radiansPerSample = (T)TWO_PI_F / periodSamples;
-	}
-	m_initPhase(radiansPerSample);
+	setRateRatio(frequencyHz / AUDIO_SAMPLE_RATE_EXACT);
 }
 
-
 // This function is used when the LFO is being called at some rate other than
-// the audio rate. Here you can manually set the radians per sample as a fraction
-// of 2*PI
+// the audio rate. Here you can manually set the phase change per sample as a fraction
+// of a full cycle. Only the increment is changed, the phase is left alone so there is
+// no discontinuity, and a single atomic store means getNextVector() never needs to wait
+// or skip an update.
 template <class T>
 void LowFrequencyOscillatorVector<T>::setRateRatio(float ratio)
 {
-	T radiansPerSample;
-	if (ratio == 0) {
-		radiansPerSample = 0;
-	} else {
-		radiansPerSample = (T)TWO_PI_F * ratio;
+	uint32_t increment = 0;
+	if (ratio > 0) {
+		// phase is modulo 2^32 so any whole cycles are discarded
+		increment = static_cast<uint32_t>(static_cast<uint64_t>(ratio * PHASE_PER_CYCLE + 0.5f));
 	}
-	m_initPhase(radiansPerSample);
+	m_phaseIncrement.store(increment, std::memory_order_relaxed);
 }
 
-// When this function is called, it will update the phase vector by incrementing by
-// radians per block which is radians per sample * block size.
 template <class T>
-inline void LowFrequencyOscillatorVector<T>::m_updatePhase()
+LowFrequencyOscillatorVector<T>::~LowFrequencyOscillatorVector()
 {
-	if (m_phaseLock.test_and_set()) { return; }
+	if (m_phaseOffsets) delete [] m_phaseOffsets;
+	if (m_phaseOutputs) delete [] m_phaseOutputs;
+	if (m_phaseVectors) delete [] m_phaseVectors;
+}
+
+template <class T>
+bool LowFrequencyOscillatorVector<T>::setPhaseOffsets(unsigned numPhases, const float *phaseOffsetsDegrees)
+{
+	if (!phaseOffsetsDegrees || (numPhases == 0)) { return false; }
+
+	if (numPhases != m_numPhases) {
+		if (m_phaseOffsets) delete [] m_phaseOffsets;
+		if (m_phaseOutputs) delete [] m_phaseOutputs;
+		if (m_phaseVectors) delete [] m_phaseVectors;
 
-	if (m_phaseVec[0] > TWO_PI_F) {
-		arm_offset_f32(m_phaseVec, -TWO_PI_F + m_radiansPerBlock, m_phaseVec, AUDIO_BLOCK_SAMPLES);
-	} else {
-		arm_offset_f32(m_phaseVec, m_radiansPerBlock, m_phaseVec, AUDIO_BLOCK_SAMPLES);
+		m_phaseOffsets = new uint32_t[numPhases];
+		m_phaseOutputs = new T[numPhases*AUDIO_BLOCK_SAMPLES];
+		m_phaseVectors = new T*[numPhases];
+		for (unsigned k=0; k<numPhases; k++) {
+			m_phaseVectors[k] = &m_phaseOutputs[k*AUDIO_BLOCK_SAMPLES];
+		}
+	}
+
+	for (unsigned k=0; k<numPhases; k++) {
+		float turns = phaseOffsetsDegrees[k] / 360.0f;
+		turns -= floorf(turns); // reduce to [0.0, 1.0)
+		m_phaseOffsets[k] = static_cast<uint32_t>(static_cast<uint64_t>(turns * PHASE_PER_CYCLE + 0.5f));
 	}
-	m_phaseLock.clear();
+	m_numPhases = numPhases;
+	return true;
 }
 
-// This function will compute the vector of samples for the output waveform using
-// the current phase vector.
+// xorshift32, cheap and plenty random enough for modulation
 template <class T>
-T *LowFrequencyOscillatorVector<T>::getNextVector()
+int16_t LowFrequencyOscillatorVector<T>::m_nextRandom()
+{
+	uint32_t x = m_randomState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	m_randomState = x;
+	// the levels are symmetric like the other waveforms, -32768 is folded to -32767
+	const int32_t level = static_cast<int16_t>(x >> 16);
+	return static_cast<int16_t>((level < -32767) ? -32767 : level);
+}
+
+template <class T>
+void LowFrequencyOscillatorVector<T>::m_initRandom()
+{
+	for (auto &level : m_randomLevels) { level = m_nextRandom(); }
+}
+
+template <class T>
+inline T fromQ15(int32_t value);
+
+template <>
+inline float fromQ15<float>(int32_t value) { return Q15_TO_FLOAT * value; }
+
+template <>
+inline int16_t fromQ15<int16_t>(int32_t value) { return static_cast<int16_t>(value); }
+
+// Compute a block for each output, every output uses the same phase plus its offset
+template <class T, class Wave>
+static inline uint32_t generateWave(T * const *dests, const uint32_t *offsets, unsigned numOutputs,
+                                    uint32_t phase, uint32_t increment, Wave wave)
+{
+	for (auto i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		for (unsigned k=0; k<numOutputs; k++) {
+			dests[k][i] = fromQ15<T>(wave(phase + offsets[k]));
+		}
+		phase += increment;
+	}
+	return phase;
+}
+
+static inline int32_t squareWave(uint32_t phase)
 {
+	return (phase < HALF_CYCLE) ? -32767 : 32767;
+}
+
+// A "Triangle Cos" starts at +1.0 and moves to -1.0 from angles 0 to PI radians,
+// then back to +1.0 at 2*PI.
+static inline int32_t triangleWave(uint32_t phase)
+{
+	const int32_t position = phase >> 16;
+	return (position < 32768) ? (32767 - 2*position) : (2*(position - 32768) - 32767);
+}
+
+// A sawtooth moves from +1.0 at 0 radians to -1.0 at 2*PI
+static inline int32_t sawtoothWave(uint32_t phase)
+{
+	const int32_t value = 32767 - static_cast<int32_t>(phase >> 16);
+	return (value < -32767) ? -32767 : value;
+}
+
+// Move between two random levels along a raised cosine, (1 - cos(pi*phase))/2, so both
+// the waveform and its slope are continuous.
+static inline int32_t randomWave(uint32_t phase, int32_t start, int32_t end)
+{
+	const int32_t weight = (32767 - sineLookup((phase >> 1) + QUARTER_CYCLE)) >> 1;
+	return start + (((end - start) * weight) >> 15);
+}
+
+// This function will compute the next block of waveform values for each output
+// starting at the current phase.
+template <class T>
+void LowFrequencyOscillatorVector<T>::m_generate(T * const *dests, const uint32_t *offsets, unsigned numOutputs)
+{
+	const uint32_t increment = m_phaseIncrement.load(std::memory_order_relaxed);
+	uint32_t phase = m_phase;
+
 	switch(m_waveform) {
 	case Waveform::SINE :
-		for (auto i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
-			m_outputVec[i] = arm_sin_f32(m_phaseVec[i]);
-		}
+		phase = generateWave(dests, offsets, numOutputs, phase, increment, sineLookup);
 		break;
 	case Waveform::SQUARE :
-		for (auto i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
-
-		    if (m_phaseVec[i] < PI_F) {
-		        m_outputVec[i] = -1.0f;
-		    } else {
-		        m_outputVec[i] = 1.0f;
-		    }
-		}
+		phase = generateWave(dests, offsets, numOutputs, phase, increment, squareWave);
 		break;
 	case Waveform::TRIANGLE :
-	    // A triangle is made up from two different line equations of form y=mx+b
-	    // where m = +2/pi or -2/pi. A "Triangle Cos" starts at +1.0 and moves to
-	    // -1.0 from angles 0 to PI radians.
-		for (auto i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
-            if (m_phaseVec[i] < PI_F) {
-                // y = (-2/pi)*x + 1.0
-                m_outputVec[i] = (TRIANGE_NEG_SLOPE * m_phaseVec[i]) + 1.0f;
-            } else {
-                // y = (2/pi)*x -1.0
-                m_outputVec[i] = (TRIANGE_POS_SLOPE * (m_phaseVec[i]-PI_F)) - 1.0f;
-            }
-		}
+		phase = generateWave(dests, offsets, numOutputs, phase, increment, triangleWave);
 		break;
 	case Waveform::SAWTOOTH :
-	    // A sawtooth is made up of a single equation of the form y=mx+b
-	    // where m = -pi + 1.0
-	    for (auto i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
-	        m_outputVec[i] = (SAWTOOTH_SLOPE * m_phaseVec[i]) + 1.0f;
-	    }
-	    break;
+		phase = generateWave(dests, offsets, numOutputs, phase, increment, sawtoothWave);
+		break;
 	case Waveform::RANDOM :
+		// A new random level is chosen once per cycle. An output whose offset carries it
+		// into the next cycle moves between the next pair of levels.
+		for (auto i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+			for (unsigned k=0; k<numOutputs; k++) {
+				const uint32_t outputPhase = phase + offsets[k];
+				const unsigned cycle = (outputPhase < phase) ? 1 : 0;
+				dests[k][i] = fromQ15<T>(randomWave(outputPhase, m_randomLevels[cycle], m_randomLevels[cycle+1]));
+			}
+
+			const uint32_t nextPhase = phase + increment;
+			if (nextPhase < phase) {
+				// wrapped into the next cycle
+				m_randomLevels[0] = m_randomLevels[1];
+				m_randomLevels[1] = m_randomLevels[2];
+				m_randomLevels[2] = m_nextRandom();
+			}
+			phase = nextPhase;
+		}
 		break;
 	default :
 		assert(0); // This occurs if a Waveform type is missing from the switch statement
 	}
 
-	m_updatePhase();
+	m_phase = phase;
+}
+
+template <class T>
+T *LowFrequencyOscillatorVector<T>::getNextVector()
+{
+	const uint32_t offset = 0;
+	T *dest = m_outputVec;
+	m_generate(&dest, &offset, 1);
 	return m_outputVec;
 }
 
+template <class T>
+T * const *LowFrequencyOscillatorVector<T>::getNextVectors()
+{
+	if (m_numPhases == 0) { return nullptr; }
+	m_generate(m_phaseVectors, m_phaseOffsets, m_numPhases);
+	return m_phaseVectors;
+}
+
 template class LowFrequencyOscillatorVector<float>;
+template class LowFrequencyOscillatorVector<int16_t>;
 
 } // namespace BALibrary
 
@@ -0,0 +1,265 @@
+/*
+ * NonUniformConvolution.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Audio.h"
+#include "LibBasicFunctions.h"
+
+namespace BALibrary {
+
+constexpr size_t DEFAULT_TAIL_PARTITION_SAMPLES = 2048;
+constexpr size_t MIN_TAIL_PARTITION_SAMPLES = 1024; // a tail spectrum must hold whole slices
+constexpr float Q15_MAX = 32767.0f;
+
+// Block floating point, the largest magnitude in the block maps to full scale
+static float calcBlockScale(const float *src, size_t numValues)
+{
+	float peak = 0.0f;
+	for (size_t i=0; i<numValues; i++) {
+		const float magnitude = (src[i] >= 0.0f) ? src[i] : -src[i];
+		peak = (magnitude > peak) ? magnitude : peak;
+	}
+	return peak / Q15_MAX;
+}
+
+static void quantize(int16_t *dest, const float *src, size_t numValues, float scale)
+{
+	const float inverse = (scale > 0.0f) ? (1.0f / scale) : 0.0f;
+	for (size_t i=0; i<numValues; i++) {
+		const float value = inverse * src[i];
+		dest[i] = static_cast<int16_t>(value + ((value >= 0.0f) ? 0.5f : -0.5f));
+	}
+}
+
+NonUniformConvolution::NonUniformConvolution(ExtMemSlot *slot, size_t tailPartitionSamples)
+: m_slot(slot),
+  m_partitionSamples(((tailPartitionSamples >= MIN_TAIL_PARTITION_SAMPLES) && !(tailPartitionSamples & (tailPartitionSamples-1))) ?
+		  tailPartitionSamples : DEFAULT_TAIL_PARTITION_SAMPLES),
+  m_spectrumWords(2*m_partitionSamples),
+  m_periodBlocks(m_partitionSamples / AUDIO_BLOCK_SAMPLES),
+  m_loading(false), m_tailPartitions(0)
+{
+	if (m_partitionSamples != tailPartitionSamples) {
+		if (Serial) { Serial.println("NonUniformConvolution: ERROR tail partitions must be a power of two from 1024, using 2048"); }
+	}
+
+	// the head covers the two tail periods before the tail output is ready
+	m_head = new UniformConvolution(2*m_partitionSamples);
+
+	m_frame        = new float[m_spectrumWords]();
+	m_work         = new float[m_spectrumWords]();
+	m_accumulator  = new float[m_spectrumWords]();
+	m_tailOutput   = new float[m_partitionSamples]();
+	m_inputSpectra = new int16_t[MAX_TAIL_PARTITIONS * m_spectrumWords]();
+	m_slices[0]    = new int16_t[SLICE_WORDS]();
+	m_slices[1]    = new int16_t[SLICE_WORDS]();
+	arm_rfft_fast_init_f32(&m_fftInstance, m_spectrumWords);
+}
+
+NonUniformConvolution::~NonUniformConvolution()
+{
+	if (m_head)         delete m_head;
+	if (m_frame)        delete [] m_frame;
+	if (m_work)         delete [] m_work;
+	if (m_accumulator)  delete [] m_accumulator;
+	if (m_tailOutput)   delete [] m_tailOutput;
+	if (m_inputSpectra) delete [] m_inputSpectra;
+	if (m_slices[0])    delete [] m_slices[0];
+	if (m_slices[1])    delete [] m_slices[1];
+}
+
+size_t NonUniformConvolution::getMaxSamples() const
+{
+	size_t tailPartitions = m_slot ? (m_slot->size() / (sizeof(int16_t) * m_spectrumWords)) : 0;
+	tailPartitions = (tailPartitions < MAX_TAIL_PARTITIONS) ? tailPartitions : MAX_TAIL_PARTITIONS;
+	return (2 + tailPartitions) * m_partitionSamples;
+}
+
+bool NonUniformConvolution::setImpulseResponse(const float *ir, size_t numSamples, float gain)
+{
+	return m_loadPartitions(ir, nullptr, numSamples, gain);
+}
+
+bool NonUniformConvolution::setImpulseResponse(const int16_t *ir, size_t numSamples, float gain)
+{
+	return m_loadPartitions(nullptr, ir, numSamples, gain);
+}
+
+void NonUniformConvolution::process(float *output, const float *input)
+{
+	// The tail stops using the slot and the FFT buffers as soon as a load starts
+	if (m_loading.load(std::memory_order_acquire)) { m_framePartitions = 0; }
+
+	if (m_block == 0) { m_startPeriod(); }
+	const size_t offset = m_block * AUDIO_BLOCK_SAMPLES;
+	memcpy(m_frame + m_partitionSamples + offset, input, AUDIO_BLOCK_SAMPLES * sizeof(float));
+
+	m_head->process(output, input);
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		output[i] += m_tailOutput[offset + i];
+	}
+
+	// Slice n is read during block n and multiplied during block n+1, while slice n+1 is read
+	const unsigned numSlices = (m_framePartitions * m_spectrumWords) / SLICE_WORDS;
+	const bool sliceArrived = (m_block > 0) && (m_block <= numSlices);
+	if (sliceArrived) {
+		while (m_slot->isReadBusy()) {}
+	}
+	if (m_block < numSlices) { m_requestSlice(m_block); }
+	if (sliceArrived) { m_accumulateSlice(m_block - 1); }
+
+	if (m_block + 1 == m_periodBlocks) { m_finishPeriod(); }
+	m_block = (m_block + 1 < m_periodBlocks) ? m_block + 1 : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////////
+
+// The input frame is complete, transform it into the newest input spectrum
+void NonUniformConvolution::m_startPeriod()
+{
+	m_newestInput = (m_newestInput + 1 < MAX_TAIL_PARTITIONS) ? m_newestInput + 1 : 0;
+	int16_t *newest = m_inputSpectra + m_newestInput * m_spectrumWords;
+
+	m_framePartitions = m_loading.load(std::memory_order_acquire) ? 0 : m_tailPartitions.load(std::memory_order_acquire);
+	if (m_framePartitions > 0) {
+		memcpy(m_work, m_frame, m_spectrumWords * sizeof(float));
+		arm_rfft_fast_f32(&m_fftInstance, m_work, m_accumulator, 0);
+		m_inputScales[m_newestInput] = calcBlockScale(m_accumulator, m_spectrumWords);
+		quantize(newest, m_accumulator, m_spectrumWords, m_inputScales[m_newestInput]);
+		memset(m_accumulator, 0, m_spectrumWords * sizeof(float));
+	} else {
+		m_inputScales[m_newestInput] = 0.0f; // the frame was not transformed
+	}
+
+	// overlap-save, the current frame becomes the previous one
+	memcpy(m_frame, m_frame + m_partitionSamples, m_partitionSamples * sizeof(float));
+}
+
+// The tail spectra are stored back to back in the slot, a slice never spans two partitions
+void NonUniformConvolution::m_requestSlice(unsigned slice)
+{
+	const size_t offsetWords = slice * SLICE_WORDS;
+	int16_t *dest = m_slices[slice & 1];
+	const size_t numWords = SLICE_WORDS;
+	m_slot->readBatch16(&offsetWords, &dest, &numWords, 1);
+}
+
+// Multiply accumulate a slice of a tail spectrum with the input spectrum from as many
+// periods ago as its partition index. Each complex bin takes one SMUSD and one SMUADX.
+void NonUniformConvolution::m_accumulateSlice(unsigned slice)
+{
+	const size_t word = slice * SLICE_WORDS;
+	const size_t partition = word / m_spectrumWords;
+	const size_t offset = word - partition * m_spectrumWords;
+	const unsigned input = (m_newestInput + MAX_TAIL_PARTITIONS - partition) % MAX_TAIL_PARTITIONS;
+
+	const float gain = m_tailScales[partition] * m_inputScales[input];
+	const int16_t *h = m_slices[slice & 1];
+	const int16_t *x = m_inputSpectra + input * m_spectrumWords + offset;
+	float *acc = m_accumulator + offset;
+
+	size_t i = 0;
+	if (offset == 0) {
+		// DC and Nyquist are packed as the first pair and are real
+		acc[0] += gain * static_cast<float>(x[0] * h[0]);
+		acc[1] += gain * static_cast<float>(x[1] * h[1]);
+		i = 2;
+	}
+	for (; i<SLICE_WORDS; i+=2) {
+		const int32_t xPair = simd::load2(x + i);
+		const int32_t hPair = simd::load2(h + i);
+		acc[i]   += gain * static_cast<float>(simd::smusd(xPair, hPair));
+		acc[i+1] += gain * static_cast<float>(simd::smuadx(xPair, hPair));
+	}
+}
+
+// Transform the sum back, the second half is the tail output for the next period
+void NonUniformConvolution::m_finishPeriod()
+{
+	if (m_framePartitions == 0) {
+		memset(m_tailOutput, 0, m_partitionSamples * sizeof(float));
+		return;
+	}
+	arm_rfft_fast_f32(&m_fftInstance, m_accumulator, m_work, 1);
+	memcpy(m_tailOutput, m_work + m_partitionSamples, m_partitionSamples * sizeof(float));
+}
+
+bool NonUniformConvolution::m_loadPartitions(const float *ir, const int16_t *irQ15, size_t numSamples, float gain)
+{
+	if (numSamples == 0) {
+		if (Serial) { Serial.println("NonUniformConvolution::setImpulseResponse(): ERROR empty impulse response"); }
+		return false;
+	}
+
+	// Stop the tail and wait for the last slice read before reusing the buffers
+	m_loading.store(true, std::memory_order_release);
+	m_tailPartitions.store(0, std::memory_order_release);
+	while (m_slot && m_slot->isReadBusy()) {}
+
+	const size_t headSamples = 2*m_partitionSamples;
+	const size_t numHead = (numSamples < headSamples) ? numSamples : headSamples;
+	if (ir) { m_head->setImpulseResponse(ir, numHead, gain); }
+	else    { m_head->setImpulseResponse(irQ15, numHead, gain); }
+
+	const size_t maxSamples = getMaxSamples();
+	if (numSamples > maxSamples) {
+		if (Serial) { Serial.println(String("NonUniformConvolution::setImpulseResponse(): impulse response truncated to ") + maxSamples); }
+		numSamples = maxSamples;
+	}
+	const size_t numPartitions = (numSamples > headSamples) ?
+		(numSamples - headSamples + m_partitionSamples - 1) / m_partitionSamples : 0;
+
+	if (numPartitions > 0) {
+		if (!m_slot->isEnabled()) { m_slot->enable(); }
+#if defined(__IMXRT1062__)
+		// KLUGE! The Teensy Audio Library doesn't support DMA buffers correctly on the T4.0.
+		setSpiDmaCopyBuffer(m_slot);
+#endif
+	}
+
+	const float scale = ir ? gain : (gain / 32768.0f);
+	for (size_t partition=0; partition<numPartitions; partition++) {
+		// each partition is zero padded to the FFT size
+		const size_t start = headSamples + partition * m_partitionSamples;
+		for (size_t i=0; i<m_spectrumWords; i++) {
+			const size_t n = start + i;
+			if ((i >= m_partitionSamples) || (n >= numSamples)) { m_work[i] = 0.0f; }
+			else { m_work[i] = scale * (ir ? ir[n] : static_cast<float>(irQ15[n])); }
+		}
+		arm_rfft_fast_f32(&m_fftInstance, m_work, m_accumulator, 0);
+		m_tailScales[partition] = calcBlockScale(m_accumulator, m_spectrumWords);
+
+		for (size_t word=0; word<m_spectrumWords; word+=SLICE_WORDS) {
+			quantize(m_slices[0], m_accumulator + word, SLICE_WORDS, m_tailScales[partition]);
+			// write a block at a time, the DMA copy buffer only holds one audio block
+			for (size_t chunk=0; chunk<SLICE_WORDS; chunk+=AUDIO_BLOCK_SAMPLES) {
+				m_slot->write16(partition * m_spectrumWords + word + chunk, m_slices[0] + chunk, AUDIO_BLOCK_SAMPLES);
+				while (m_slot->isWriteBusy()) {} // the copy buffer and slice buffer are reused
+			}
+		}
+	}
+
+	m_tailPartitions.store(numPartitions, std::memory_order_release);
+	m_loading.store(false, std::memory_order_release);
+	return true;
+}
+
+}
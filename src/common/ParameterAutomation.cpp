@@ -79,6 +79,32 @@ void ParameterAutomation<T>::reconfigure(T startValue, T endValue, size_t durati
         // value is decreasing
         m_positiveSlope = false;
     }
+
+    // The exponential curves are evaluated by repeated multiplication so only these
+    // two expf() calls are required.
+    const float k = m_positiveSlope ? EXPONENTIAL_K : -EXPONENTIAL_K;
+    m_expBlockRatio  = expf(k*m_slopeX);
+    m_expSampleRatio = expf(k*m_slopeX / static_cast<float>(AUDIO_BLOCK_SAMPLES));
+    m_expValue = m_positiveSlope ? (1.0f / EXP_EXPONENTIAL_K) : 1.0f;
+}
+
+template <class T>
+void ParameterAutomation<T>::reconfigure(T startValue, T endValue, float durationMilliseconds, const float *table, size_t tableSize)
+{
+    reconfigure(startValue, endValue, calcAudioSamples(durationMilliseconds), table, tableSize);
+}
+
+template <class T>
+void ParameterAutomation<T>::reconfigure(T startValue, T endValue, size_t durationSamples, const float *table, size_t tableSize)
+{
+    if (!table || (tableSize < 2)) {
+        if (Serial) { Serial.println("ParameterAutomation::reconfigure(): ERROR invalid lookup table, using LINEAR"); }
+        reconfigure(startValue, endValue, durationSamples, Function::LINEAR);
+        return;
+    }
+    m_table = table;
+    m_tableSize = tableSize;
+    reconfigure(startValue, endValue, durationSamples, Function::LOOKUP_TABLE);
 }
 
 
@@ -86,9 +112,31 @@ template <class T>
 void ParameterAutomation<T>::trigger()
 {
     m_currentValueX = 0.0f;
+    // Growth: f(x) = exp(k*x) / exp(k), Decay: f(x) = 1 - exp(-k*x), both start at f(0)
+    m_expValue = m_positiveSlope ? (1.0f / EXP_EXPONENTIAL_K) : 1.0f;
     m_running = true;
 }
 
+template <class T>
+float ParameterAutomation<T>::m_lookup(float x) const
+{
+    const float position = x * static_cast<float>(m_tableSize - 1);
+    const size_t index = static_cast<size_t>(position);
+    if (index >= m_tableSize - 1) { return m_table[m_tableSize - 1]; }
+    const float fraction = position - static_cast<float>(index);
+    return m_table[index] + fraction*(m_table[index+1] - m_table[index]);
+}
+
+template <class T>
+T ParameterAutomation<T>::m_scaleValue(float value) const
+{
+    if (m_positiveSlope) {
+        return m_startValue + (m_scaleY*value);
+    } else {
+        return m_startValue - (m_scaleY*value);
+    }
+}
+
 template <class T>
 T ParameterAutomation<T>::getNextValue()
 {
@@ -97,6 +145,7 @@ T ParameterAutomation<T>::getNextValue()
     }
 
     m_currentValueX += m_slopeX;
+    m_expValue *= m_expBlockRatio;
     float value;
     float returnValue;
 
@@ -105,16 +154,22 @@ T ParameterAutomation<T>::getNextValue()
 
         if (m_positiveSlope) {
             // Growth: f(x) = exp(k*x) / exp(k)
-            value = expf(EXPONENTIAL_K*m_currentValueX) / EXP_EXPONENTIAL_K;
+            value = m_expValue;
         } else {
             // Decay: f(x) = 1 - exp(-k*x)
-            value = 1.0f - expf(-EXPONENTIAL_K*m_currentValueX);
+            value = 1.0f - m_expValue;
         }
         break;
     case Function::PARABOLIC :
         value = m_currentValueX*m_currentValueX;
         break;
     case Function::LOOKUP_TABLE :
+        if (m_table) {
+            value = m_lookup(m_currentValueX);
+            break;
+        }
+        value = m_currentValueX;
+        break;
     case Function::LINEAR :
     default :
         value = m_currentValueX;
@@ -140,6 +195,79 @@ T ParameterAutomation<T>::getNextValue()
     return returnValue;
 }
 
+template <class T>
+void ParameterAutomation<T>::getNextVector(T *values)
+{
+    if (m_running == false) {
+        for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) { values[i] = m_startValue; }
+        return;
+    }
+
+    // Each curve is stepped one sample at a time from the value at the start of the block
+    const float dx = m_slopeX / static_cast<float>(AUDIO_BLOCK_SAMPLES);
+    float x = m_currentValueX;
+    unsigned i = 0;
+
+    switch(m_function) {
+    case Function::EXPONENTIAL :
+    {
+        float expValue = m_expValue;
+        for (; i<AUDIO_BLOCK_SAMPLES; i++) {
+            x += dx;
+            if (x >= 1.0f) { break; }
+            expValue *= m_expSampleRatio;
+            values[i] = m_scaleValue(m_positiveSlope ? expValue : 1.0f - expValue);
+        }
+        break;
+    }
+    case Function::PARABOLIC :
+    {
+        // x^2 by forward differences
+        float value = x*x;
+        float delta = (2.0f*x*dx) + (dx*dx);
+        const float delta2 = 2.0f*dx*dx;
+        for (; i<AUDIO_BLOCK_SAMPLES; i++) {
+            x += dx;
+            if (x >= 1.0f) { break; }
+            value += delta;
+            delta += delta2;
+            values[i] = m_scaleValue(value);
+        }
+        break;
+    }
+    case Function::LOOKUP_TABLE :
+        if (m_table) {
+            for (; i<AUDIO_BLOCK_SAMPLES; i++) {
+                x += dx;
+                if (x >= 1.0f) { break; }
+                values[i] = m_scaleValue(m_lookup(x));
+            }
+            break;
+        }
+        // fall through when no table is set
+    case Function::LINEAR :
+    default :
+        for (; i<AUDIO_BLOCK_SAMPLES; i++) {
+            x += dx;
+            if (x >= 1.0f) { break; }
+            values[i] = m_scaleValue(x);
+        }
+        break;
+    }
+
+    // Advance by one block the same as getNextValue() so the two stay interchangeable
+    m_currentValueX += m_slopeX;
+    m_expValue *= m_expBlockRatio;
+
+    // Check if the automation is finished.
+    if ((i < AUDIO_BLOCK_SAMPLES) || (m_currentValueX >= 1.0f)) {
+        if (i == AUDIO_BLOCK_SAMPLES) { i--; }
+        for (; i<AUDIO_BLOCK_SAMPLES; i++) { values[i] = m_endValue; }
+        m_currentValueX = 0.0f;
+        m_running = false;
+    }
+}
+
 // Template instantiation
 template class ParameterAutomation<float>;
 template class ParameterAutomation<int>;
@@ -187,6 +315,20 @@ void ParameterAutomationSequence<T>::setupParameter(int index, T startValue, T e
     m_currentIndex = 0;
 }
 
+template <class T>
+void ParameterAutomationSequence<T>::setupParameter(int index, T startValue, T endValue, size_t durationSamples, const float *table, size_t tableSize)
+{
+    m_paramArray[index]->reconfigure(startValue, endValue, durationSamples, table, tableSize);
+    m_currentIndex = 0;
+}
+
+template <class T>
+void ParameterAutomationSequence<T>::setupParameter(int index, T startValue, T endValue, float durationMilliseconds, const float *table, size_t tableSize)
+{
+    m_paramArray[index]->reconfigure(startValue, endValue, durationMilliseconds, table, tableSize);
+    m_currentIndex = 0;
+}
+
 template <class T>
 void ParameterAutomationSequence<T>::trigger(void)
 {
@@ -202,10 +344,23 @@ T ParameterAutomationSequence<T>::getNextValue()
     // Get the next value
     T nextValue = m_paramArray[m_currentIndex]->getNextValue();
 
-    if (m_running) {
-        // if (Serial) { Serial.println(String("ParameterAutomationSequence<T>::getNextValue() is ") + nextValue
-        //        + String(" from stage ") + m_currentIndex); }
+    // if (Serial) { Serial.println(String("ParameterAutomationSequence<T>::getNextValue() is ") + nextValue
+    //        + String(" from stage ") + m_currentIndex); }
+    m_checkStageFinished();
+    return nextValue;
+}
 
+template <class T>
+void ParameterAutomationSequence<T>::getNextVector(T *values)
+{
+    m_paramArray[m_currentIndex]->getNextVector(values);
+    m_checkStageFinished();
+}
+
+template <class T>
+void ParameterAutomationSequence<T>::m_checkStageFinished()
+{
+    if (m_running) {
         // If current stage is done, trigger the next
         if (m_paramArray[m_currentIndex]->isFinished()) {
             if (Serial) { Serial.println(String("Finished stage ") + m_currentIndex); }
@@ -222,8 +377,6 @@ T ParameterAutomationSequence<T>::getNextValue()
             }
         }
     }
-
-    return nextValue;
 }
 
 template <class T>
@@ -0,0 +1,142 @@
+/*
+ * UniformConvolution.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Audio.h"
+#include "LibBasicFunctions.h"
+
+namespace BALibrary {
+
+constexpr float Q15_TO_FLOAT = 1.0f / 32768.0f;
+
+// CMSIS packs a real spectrum as {DC, Nyquist} followed by the complex bins
+// {re, im} from 1 to FFT_SIZE/2 - 1. DC and Nyquist are real.
+static inline void complexMac(float *acc, const float *x, const float *h, size_t fftSize)
+{
+	acc[0] += x[0] * h[0];
+	acc[1] += x[1] * h[1];
+	for (size_t i=2; i<fftSize; i+=2) {
+		const float xr = x[i], xi = x[i+1];
+		const float hr = h[i], hi = h[i+1];
+		acc[i]   += xr*hr - xi*hi;
+		acc[i+1] += xr*hi + xi*hr;
+	}
+}
+
+UniformConvolution::UniformConvolution(size_t maxSamples)
+: m_numPartitions(0)
+{
+	m_maxPartitions = (maxSamples + PARTITION_SAMPLES - 1) / PARTITION_SAMPLES;
+	if (m_maxPartitions < 1) { m_maxPartitions = 1; }
+
+	m_irSpectra    = new float[m_maxPartitions * FFT_SIZE]();
+	m_inputSpectra = new float[m_maxPartitions * FFT_SIZE]();
+	m_frame        = new float[FFT_SIZE]();
+	m_accumulator  = new float[FFT_SIZE]();
+	arm_rfft_fast_init_f32(&m_fftInstance, FFT_SIZE);
+}
+
+UniformConvolution::~UniformConvolution()
+{
+	if (m_irSpectra)    delete [] m_irSpectra;
+	if (m_inputSpectra) delete [] m_inputSpectra;
+	if (m_frame)        delete [] m_frame;
+	if (m_accumulator)  delete [] m_accumulator;
+}
+
+bool UniformConvolution::setImpulseResponse(const float *ir, size_t numSamples, float gain)
+{
+	return m_loadPartitions(ir, nullptr, numSamples, gain);
+}
+
+bool UniformConvolution::setImpulseResponse(const int16_t *ir, size_t numSamples, float gain)
+{
+	return m_loadPartitions(nullptr, ir, numSamples, gain * Q15_TO_FLOAT);
+}
+
+void UniformConvolution::reset()
+{
+	memset(m_inputSpectra, 0, m_maxPartitions * FFT_SIZE * sizeof(float));
+	memset(m_frame, 0, FFT_SIZE * sizeof(float));
+}
+
+void UniformConvolution::process(float *output, const float *input)
+{
+	// Overlap-save, the frame is the previous block followed by the new one. The FFT
+	// overwrites its input so the frame is copied.
+	memcpy(m_frame + PARTITION_SAMPLES, input, PARTITION_SAMPLES * sizeof(float));
+	m_newestInput = (m_newestInput + 1 < m_maxPartitions) ? m_newestInput + 1 : 0;
+	float *newest = m_inputSpectra + m_newestInput * FFT_SIZE;
+	memcpy(m_accumulator, m_frame, FFT_SIZE * sizeof(float));
+	arm_rfft_fast_f32(&m_fftInstance, m_accumulator, newest, 0);
+	memcpy(m_frame, m_frame + PARTITION_SAMPLES, PARTITION_SAMPLES * sizeof(float));
+
+	const size_t numPartitions = m_numPartitions.load(std::memory_order_acquire);
+	if (numPartitions == 0) {
+		memset(output, 0, PARTITION_SAMPLES * sizeof(float));
+		return;
+	}
+
+	// Partition p of the impulse response multiplies the input from p blocks ago
+	memset(m_accumulator, 0, FFT_SIZE * sizeof(float));
+	size_t index = m_newestInput;
+	for (size_t partition=0; partition<numPartitions; partition++) {
+		complexMac(m_accumulator, m_inputSpectra + index * FFT_SIZE, m_irSpectra + partition * FFT_SIZE, FFT_SIZE);
+		index = (index > 0) ? index - 1 : m_maxPartitions - 1;
+	}
+
+	// The second half of the inverse is the linear convolution, the first half is aliased
+	float timeDomain[FFT_SIZE];
+	arm_rfft_fast_f32(&m_fftInstance, m_accumulator, timeDomain, 1);
+	memcpy(output, timeDomain + PARTITION_SAMPLES, PARTITION_SAMPLES * sizeof(float));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////////
+
+bool UniformConvolution::m_loadPartitions(const float *ir, const int16_t *irQ15, size_t numSamples, float gain)
+{
+	if (numSamples == 0) {
+		if (Serial) { Serial.println("UniformConvolution::setImpulseResponse(): ERROR empty impulse response"); }
+		return false;
+	}
+	if (numSamples > getMaxSamples()) { numSamples = getMaxSamples(); }
+
+	// Stop the audio interrupt using the spectra while they are replaced
+	m_numPartitions.store(0, std::memory_order_release);
+
+	const size_t numPartitions = (numSamples + PARTITION_SAMPLES - 1) / PARTITION_SAMPLES;
+	float segment[FFT_SIZE];
+	for (size_t partition=0; partition<numPartitions; partition++) {
+		// each partition is zero padded to the FFT size
+		const size_t start = partition * PARTITION_SAMPLES;
+		for (size_t i=0; i<FFT_SIZE; i++) {
+			const size_t n = start + i;
+			if ((i >= PARTITION_SAMPLES) || (n >= numSamples)) { segment[i] = 0.0f; }
+			else { segment[i] = gain * (ir ? ir[n] : static_cast<float>(irQ15[n])); }
+		}
+		arm_rfft_fast_f32(&m_fftInstance, segment, m_irSpectra + partition * FFT_SIZE, 0);
+	}
+
+	m_numPartitions.store(numPartitions, std::memory_order_release);
+	return true;
+}
+
+}
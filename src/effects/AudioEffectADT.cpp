@@ -0,0 +1,228 @@
+/*
+ * AudioEffectADT.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include "AudioEffectADT.h"
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+constexpr float MAX_DETUNE_CENTS = 30.0f;
+constexpr float MIN_RATE_HZ = 0.1f;
+constexpr float MAX_RATE_HZ = 4.0f;
+constexpr float SAMPLES_PER_MS = AUDIO_SAMPLE_RATE_EXACT / 1000.0f;
+constexpr float Q16_SCALE = 65536.0f;
+
+AudioEffectADT::AudioEffectADT(float maxDelayMs)
+: AudioStream(1, m_inputQueueArray)
+{
+	// one extra sample for the older half of the interpolated pair
+	const size_t maxDelaySamples = calcAudioSamples(maxDelayMs) + 1;
+	m_memory = new DelayLine(maxDelaySamples);
+	m_maxDelayQ16 = static_cast<uint32_t>(maxDelaySamples - 1) << 16;
+
+	m_osc.setWaveform(Waveform::RANDOM);
+	m_delayMs = 30.0f;
+	m_detuneCents = 6.0f;
+	rate(0.7f);
+}
+
+AudioEffectADT::~AudioEffectADT()
+{
+	if (m_memory) delete m_memory;
+}
+
+void AudioEffectADT::update(void)
+{
+	// Check is block is disabled
+	if (m_enable == false) {
+		// do not transmit or process any audio, return as quickly as possible.
+		return;
+	}
+
+	audio_block_t *inputAudioBlock = receiveReadOnly(); // get the next block of input samples
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if ((m_bypass == true) || (!inputAudioBlock)) {
+		// transmit the input directly
+		if (!inputAudioBlock) {
+			// create silence
+			inputAudioBlock = allocate();
+			if (!inputAudioBlock) { return; } // failed to allocate
+			else {
+				clearAudioBlock(inputAudioBlock);
+			}
+		}
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return;
+	}
+
+	audio_block_t *blockToOutput = allocate();
+	if (!blockToOutput) {
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return; // skip this update cycle due to failure
+	}
+
+	// delay = delay() + swing*lfo in Q16.16 samples
+	const int16_t *lfo = m_osc.getNextVector();
+	const int64_t delayQ16 = m_delayQ16;
+	const int64_t swingQ16 = m_swingQ16;
+	uint32_t delays[AUDIO_BLOCK_SAMPLES];
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		delays[i] = static_cast<uint32_t>(delayQ16 + ((swingQ16 * lfo[i]) >> 15));
+	}
+
+	m_memory->addBlock(inputAudioBlock);
+	m_memory->getSamplesModulated(blockToOutput->data, delays);
+
+	// Mix and set the output volume with one SMLAD per sample
+	const int32_t dryGain = static_cast<int32_t>(m_volume * (1.0f - m_mix) * 32767.0f);
+	const int32_t wetGain = static_cast<int32_t>(m_volume * m_mix * 32767.0f);
+	const int32_t gains = simd::pack16(dryGain, wetGain);
+	const int16_t *dry = inputAudioBlock->data;
+	int16_t *out = blockToOutput->data;
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		out[i] = simd::saturate16(simd::smlad(simd::pack16(dry[i], out[i]), gains, 1 << 14) >> 15);
+	}
+
+	transmit(blockToOutput);
+	release(blockToOutput);
+	release(inputAudioBlock);
+}
+
+void AudioEffectADT::delay(float milliseconds)
+{
+	m_delayMs = milliseconds;
+	m_updateModulation();
+}
+
+void AudioEffectADT::detune(float cents)
+{
+	m_detuneCents = cents;
+	m_updateModulation();
+}
+
+void AudioEffectADT::rate(float rateHz)
+{
+	m_rate = (rateHz > MIN_RATE_HZ) ? rateHz : MIN_RATE_HZ;
+	m_osc.setRateAudio(m_rate);
+	m_updateModulation();
+}
+
+void AudioEffectADT::processMidi(int channel, int control, int value)
+{
+
+	float val = (float)value / 127.0f;
+
+	if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+		// Bypass
+		if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectADT::not bypassed -> ON") + value); }
+		else { bypass(true); if (Serial) Serial.println(String("AudioEffectADT::bypassed -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[DELAY][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DELAY][MIDI_CONTROL] == control)) {
+		// Delay
+		delay(val * (m_maxDelayQ16 / Q16_SCALE) / SAMPLES_PER_MS);
+		if (Serial) { Serial.println(String("AudioEffectADT::delay (ms): ") + m_delayMs); }
+		return;
+	}
+
+	if ((m_midiConfig[DETUNE][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DETUNE][MIDI_CONTROL] == control)) {
+		// Detune
+		detune(val * MAX_DETUNE_CENTS);
+		if (Serial) { Serial.println(String("AudioEffectADT::detune (cents): ") + m_detuneCents); }
+		return;
+	}
+
+	if ((m_midiConfig[RATE][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[RATE][MIDI_CONTROL] == control)) {
+		// Rate
+		rate(MIN_RATE_HZ + val * (MAX_RATE_HZ - MIN_RATE_HZ));
+		if (Serial) { Serial.println(String("AudioEffectADT::rate (Hz): ") + m_rate); }
+		return;
+	}
+
+	if ((m_midiConfig[MIX][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[MIX][MIDI_CONTROL] == control)) {
+		// Mix
+		if (Serial) { Serial.println(String("AudioEffectADT::mix: Dry: ") + 100*(1-val) + String("% Wet: ") + 100*val ); }
+		mix(val);
+		return;
+	}
+
+	if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+		// Volume
+		if (Serial) { Serial.println(String("AudioEffectADT::volume: ") + 100*val + String("%")); }
+		volume(val);
+		return;
+	}
+
+}
+
+void AudioEffectADT::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+	if (parameter >= NUM_CONTROLS) {
+		return ; // Invalid midi parameter
+	}
+	m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+	m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+//////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////
+
+// The RANDOM waveform moves between levels with a raised cosine each cycle, so its
+// steepest slope is pi/2 * (level change) * rate. The pitch of the double changes by
+// the slope of the delay, so a swing of S samples around the average gives a maximum
+// ratio of 1 + pi*S*rate/fs. Solve for S from the detune.
+void AudioEffectADT::m_updateModulation()
+{
+	const float maxDelay = m_maxDelayQ16 / Q16_SCALE;
+	const float ratio = powf(2.0f, m_detuneCents / 1200.0f) - 1.0f;
+	float swingSamples = (ratio > 0.0f) ? (ratio * AUDIO_SAMPLE_RATE_EXACT) / (PI * m_rate) : 0.0f;
+
+	float delaySamples = m_delayMs * SAMPLES_PER_MS;
+	if (delaySamples > maxDelay) { delaySamples = maxDelay; }
+
+	// keep the sweep between one sample and the end of the delay line
+	if (delaySamples - swingSamples < 1.0f) { swingSamples = delaySamples - 1.0f; }
+	if (delaySamples + swingSamples > maxDelay) { swingSamples = maxDelay - delaySamples; }
+	if (swingSamples < 0.0f) {
+		swingSamples = 0.0f;
+		delaySamples = 1.0f;
+	}
+
+	m_delayQ16 = static_cast<uint32_t>(delaySamples * Q16_SCALE);
+	m_swingQ16 = static_cast<uint32_t>(swingSamples * Q16_SCALE);
+}
+
+}
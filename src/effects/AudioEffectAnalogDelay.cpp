@@ -20,6 +20,7 @@
 #include <new>
 #include "AudioEffectAnalogDelayFilters.h"
 #include "AudioEffectAnalogDelay.h"
+#include "LibBlockOps.h"
 
 using namespace BALibrary;
 
@@ -44,6 +45,14 @@ AudioEffectAnalogDelay::AudioEffectAnalogDelay(size_t numSamples)
 	m_constructFilter();
 }
 
+AudioEffectAnalogDelay::AudioEffectAnalogDelay(AudioDelayBackend backend, size_t numSamples)
+: AudioStream(1, m_inputQueueArray)
+{
+	m_memory = new AudioDelay(backend, numSamples);
+	m_maxDelaySamples = numSamples;
+	m_constructFilter();
+}
+
 // requires preallocated memory large enough
 AudioEffectAnalogDelay::AudioEffectAnalogDelay(ExtMemSlot *slot)
 : AudioStream(1, m_inputQueueArray)
@@ -71,25 +80,39 @@ void AudioEffectAnalogDelay::m_constructFilter(void)
 
 void AudioEffectAnalogDelay::setFilterCoeffs(int numStages, const int32_t *coeffs, int coeffShift)
 {
-	m_iir->changeFilterCoeffs(numStages, coeffs, coeffShift);
+	m_iir->morphFilterCoeffs(numStages, coeffs, coeffShift, IirBiQuadMorph::Transition::CROSSFADE);
+	m_filterDesigned = false;
 }
 
 void AudioEffectAnalogDelay::setFilter(Filter filter)
 {
 	switch(filter) {
 	case Filter::WARM :
-		m_iir->changeFilterCoeffs(WARM_NUM_STAGES, reinterpret_cast<const int32_t *>(&WARM), WARM_COEFF_SHIFT);
+		setFilterCoeffs(WARM_NUM_STAGES, reinterpret_cast<const int32_t *>(&WARM), WARM_COEFF_SHIFT);
 		break;
 	case Filter::DARK :
-		m_iir->changeFilterCoeffs(DARK_NUM_STAGES, reinterpret_cast<const int32_t *>(&DARK), DARK_COEFF_SHIFT);
+		setFilterCoeffs(DARK_NUM_STAGES, reinterpret_cast<const int32_t *>(&DARK), DARK_COEFF_SHIFT);
 		break;
 	case Filter::DM3 :
 	default:
-		m_iir->changeFilterCoeffs(DM3_NUM_STAGES, reinterpret_cast<const int32_t *>(&DM3), DM3_COEFF_SHIFT);
+		setFilterCoeffs(DM3_NUM_STAGES, reinterpret_cast<const int32_t *>(&DM3), DM3_COEFF_SHIFT);
 		break;
 	}
 }
 
+bool AudioEffectAnalogDelay::setFilterDesign(BiquadType type, float fc, float q, float gainDb)
+{
+	int32_t coeffs[5];
+	if (!designBiquad(type, fc, q, gainDb, coeffs, DESIGN_COEFF_SHIFT)) { return false; }
+
+	// Sweeping an already designed filter interpolates, replacing a preset crossfades
+	const IirBiQuadMorph::Transition transition = m_filterDesigned ?
+		IirBiQuadMorph::Transition::INTERPOLATE : IirBiQuadMorph::Transition::CROSSFADE;
+	m_iir->morphFilterCoeffs(1, coeffs, DESIGN_COEFF_SHIFT, transition);
+	m_filterDesigned = true;
+	return true;
+}
+
 void AudioEffectAnalogDelay::update(void)
 {
 
@@ -99,8 +122,8 @@ void AudioEffectAnalogDelay::update(void)
         if (m_previousBlock) {
             release(m_previousBlock); m_previousBlock = nullptr;
         }
-        if (!m_externalMemory) {
-            // when using internal memory we have to release all references in the ring buffer
+        if (m_memory->getRingBuffer()) {
+            // when using an internal ring we have to release all references in the ring buffer
             while (m_memory->getRingBuffer()->size() > 0) {
                 audio_block_t *releaseBlock = m_memory->getRingBuffer()->front();
                 m_memory->getRingBuffer()->pop_front();
@@ -139,29 +162,36 @@ void AudioEffectAnalogDelay::update(void)
         return; // skip this update cycle due to failure
     }
 
-    // get the data. If using external memory with DMA, this won't be filled until
-    // later.
-    m_memory->getSamples(blockToOutput, m_delaySamples);
+    // Reverse playback uses the delay as the window length
+    bool reverse = m_reverse && (m_memory->setReverseWindow(m_delaySamples) > 0);
 
-    // If using DMA, we need something else to do while that read executes, so
-    // move on to input preprocessing
+    // The memory accesses are compiled for each backend so there are no further
+    // checks on the memory type during the block.
+    audio_block_t *blockToRelease = m_memory->visit([&](auto *memory) {
+        // get the data. If using external memory with DMA, this won't be filled until
+        // later.
+        if (reverse) { m_memory->requestReverseSamples(); }
+        else { memory->getSamples(blockToOutput->data, m_delaySamples); }
 
-	// Preprocessing
-	audio_block_t *preProcessed = allocate();
-	// mix the input with the feedback path in the pre-processing stage
-	m_preProcessing(preProcessed, inputAudioBlock, m_previousBlock);
+        // If using DMA, we need something else to do while that read executes, so
+        // move on to input preprocessing
 
-	// consider doing the BBD post processing here to use up more time while waiting
-	// for the read data to come back
-	audio_block_t *blockToRelease = m_memory->addBlock(preProcessed);
+        // Preprocessing
+        audio_block_t *preProcessed = allocate();
+        // mix the input with the feedback path in the pre-processing stage
+        m_preProcessing(preProcessed, inputAudioBlock, m_previousBlock);
 
+        // consider doing the BBD post processing here to use up more time while waiting
+        // for the read data to come back
+        audio_block_t *releaseBlock = memory->addBlock(preProcessed);
 
-	// BACK TO OUTPUT PROCESSING
-	// Check if external DMA, if so, we need to be sure the read is completed
-	if (m_externalMemory && m_memory->getSlot()->isUseDma()) {
-	    // Using DMA
-		while (m_memory->getSlot()->isReadBusy()) {}
-	}
+        // BACK TO OUTPUT PROCESSING
+        // If using DMA, we need to be sure the read is completed
+        memory->waitForRead();
+        return releaseBlock;
+    });
+
+	if (reverse) { m_memory->getReverseSamples(blockToOutput->data); }
 
 	// perform the wet/dry mix mix
 	m_postProcessing(blockToOutput, inputAudioBlock, blockToOutput);
@@ -263,6 +293,13 @@ void AudioEffectAnalogDelay::delayFractionMax(float delayFraction)
     m_delaySamples = delaySamples;
 }
 
+void AudioEffectAnalogDelay::reverse(bool enable)
+{
+	// allocate the reverse buffers now rather than in update()
+	if (enable) { m_memory->setReverseWindow(m_delaySamples); }
+	m_reverse = enable;
+}
+
 void AudioEffectAnalogDelay::m_preProcessing(audio_block_t *out, audio_block_t *dry, audio_block_t *wet)
 {
 	if ( out && dry && wet) {
@@ -280,12 +317,14 @@ void AudioEffectAnalogDelay::m_postProcessing(audio_block_t *out, audio_block_t
 	if ( out && dry && wet) {
 		// Simulate the LPF IIR nature of the analog systems
 		//m_iir->process(wet->data, wet->data, AUDIO_BLOCK_SAMPLES);
-		alphaBlend(out, dry, wet, m_mix);
+		// Mix and set the output volume in one pass
+		blockOps::evaluate(out, blockOps::scale(blockOps::mix(dry, wet, m_mix), m_volume));
 	} else if (dry) {
-		memcpy(out->data, dry->data, sizeof(int16_t) * AUDIO_BLOCK_SAMPLES);
+		gainAdjust(out, dry, m_volume);
+	} else {
+		// Set the output volume
+		gainAdjust(out, out, m_volume);
 	}
-	// Set the output volume
-	gainAdjust(out, out, m_volume);
 
 }
 
@@ -338,6 +377,14 @@ void AudioEffectAnalogDelay::processMidi(int channel, int control, int value)
 		return;
 	}
 
+	if ((m_midiConfig[REVERSE][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[REVERSE][MIDI_CONTROL] == control)) {
+		// Reverse
+		if (value >= 65) { reverse(true); if (Serial) Serial.println(String("AudioEffectAnalogDelay::reverse -> ON") + value); }
+		else { reverse(false); if (Serial) Serial.println(String("AudioEffectAnalogDelay::reverse -> OFF") + value); }
+		return;
+	}
+
 }
 
 void AudioEffectAnalogDelay::mapMidiControl(int parameter, int midiCC, int midiChannel)
@@ -0,0 +1,309 @@
+/*
+ * AudioEffectAnalogDelayF32.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "AudioEffectAnalogDelayF32.h"
+
+#if BALIBRARY_F32
+
+#include "AudioEffectAnalogDelayFilters.h"
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+AudioEffectAnalogDelayF32::AudioEffectAnalogDelayF32(float maxDelayMs)
+: AudioStream_F32(1, m_inputQueueArray)
+{
+	m_memory = new AudioDelayF32(maxDelayMs);
+	m_maxDelaySamples = m_memory->getMaxDelaySamples();
+	m_constructFilter();
+}
+
+AudioEffectAnalogDelayF32::AudioEffectAnalogDelayF32(size_t numSamples)
+: AudioStream_F32(1, m_inputQueueArray)
+{
+	m_memory = new AudioDelayF32(numSamples);
+	m_maxDelaySamples = numSamples;
+	m_constructFilter();
+}
+
+// requires preallocated memory large enough
+AudioEffectAnalogDelayF32::AudioEffectAnalogDelayF32(ExtMemSlot *slot)
+: AudioStream_F32(1, m_inputQueueArray)
+{
+	m_memory = new AudioDelayF32(slot);
+	m_maxDelaySamples = m_memory->getMaxDelaySamples();
+	m_externalMemory = true;
+	m_constructFilter();
+}
+
+AudioEffectAnalogDelayF32::~AudioEffectAnalogDelayF32()
+{
+	if (m_memory) delete m_memory;
+	if (m_iir) delete m_iir;
+}
+
+// This function just sets up the default filter and coefficients
+void AudioEffectAnalogDelayF32::m_constructFilter(void)
+{
+	// Use DM3 coefficients by default
+	m_iir = new IirBiQuadFilterFloat(MAX_NUM_FILTER_STAGES, reinterpret_cast<const int32_t *>(&DM3), DM3_COEFF_SHIFT);
+	m_iir->changeFilterCoeffs(DM3_NUM_STAGES, reinterpret_cast<const int32_t *>(&DM3), DM3_COEFF_SHIFT);
+}
+
+void AudioEffectAnalogDelayF32::setFilterCoeffs(int numStages, const int32_t *coeffs, int coeffShift)
+{
+	m_iir->morphFilterCoeffs(numStages, coeffs, coeffShift, IirBiQuadMorph::Transition::CROSSFADE);
+	m_filterDesigned = false;
+}
+
+void AudioEffectAnalogDelayF32::setFilter(Filter filter)
+{
+	switch(filter) {
+	case Filter::WARM :
+		setFilterCoeffs(WARM_NUM_STAGES, reinterpret_cast<const int32_t *>(&WARM), WARM_COEFF_SHIFT);
+		break;
+	case Filter::DARK :
+		setFilterCoeffs(DARK_NUM_STAGES, reinterpret_cast<const int32_t *>(&DARK), DARK_COEFF_SHIFT);
+		break;
+	case Filter::DM3 :
+	default:
+		setFilterCoeffs(DM3_NUM_STAGES, reinterpret_cast<const int32_t *>(&DM3), DM3_COEFF_SHIFT);
+		break;
+	}
+}
+
+bool AudioEffectAnalogDelayF32::setFilterDesign(BiquadType type, float fc, float q, float gainDb)
+{
+	float coeffs[5];
+	if (!designBiquad(type, fc, q, gainDb, coeffs)) { return false; }
+
+	// Sweeping an already designed filter interpolates, replacing a preset crossfades
+	const IirBiQuadMorph::Transition transition = m_filterDesigned ?
+		IirBiQuadMorph::Transition::INTERPOLATE : IirBiQuadMorph::Transition::CROSSFADE;
+	m_iir->morphFilterCoeffs(1, coeffs, transition);
+	m_filterDesigned = true;
+	return true;
+}
+
+void AudioEffectAnalogDelayF32::update(void)
+{
+	// Check is block is disabled
+	if (m_enable == false) {
+		// the delay line holds copies of the samples so only the input must be released,
+		// the feedback starts from silence when enabled again as in AudioEffectAnalogDelay
+		memset(m_previousOutput, 0, sizeof(float) * AUDIO_BLOCK_SAMPLES);
+		// release the pending input so it is not held in the queue
+		audio_block_f32_t *inputAudioBlock = receiveReadOnly_f32();
+		if (inputAudioBlock) { AudioStream_F32::release(inputAudioBlock); }
+		return;
+	}
+
+	audio_block_f32_t *inputAudioBlock = receiveReadOnly_f32(); // get the next block of input samples
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if ((m_bypass == true) || (!inputAudioBlock)) {
+		// transmit the input directly
+		if (!inputAudioBlock) {
+			// create silence
+			inputAudioBlock = allocate_f32();
+			if (!inputAudioBlock) { return; } // failed to allocate
+			else {
+				memset(inputAudioBlock->data, 0, sizeof(float) * AUDIO_BLOCK_SAMPLES);
+			}
+		}
+		AudioStream_F32::transmit(inputAudioBlock, 0);
+		AudioStream_F32::release(inputAudioBlock);
+		return;
+	}
+
+	audio_block_f32_t *blockToOutput = allocate_f32();
+	if (!blockToOutput) {
+		AudioStream_F32::transmit(inputAudioBlock, 0);
+		AudioStream_F32::release(inputAudioBlock);
+		return; // skip this update cycle due to failure
+	}
+
+	// Reverse playback uses the delay as the window length
+	bool reverse = m_reverse && (m_memory->setReverseWindow(m_delaySamples) > 0);
+
+	// Request the read first so a DMA read from external memory runs while the
+	// feedback path is processed.
+	if (reverse) { m_memory->requestReverseSamples(); }
+	else { m_memory->getSamples(blockToOutput->data, m_delaySamples); }
+
+	// mix the input with the feedback path in the pre-processing stage
+	m_preProcessing(m_preProcessed, inputAudioBlock->data, m_previousOutput);
+	m_memory->addBlock(m_preProcessed);
+
+	// BACK TO OUTPUT PROCESSING
+	if (reverse) { m_memory->getReverseSamples(blockToOutput->data); }
+	else { m_memory->waitForRead(); }
+
+	// perform the wet/dry mix mix
+	m_postProcessing(blockToOutput->data, inputAudioBlock->data, blockToOutput->data);
+
+	// the output is fed back, the same as AudioEffectAnalogDelay
+	memcpy(m_previousOutput, blockToOutput->data, sizeof(float) * AUDIO_BLOCK_SAMPLES);
+	AudioStream_F32::transmit(blockToOutput);
+
+	AudioStream_F32::release(blockToOutput);
+	AudioStream_F32::release(inputAudioBlock);
+}
+
+void AudioEffectAnalogDelayF32::m_setDelaySamples(size_t delaySamples)
+{
+	if (!m_memory) {
+		if (Serial) { Serial.println("delay(): m_memory is not valid"); }
+		return;
+	}
+
+	if (m_externalMemory) {
+		ExtMemSlot *slot = m_memory->getSlot();
+		if (!slot->isEnabled()) {
+			slot->enable();
+			if (Serial) { Serial.println("WEIRD: slot was not enabled"); }
+		}
+	}
+
+	m_maxDelaySamples = m_memory->getMaxDelaySamples();
+	if (delaySamples > m_maxDelaySamples) {
+		// this exceeds max delay value, limit it.
+		delaySamples = m_maxDelaySamples;
+	}
+	m_delaySamples = delaySamples;
+}
+
+void AudioEffectAnalogDelayF32::delay(float milliseconds)
+{
+	m_setDelaySamples(calcAudioSamples(milliseconds));
+}
+
+void AudioEffectAnalogDelayF32::delay(size_t delaySamples)
+{
+	m_setDelaySamples(delaySamples);
+}
+
+void AudioEffectAnalogDelayF32::delayFractionMax(float delayFraction)
+{
+	m_setDelaySamples(static_cast<size_t>(static_cast<float>(m_memory->getMaxDelaySamples()) * delayFraction));
+}
+
+void AudioEffectAnalogDelayF32::reverse(bool enable)
+{
+	// allocate the reverse buffers now rather than in update()
+	if (enable) { m_memory->setReverseWindow(m_delaySamples); }
+	m_reverse = enable;
+}
+
+void AudioEffectAnalogDelayF32::m_preProcessing(float *out, const float *dry, const float *wet)
+{
+	// out = dry*(1-feedback) + wet*feedback, then the analog style filter
+	const float dryGain = 1.0f - m_feedback;
+	const float wetGain = m_feedback;
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		out[i] = dryGain*dry[i] + wetGain*wet[i];
+	}
+	m_iir->process(out, out, AUDIO_BLOCK_SAMPLES);
+}
+
+void AudioEffectAnalogDelayF32::m_postProcessing(float *out, const float *dry, const float *wet)
+{
+	// Mix and set the output volume in one pass
+	const float dryGain = m_volume * (1.0f - m_mix);
+	const float wetGain = m_volume * m_mix;
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		out[i] = dryGain*dry[i] + wetGain*wet[i];
+	}
+}
+
+
+void AudioEffectAnalogDelayF32::processMidi(int channel, int control, int value)
+{
+
+	float val = (float)value / 127.0f;
+
+	if ((m_midiConfig[DELAY][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DELAY][MIDI_CONTROL] == control)) {
+		// Delay
+		m_maxDelaySamples = m_memory->getMaxDelaySamples();
+		size_t delayVal = (size_t)(val * (float)(m_maxDelaySamples));
+		delay(delayVal);
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayF32::delay (ms): ") + calcAudioTimeMs(delayVal)
+				+ String(" (samples): ") + delayVal + String(" out of ") + m_maxDelaySamples); }
+		return;
+	}
+
+	if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+		// Bypass
+		if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectAnalogDelayF32::not bypassed -> ON") + value); }
+		else { bypass(true); if (Serial) Serial.println(String("AudioEffectAnalogDelayF32::bypassed -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[FEEDBACK][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[FEEDBACK][MIDI_CONTROL] == control)) {
+		// Feedback
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayF32::feedback: ") + 100*val + String("%")); }
+		feedback(val);
+		return;
+	}
+
+	if ((m_midiConfig[MIX][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[MIX][MIDI_CONTROL] == control)) {
+		// Mix
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayF32::mix: Dry: ") + 100*(1-val) + String("% Wet: ") + 100*val ); }
+		mix(val);
+		return;
+	}
+
+	if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+		// Volume
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayF32::volume: ") + 100*val + String("%")); }
+		volume(val);
+		return;
+	}
+
+	if ((m_midiConfig[REVERSE][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[REVERSE][MIDI_CONTROL] == control)) {
+		// Reverse
+		if (value >= 65) { reverse(true); if (Serial) Serial.println(String("AudioEffectAnalogDelayF32::reverse -> ON") + value); }
+		else { reverse(false); if (Serial) Serial.println(String("AudioEffectAnalogDelayF32::reverse -> OFF") + value); }
+		return;
+	}
+
+}
+
+void AudioEffectAnalogDelayF32::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+	if (parameter >= NUM_CONTROLS) {
+		return ; // Invalid midi parameter
+	}
+	m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+	m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+}
+
+#endif /* BALIBRARY_F32 */
@@ -20,6 +20,7 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 #include <cstdint>
+#include "LibFilterDesign.h"
 
 namespace BAEffects {
 
@@ -38,6 +39,9 @@ constexpr unsigned NUM_COEFFS_PER_STAGE = 5;
 // them down by a power of 2. For example, if your largest magnitude coefficient is -3.5, you must divide by
 // 2^shift where 4=2^2 and thus shift = 2. You must then mutliply by 2^31 to get a 32-bit signed integer value
 // that represents the required Q31 coefficient.
+//
+// Alternatively, LibFilterDesign.h can design and quantize the second-order-sections at compile time
+// from the analog parameters. See WARM_DESIGN and DARK_DESIGN below for examples.
 
 // BOSS DM-3 Filters
 // b(z) = 1.0e-03 * (0.0032    0.0257    0.0900    0.1800    0.2250    0.1800    0.0900    0.0257    0.0032)
@@ -80,4 +84,22 @@ constexpr int32_t DARK[5*MAX_NUM_FILTER_STAGES] = {
 	957356,-1462833,957356,1896884898,-838694612
 };
 
+// The WARM and DARK presets regenerated at compile time from their analog prototypes. New filter
+// characters can be declared the same way and passed to AudioEffectAnalogDelay::setFilterCoeffs(), e.g.
+// setFilterCoeffs(WARM_DESIGN.numStages, WARM_DESIGN.coeffs, WARM_DESIGN.coeffShift);
+// The presets were designed at 44100 Hz so these are too, new designs should use the default rate.
+constexpr double PRESET_SAMPLE_RATE = 44100.0;
+constexpr auto WARM_DESIGN = BALibrary::quantizeSosQ31(
+	BALibrary::designSos<WARM_NUM_STAGES>(BALibrary::SosPrototype::BUTTERWORTH, 2000.0, 0.0, false, PRESET_SAMPLE_RATE));
+constexpr auto DARK_DESIGN = BALibrary::quantizeSosQ31(
+	BALibrary::designSos<DARK_NUM_STAGES>(BALibrary::SosPrototype::CHEBYSHEV2, 1000.0, 60.0, false, PRESET_SAMPLE_RATE));
+
+// Verify the generated tables match the Matlab/Octave presets within quantization error. The
+// individual 'b' coefficients of WARM differ since Matlab's tf2sos() does not place the repeated
+// zeros exactly at z = -1, so the magnitude responses are compared instead.
+static_assert(BALibrary::sosMatchesQ31(WARM_DESIGN, WARM, WARM_NUM_STAGES, WARM_COEFF_SHIFT, 0.001, PRESET_SAMPLE_RATE),
+	"WARM_DESIGN does not match the WARM preset");
+static_assert(BALibrary::sosMatchesQ31(DARK_DESIGN, DARK, DARK_NUM_STAGES, DARK_COEFF_SHIFT, 0.001, PRESET_SAMPLE_RATE),
+	"DARK_DESIGN does not match the DARK preset");
+
 };
@@ -0,0 +1,417 @@
+/*
+ * AudioEffectAnalogDelayStereo.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <new>
+#include "AudioEffectAnalogDelayFilters.h"
+#include "AudioEffectAnalogDelayStereo.h"
+#include "LibSimd.h"
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+constexpr unsigned LEFT  = 0;
+constexpr unsigned RIGHT = 1;
+constexpr size_t FRAME_BYTES = 2*sizeof(int16_t); // one interleaved L/R frame
+
+using simd::saturate16;
+
+AudioEffectAnalogDelayStereo::AudioEffectAnalogDelayStereo(float maxDelayMs)
+: AudioEffectAnalogDelayStereo(calcAudioSamples(maxDelayMs))
+{
+}
+
+AudioEffectAnalogDelayStereo::AudioEffectAnalogDelayStereo(size_t numSamples)
+: AudioStream(NUM_CHANNELS, m_inputQueueArray)
+{
+	m_constructMemory(numSamples);
+	m_constructFilter();
+}
+
+// requires preallocated memory large enough
+AudioEffectAnalogDelayStereo::AudioEffectAnalogDelayStereo(ExtMemSlot *slot)
+: AudioStream(NUM_CHANNELS, m_inputQueueArray)
+{
+	m_slot = slot;
+	m_externalMemory = true;
+	memset(m_wet, 0, sizeof(m_wet));
+	m_constructFilter();
+
+#if defined(__IMXRT1062__)
+	// KLUGE! The Teensy Audio Library doesn't support DMA buffers correctly on the T4.0. We need to
+	// use an intermediate copy buffer large enough for a full block of stereo frames. It is sized
+	// here since it must not change while a read or write is in progress.
+	setSpiDmaCopyBuffer(m_slot, sizeof(m_writeFrames));
+#endif
+}
+
+AudioEffectAnalogDelayStereo::~AudioEffectAnalogDelayStereo()
+{
+	if (m_buffer) delete [] m_buffer;
+	if (m_iir) delete m_iir;
+}
+
+// Both channels share one interleaved filter, default to the DM3 coefficients
+void AudioEffectAnalogDelayStereo::m_constructFilter(void)
+{
+	m_iir = new IirBiQuadFilterMultiHQ<NUM_CHANNELS>(MAX_STAGES, reinterpret_cast<const int32_t *>(&DM3), DM3_COEFF_SHIFT);
+}
+
+void AudioEffectAnalogDelayStereo::m_constructMemory(size_t numSamples)
+{
+	// The write block must fit in the buffer without overwriting the longest delay
+	m_bufferFrames = numSamples + AUDIO_BLOCK_SAMPLES;
+	m_buffer = new int16_t[NUM_CHANNELS*m_bufferFrames]();
+	m_maxDelaySamples = numSamples;
+	m_writeFrame = 0;
+	memset(m_wet, 0, sizeof(m_wet));
+}
+
+void AudioEffectAnalogDelayStereo::m_updateMaxDelay(void)
+{
+	if (!m_externalMemory) { return; }
+
+	// The slot is often given its memory after this object is constructed so
+	// the max delay must be calculated on demand.
+	if (m_slot->size() % FRAME_BYTES) {
+		if (Serial) { Serial.println("AudioEffectAnalogDelayStereo: ERROR slot size is not a multiple of 4 bytes"); }
+	}
+	size_t slotFrames = m_slot->size() / FRAME_BYTES;
+	m_maxDelaySamples = (slotFrames > AUDIO_BLOCK_SAMPLES) ? slotFrames - AUDIO_BLOCK_SAMPLES : 0;
+	if (!m_slot->isEnabled()) { m_slot->enable(); }
+}
+
+void AudioEffectAnalogDelayStereo::setFilterCoeffs(int numStages, const int32_t *coeffs, int coeffShift)
+{
+	if ((numStages <= 0) || (static_cast<unsigned>(numStages) > MAX_STAGES)) { return; }
+
+	// Hold off the audio interrupt so update() never sees a partially written set of coefficients
+	__disable_irq();
+	m_iir->changeFilterCoeffs(numStages, coeffs, coeffShift);
+	__enable_irq();
+}
+
+void AudioEffectAnalogDelayStereo::setFilter(Filter filter)
+{
+	switch(filter) {
+	case Filter::WARM :
+		setFilterCoeffs(WARM_NUM_STAGES, reinterpret_cast<const int32_t *>(&WARM), WARM_COEFF_SHIFT);
+		break;
+	case Filter::DARK :
+		setFilterCoeffs(DARK_NUM_STAGES, reinterpret_cast<const int32_t *>(&DARK), DARK_COEFF_SHIFT);
+		break;
+	case Filter::DM3 :
+	default:
+		setFilterCoeffs(DM3_NUM_STAGES, reinterpret_cast<const int32_t *>(&DM3), DM3_COEFF_SHIFT);
+		break;
+	}
+}
+
+void AudioEffectAnalogDelayStereo::update(void)
+{
+	// Check is block is disabled
+	if (m_enable == false) {
+		// no audio blocks are held by this effect so there is nothing to release
+		return;
+	}
+
+	audio_block_t *inputLeft  = receiveReadOnly(LEFT);
+	audio_block_t *inputRight = receiveReadOnly(RIGHT);
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if ((m_bypass == true) || ((!inputLeft) && (!inputRight))) {
+		audio_block_t *inputs[NUM_CHANNELS] = {inputLeft, inputRight};
+		for (unsigned channel = 0; channel < NUM_CHANNELS; channel++) {
+			audio_block_t *block = inputs[channel];
+			if (!block) {
+				// create silence
+				block = allocate();
+				if (!block) { continue; } // failed to allocate
+				clearAudioBlock(block);
+			}
+			transmit(block, channel);
+			release(block);
+		}
+		return;
+	}
+
+	m_updateMaxDelay();
+
+	// Request the delayed frames first. When using DMA the reads complete in the
+	// background while the input is processed. A second read is only required
+	// when the channels have different delays.
+	const bool singleRead = (m_delaySamples[LEFT] == m_delaySamples[RIGHT]);
+	m_readDelayed(m_readFrames[LEFT], m_delaySamples[LEFT]);
+	if (!singleRead) {
+		m_readDelayed(m_readFrames[RIGHT], m_delaySamples[RIGHT]);
+	}
+
+	// mix the input with the feedback path, filter, then store to memory
+	m_preProcessing(inputLeft, inputRight);
+	m_iir->process(m_writeFrames, m_writeFrames, AUDIO_BLOCK_SAMPLES);
+	m_writeFramesToMemory();
+
+	// BACK TO OUTPUT PROCESSING
+	// Check if external DMA, if so, we need to be sure the read is completed
+	if (m_externalMemory && m_slot->isUseDma()) {
+		// Using DMA
+		while (m_slot->isReadBusy()) {}
+	}
+
+	// Extract the left channel from the left tap and the right channel from the right tap
+	const int16_t *leftFrames  = m_readFrames[LEFT];
+	const int16_t *rightFrames = singleRead ? m_readFrames[LEFT] : m_readFrames[RIGHT];
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		m_wet[LEFT][i]  = leftFrames[2*i];
+		m_wet[RIGHT][i] = rightFrames[2*i+1];
+	}
+
+	// perform the wet/dry mix
+	audio_block_t *inputs[NUM_CHANNELS] = {inputLeft, inputRight};
+	for (unsigned channel = 0; channel < NUM_CHANNELS; channel++) {
+		audio_block_t *blockToOutput = allocate();
+		if (blockToOutput) {
+			m_postProcessing(blockToOutput, inputs[channel], m_wet[channel]);
+			transmit(blockToOutput, channel);
+			release(blockToOutput);
+		}
+	}
+
+	if (inputLeft)  { release(inputLeft); }
+	if (inputRight) { release(inputRight); }
+}
+
+void AudioEffectAnalogDelayStereo::m_readDelayed(int16_t *dest, size_t delaySamples)
+{
+	if (!m_externalMemory) {
+		// INTERNAL memory, the most recently written block starts AUDIO_BLOCK_SAMPLES behind the write position
+		size_t readFrame = (m_writeFrame + 2*m_bufferFrames - AUDIO_BLOCK_SAMPLES - delaySamples) % m_bufferFrames;
+		size_t numFrames = AUDIO_BLOCK_SAMPLES;
+		if (readFrame + numFrames > m_bufferFrames) {
+			// the read wraps around the end of the buffer
+			size_t firstFrames = m_bufferFrames - readFrame;
+			memcpy(dest, &m_buffer[NUM_CHANNELS*readFrame], firstFrames*FRAME_BYTES);
+			dest += NUM_CHANNELS*firstFrames;
+			numFrames -= firstFrames;
+			readFrame = 0;
+		}
+		memcpy(dest, &m_buffer[NUM_CHANNELS*readFrame], numFrames*FRAME_BYTES);
+		return;
+	}
+
+	// EXTERNAL memory
+	// current position is considered the write position subtracted by the number of frames we're going
+	// to read since this is the smallest delay we can get without reading past the write position into
+	// the "future".
+	int currentPositionBytes = (int)m_slot->getWritePosition() - (int)(AUDIO_BLOCK_SAMPLES*FRAME_BYTES);
+	int offsetBytes = (int)(delaySamples*FRAME_BYTES);
+	int readPosition = currentPositionBytes - offsetBytes;
+	if (readPosition < 0) {
+		// It's going to wrap around to the from the beginning to the end of the slot.
+		readPosition += (int)m_slot->size();
+	}
+	m_slot->setReadPosition((size_t)readPosition);
+	m_slot->readAdvance16(dest, FRAME_SAMPLES);
+}
+
+void AudioEffectAnalogDelayStereo::m_writeFramesToMemory(void)
+{
+	if (!m_externalMemory) {
+		size_t numFrames = AUDIO_BLOCK_SAMPLES;
+		const int16_t *src = m_writeFrames;
+		if (m_writeFrame + numFrames > m_bufferFrames) {
+			// the write wraps around the end of the buffer
+			size_t firstFrames = m_bufferFrames - m_writeFrame;
+			memcpy(&m_buffer[NUM_CHANNELS*m_writeFrame], src, firstFrames*FRAME_BYTES);
+			src += NUM_CHANNELS*firstFrames;
+			numFrames -= firstFrames;
+			m_writeFrame = 0;
+		}
+		memcpy(&m_buffer[NUM_CHANNELS*m_writeFrame], src, numFrames*FRAME_BYTES);
+		m_writeFrame += numFrames;
+		if (m_writeFrame >= m_bufferFrames) { m_writeFrame = 0; }
+		return;
+	}
+
+	m_slot->writeAdvance16(m_writeFrames, FRAME_SAMPLES);
+}
+
+void AudioEffectAnalogDelayStereo::m_preProcessing(audio_block_t *inLeft, audio_block_t *inRight)
+{
+	// write = input*(1-feedback) + feedback*(self*(1-cross) + opposite*cross)
+	const float cross = m_pingPong ? 1.0f : m_crossFeedback;
+	const int32_t gainIn    = (int32_t)((1.0f - m_feedback) * 32767.0f);
+	const int32_t gainSelf  = (int32_t)(m_feedback * (1.0f - cross) * 32767.0f);
+	const int32_t gainCross = (int32_t)(m_feedback * cross * 32767.0f);
+
+	const int16_t *wetL = m_wet[LEFT];
+	const int16_t *wetR = m_wet[RIGHT];
+
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		int32_t left  = inLeft  ? inLeft->data[i]  : 0;
+		int32_t right = inRight ? inRight->data[i] : 0;
+		if (m_pingPong) {
+			// sum the input to mono and feed only the left delay line
+			left  = (left + right) >> 1;
+			right = 0;
+		}
+		m_writeFrames[2*i]   = saturate16((gainIn*left  + gainSelf*wetL[i] + gainCross*wetR[i]) >> 15);
+		m_writeFrames[2*i+1] = saturate16((gainIn*right + gainSelf*wetR[i] + gainCross*wetL[i]) >> 15);
+	}
+}
+
+void AudioEffectAnalogDelayStereo::m_postProcessing(audio_block_t *out, audio_block_t *dry, const int16_t *wet)
+{
+	// out = volume * (dry*(1-mix) + wet*mix) in a single pass
+	const int32_t gainDry = (int32_t)((1.0f - m_mix) * m_volume * 32767.0f);
+	const int32_t gainWet = (int32_t)(m_mix * m_volume * 32767.0f);
+
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		int32_t drySample = dry ? dry->data[i] : 0;
+		out->data[i] = saturate16((gainDry*drySample + gainWet*wet[i]) >> 15);
+	}
+}
+
+void AudioEffectAnalogDelayStereo::m_setDelay(unsigned channel, size_t delaySamples)
+{
+	m_updateMaxDelay();
+	if (delaySamples > m_maxDelaySamples) {
+		// this exceeds max delay value, limit it.
+		delaySamples = m_maxDelaySamples;
+	}
+	m_delaySamples[channel] = delaySamples;
+}
+
+void AudioEffectAnalogDelayStereo::delay(float milliseconds)
+{
+	delay(calcAudioSamples(milliseconds));
+}
+
+void AudioEffectAnalogDelayStereo::delay(size_t delaySamples)
+{
+	m_setDelay(LEFT, delaySamples);
+	m_setDelay(RIGHT, delaySamples);
+}
+
+void AudioEffectAnalogDelayStereo::delayLeft(size_t delaySamples)
+{
+	m_setDelay(LEFT, delaySamples);
+}
+
+void AudioEffectAnalogDelayStereo::delayRight(size_t delaySamples)
+{
+	m_setDelay(RIGHT, delaySamples);
+}
+
+void AudioEffectAnalogDelayStereo::delayFractionMax(float delayFraction)
+{
+	m_updateMaxDelay();
+	delay(static_cast<size_t>(static_cast<float>(m_maxDelaySamples) * delayFraction));
+}
+
+void AudioEffectAnalogDelayStereo::processMidi(int channel, int control, int value)
+{
+
+	float val = (float)value / 127.0f;
+
+	if ((m_midiConfig[DELAY_LEFT][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DELAY_LEFT][MIDI_CONTROL] == control)) {
+		// Left Delay
+		m_updateMaxDelay();
+		size_t delayVal = (size_t)(val * (float)(m_maxDelaySamples));
+		delayLeft(delayVal);
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayStereo::delayLeft (ms): ") + calcAudioTimeMs(delayVal)
+				+ String(" (samples): ") + delayVal + String(" out of ") + m_maxDelaySamples); }
+		return;
+	}
+
+	if ((m_midiConfig[DELAY_RIGHT][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DELAY_RIGHT][MIDI_CONTROL] == control)) {
+		// Right Delay
+		m_updateMaxDelay();
+		size_t delayVal = (size_t)(val * (float)(m_maxDelaySamples));
+		delayRight(delayVal);
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayStereo::delayRight (ms): ") + calcAudioTimeMs(delayVal)
+				+ String(" (samples): ") + delayVal + String(" out of ") + m_maxDelaySamples); }
+		return;
+	}
+
+	if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+		// Bypass
+		if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectAnalogDelayStereo::not bypassed -> ON") + value); }
+		else { bypass(true); if (Serial) Serial.println(String("AudioEffectAnalogDelayStereo::bypassed -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[FEEDBACK][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[FEEDBACK][MIDI_CONTROL] == control)) {
+		// Feedback
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayStereo::feedback: ") + 100*val + String("%")); }
+		feedback(val);
+		return;
+	}
+
+	if ((m_midiConfig[CROSS_FEEDBACK][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[CROSS_FEEDBACK][MIDI_CONTROL] == control)) {
+		// Cross Feedback
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayStereo::cross feedback: ") + 100*val + String("%")); }
+		crossFeedback(val);
+		return;
+	}
+
+	if ((m_midiConfig[PING_PONG][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[PING_PONG][MIDI_CONTROL] == control)) {
+		// Ping-Pong
+		if (value >= 65) { pingPong(true); if (Serial) Serial.println(String("AudioEffectAnalogDelayStereo::ping-pong -> ON") + value); }
+		else { pingPong(false); if (Serial) Serial.println(String("AudioEffectAnalogDelayStereo::ping-pong -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[MIX][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[MIX][MIDI_CONTROL] == control)) {
+		// Mix
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayStereo::mix: Dry: ") + 100*(1-val) + String("% Wet: ") + 100*val ); }
+		mix(val);
+		return;
+	}
+
+	if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+		// Volume
+		if (Serial) { Serial.println(String("AudioEffectAnalogDelayStereo::volume: ") + 100*val + String("%")); }
+		volume(val);
+		return;
+	}
+
+}
+
+void AudioEffectAnalogDelayStereo::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+	if (parameter >= NUM_CONTROLS) {
+		return ; // Invalid midi parameter
+	}
+	m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+	m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+}
@@ -0,0 +1,142 @@
+/*
+ * AudioEffectConvolution.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AudioEffectConvolution.h"
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+AudioEffectConvolution::AudioEffectConvolution(float maxImpulseMs)
+: AudioStream(1, m_inputQueueArray)
+{
+	m_convolution = new UniformConvolution(calcAudioSamples(maxImpulseMs));
+}
+
+AudioEffectConvolution::~AudioEffectConvolution()
+{
+	if (m_convolution) delete m_convolution;
+}
+
+bool AudioEffectConvolution::setImpulseResponse(const float *ir, size_t numSamples, float gain)
+{
+	return m_convolution->setImpulseResponse(ir, numSamples, gain);
+}
+
+bool AudioEffectConvolution::setImpulseResponse(const int16_t *ir, size_t numSamples, float gain)
+{
+	return m_convolution->setImpulseResponse(ir, numSamples, gain);
+}
+
+void AudioEffectConvolution::update(void)
+{
+	// Check is block is disabled
+	if (m_enable == false) {
+		// do not transmit or process any audio, return as quickly as possible.
+		return;
+	}
+
+	audio_block_t *inputAudioBlock = receiveReadOnly(); // get the next block of input samples
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if ((m_bypass == true) || (!inputAudioBlock)) {
+		// transmit the input directly
+		if (!inputAudioBlock) {
+			// create silence
+			inputAudioBlock = allocate();
+			if (!inputAudioBlock) { return; } // failed to allocate
+			else {
+				clearAudioBlock(inputAudioBlock);
+			}
+		}
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return;
+	}
+
+	audio_block_t *blockToOutput = allocate();
+	if (!blockToOutput) {
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return; // skip this update cycle due to failure
+	}
+
+	float dry[AUDIO_BLOCK_SAMPLES];
+	float wet[AUDIO_BLOCK_SAMPLES];
+	convertQ15ToFloat(dry, inputAudioBlock->data, AUDIO_BLOCK_SAMPLES);
+	m_convolution->process(wet, dry);
+
+	// Mix and set the output volume in one pass
+	const float dryGain = m_volume * (1.0f - m_mix);
+	const float wetGain = m_volume * m_mix;
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		wet[i] = dryGain*dry[i] + wetGain*wet[i];
+	}
+	convertFloatToQ15(blockToOutput->data, wet, AUDIO_BLOCK_SAMPLES);
+
+	transmit(blockToOutput);
+	release(blockToOutput);
+	release(inputAudioBlock);
+}
+
+void AudioEffectConvolution::processMidi(int channel, int control, int value)
+{
+
+	float val = (float)value / 127.0f;
+
+	if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+		// Bypass
+		if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectConvolution::not bypassed -> ON") + value); }
+		else { bypass(true); if (Serial) Serial.println(String("AudioEffectConvolution::bypassed -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[MIX][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[MIX][MIDI_CONTROL] == control)) {
+		// Mix
+		if (Serial) { Serial.println(String("AudioEffectConvolution::mix: Dry: ") + 100*(1-val) + String("% Wet: ") + 100*val ); }
+		mix(val);
+		return;
+	}
+
+	if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+		// Volume
+		if (Serial) { Serial.println(String("AudioEffectConvolution::volume: ") + 100*val + String("%")); }
+		volume(val);
+		return;
+	}
+
+}
+
+void AudioEffectConvolution::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+	if (parameter >= NUM_CONTROLS) {
+		return ; // Invalid midi parameter
+	}
+	m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+	m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+}
@@ -48,14 +48,24 @@ BAAudioEffectDelayExternal::BAAudioEffectDelayExternal(BALibrary::MemSelect mem,
 	m_requestedDelayLength = delayLengthInt;
 }
 
+BAAudioEffectDelayExternal::BAAudioEffectDelayExternal(ExtMemSlot *slot)
+: AudioStream(1, m_inputQueueArray)
+{
+	m_slot = slot;
+	m_activeMask = 0;
+}
+
 BAAudioEffectDelayExternal::~BAAudioEffectDelayExternal()
 {
 	if (m_spi) delete m_spi;
+	if (m_blockToRelease) release(m_blockToRelease);
 }
 
 void BAAudioEffectDelayExternal::delay(uint8_t channel, float milliseconds) {
 
-    if (!m_configured) { initialize(); }
+	if (m_slot) {
+		if (!m_configured && !m_initializeSlot()) { return; }
+	} else if (!m_configured) { initialize(); }
 
 	if (channel >= 8) return;
 	if (milliseconds < 0.0) milliseconds = 0.0;
@@ -65,19 +75,21 @@ void BAAudioEffectDelayExternal::delay(uint8_t channel, float milliseconds) {
 		n = m_memoryLength - AUDIO_BLOCK_SAMPLES;
 	m_channelDelayLength[channel] = n;
 	unsigned mask = m_activeMask;
-	if (m_activeMask == 0) m_startUsingSPI(m_spiChannel);
+	if ((m_activeMask == 0) && !m_slot) m_startUsingSPI(m_spiChannel);
 	m_activeMask = mask | (1<<channel);
 	if (Serial) { Serial.print("DelayLengthInt: "); Serial.println(m_requestedDelayLength); }
 }
 
 void BAAudioEffectDelayExternal::disable(uint8_t channel) {
 
-    if (!m_configured) { initialize(); }
+	if (m_slot) {
+		if (!m_configured && !m_initializeSlot()) { return; }
+	} else if (!m_configured) { initialize(); }
 
 	if (channel >= 8) return;
 	uint8_t mask = m_activeMask & ~(1<<channel);
 	m_activeMask = mask;
-	if (mask == 0) m_stopUsingSPI(m_spiChannel);
+	if ((mask == 0) && !m_slot) m_stopUsingSPI(m_spiChannel);
 }
 
 void BAAudioEffectDelayExternal::update(void)
@@ -97,6 +109,12 @@ void BAAudioEffectDelayExternal::update(void)
 	    } else { return; }
 	}
 
+	if (m_slot) {
+		// the slot path batches the tap reads, m_spi is not used
+		m_updateSlot(block);
+		return;
+	}
+
 	if (block) {
 		if (m_headOffset + AUDIO_BLOCK_SAMPLES <= m_memoryLength) {
 			// a single write is enough
@@ -149,6 +167,122 @@ void BAAudioEffectDelayExternal::update(void)
 	}
 }
 
+// When using an ExtMemSlot, the write of the incoming block is queued first, followed by
+// one batch containing the reads for all the taps. Since taps are often close together
+// (e.g. multi-tap echoes), windows that overlap or touch are merged into a single burst
+// to save the SPI command/address overhead and the DMA setup for each tap.
+void BAAudioEffectDelayExternal::m_updateSlot(audio_block_t *block)
+{
+	// The previous input block can be released now that its write has completed
+	if (m_blockToRelease) { release(m_blockToRelease); }
+	m_blockToRelease = block;
+
+	// write the incoming audio, or zeros so later playback will not be random garbage
+	if (block) {
+		m_slot->writeAdvance16(block->data, AUDIO_BLOCK_SAMPLES);
+	} else {
+		m_slot->zeroAdvance16(AUDIO_BLOCK_SAMPLES);
+	}
+	m_headOffset = m_slot->getWritePosition() / sizeof(int16_t);
+
+	// compute the delayed location where each tap reads, sorted by increasing offset
+	unsigned tapChannel[NUM_TAPS];
+	size_t tapOffset[NUM_TAPS];
+	unsigned numTaps = 0;
+	for (unsigned channel = 0; channel < NUM_TAPS; channel++) {
+		if (!(m_activeMask & (1<<channel))) continue;
+		size_t readOffset;
+		if (m_channelDelayLength[channel] <= m_headOffset) {
+			readOffset = m_headOffset - m_channelDelayLength[channel];
+		} else {
+			readOffset = m_memoryLength + m_headOffset - m_channelDelayLength[channel];
+		}
+
+		unsigned idx = numTaps++;
+		while ((idx > 0) && (tapOffset[idx-1] > readOffset)) {
+			tapOffset[idx] = tapOffset[idx-1];
+			tapChannel[idx] = tapChannel[idx-1];
+			idx--;
+		}
+		tapOffset[idx] = readOffset;
+		tapChannel[idx] = channel;
+	}
+	if (numTaps == 0) { return; }
+
+	// merge the tap windows that overlap or touch into a single read window. Each merge
+	// adds at most one block to the buffer so it can never overflow.
+	size_t windowOffset[NUM_TAPS];
+	size_t windowWords[NUM_TAPS];
+	int16_t *windowDest[NUM_TAPS];
+	int16_t *tapData[NUM_TAPS];
+	unsigned numWindows = 0;
+	int16_t *bufferPtr = m_tapBuffer;
+
+	for (unsigned i=0; i<numTaps; i++) {
+		size_t tapEnd = tapOffset[i] + AUDIO_BLOCK_SAMPLES;
+		if (numWindows > 0) {
+			unsigned w = numWindows-1;
+			size_t windowEnd = windowOffset[w] + windowWords[w];
+			if (tapOffset[i] <= windowEnd) {
+				// extend the previous window
+				tapData[i] = windowDest[w] + (tapOffset[i] - windowOffset[w]);
+				if (tapEnd > windowEnd) {
+					windowWords[w] += tapEnd - windowEnd;
+					bufferPtr += tapEnd - windowEnd;
+				}
+				continue;
+			}
+		}
+		windowOffset[numWindows] = tapOffset[i];
+		windowWords[numWindows] = AUDIO_BLOCK_SAMPLES;
+		windowDest[numWindows] = bufferPtr;
+		tapData[i] = bufferPtr;
+		bufferPtr += AUDIO_BLOCK_SAMPLES;
+		numWindows++;
+	}
+
+	if (!m_slot->readBatch16(windowOffset, windowDest, windowWords, numWindows)) { return; }
+
+	// allocate the output blocks while the reads are in progress
+	audio_block_t *outBlock[NUM_TAPS];
+	for (unsigned i=0; i<numTaps; i++) { outBlock[i] = allocate(); }
+
+	while (m_slot->isReadBusy()) {}
+
+	for (unsigned i=0; i<numTaps; i++) {
+		if (!outBlock[i]) continue;
+		memcpy(outBlock[i]->data, tapData[i], sizeof(int16_t)*AUDIO_BLOCK_SAMPLES);
+		transmit(outBlock[i], tapChannel[i]);
+		release(outBlock[i]);
+	}
+}
+
+bool BAAudioEffectDelayExternal::m_initializeSlot(void)
+{
+	if (!m_slot->size()) {
+		if (Serial) { Serial.println("BAAudioEffectDelayExternal: ExtMemSlot has no memory allocated"); }
+		return false;
+	}
+
+	m_slot->enable();
+	m_memoryLength = m_slot->size() / sizeof(int16_t);
+	m_headOffset = m_slot->getWritePosition() / sizeof(int16_t);
+
+#if defined(__IMXRT1062__)
+	// For DMA use on T4.0 we need the copy buffer kluge. Batched reads are split to
+	// fit the copy buffer, so it only needs to hold one audio block for the write.
+	if (m_slot->isUseDma()) {
+		BASpiMemoryDMA *spiDma = static_cast<BASpiMemoryDMA*>(m_slot->getSpiMemoryHandle());
+		if (spiDma && (spiDma->getDmaCopyBufferSize() < sizeof(int16_t)*AUDIO_BLOCK_SAMPLES)) {
+			spiDma->setDmaCopyBufferSize(sizeof(int16_t)*AUDIO_BLOCK_SAMPLES);
+		}
+	}
+#endif
+
+	m_configured = true;
+	return true;
+}
+
 unsigned BAAudioEffectDelayExternal::m_allocated[2] = {0, 0};
 
 void BAAudioEffectDelayExternal::initialize(void)
@@ -0,0 +1,363 @@
+/*
+ * AudioEffectDynamics.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include "LibFilterDesign.h"
+#include "AudioEffectDynamics.h"
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+// Levels and gains are log2 of the linear value in Q24, one unit is 6.02 dB
+constexpr int LOG_SHIFT = 24;
+constexpr int32_t LOG_ONE = 1 << LOG_SHIFT;
+constexpr int32_t FULL_SCALE_LOG = 15 * LOG_ONE;  ///< log2(32768), the level of a full scale sample
+constexpr int32_t GAIN_FLOOR = -16 * LOG_ONE;     ///< about -96 dB, the most a gate will attenuate
+constexpr float DB_PER_LOG = 6.0205999f;          ///< 20*log10(2)
+constexpr float MIN_THRESHOLD_DB = -90.0f;
+constexpr float MAX_RATIO = 100.0f;
+constexpr float MAX_MAKEUP_DB = 48.0f;
+constexpr int MAX_MAKEUP_SHIFT = 8;               ///< 48 dB of makeup needs 8 bits of headroom
+constexpr int32_t Q31_MAX = 0x7FFFFFFF;
+constexpr float Q31_SCALE = 2147483648.0f;
+
+// The RMS detector averages over a fixed window, the attack and release still apply to the gain
+constexpr double RMS_WINDOW_MS = 5.0;
+constexpr int32_t RMS_COEFF = static_cast<int32_t>(constexprMath::roundNearest(
+	32768.0 * (1.0 - constexprMath::exp(-1000.0 / (RMS_WINDOW_MS * AUDIO_SAMPLE_RATE_EXACT)))));
+
+// The top bits after the leading one select an entry and the next 8 bits interpolate.
+// The extra entry at the end of each table is the end point so interpolation never overruns.
+constexpr unsigned TABLE_BITS = 7;
+constexpr unsigned TABLE_SIZE = 1U << TABLE_BITS;
+
+struct LogTable {
+	int32_t values[TABLE_SIZE+1];
+};
+
+/// log2(1 + i/TABLE_SIZE) in Q24
+constexpr LogTable makeLog2Table()
+{
+	LogTable table = {};
+	for (unsigned i=0; i <= TABLE_SIZE; i++) {
+		const double value = LOG_ONE * constexprMath::log(1.0 + static_cast<double>(i) / TABLE_SIZE) / constexprMath::LN2;
+		table.values[i] = static_cast<int32_t>(constexprMath::roundNearest(value));
+	}
+	return table;
+}
+
+/// 2^(-i/TABLE_SIZE) in Q30
+constexpr LogTable makeExp2Table()
+{
+	LogTable table = {};
+	for (unsigned i=0; i <= TABLE_SIZE; i++) {
+		const double value = 1073741824.0 * constexprMath::exp(-constexprMath::LN2 * static_cast<double>(i) / TABLE_SIZE);
+		table.values[i] = static_cast<int32_t>(constexprMath::roundNearest(value));
+	}
+	return table;
+}
+
+static constexpr LogTable LOG2_TABLE = makeLog2Table();
+static constexpr LogTable EXP2_TABLE = makeExp2Table();
+
+// log2(x) in Q24, zero is treated as one
+static inline int32_t log2Lookup(uint32_t x)
+{
+	if (x == 0) { return 0; }
+	const int exponent = 31 - __builtin_clz(x);
+	const uint32_t mantissa = (x << (31 - exponent)) & 0x7FFFFFFF;  // the fraction after the leading one
+	const unsigned index = mantissa >> (31 - TABLE_BITS);
+	const int32_t fraction = (mantissa >> (31 - TABLE_BITS - 8)) & 0xFF;
+	const int32_t a = LOG2_TABLE.values[index];
+	const int32_t b = LOG2_TABLE.values[index+1];
+	return (exponent << LOG_SHIFT) + a + (((b - a) * fraction) >> 8);
+}
+
+// 2^x as a Q15 gain for x in Q24, x <= 0
+static inline int32_t exp2Lookup(int32_t x)
+{
+	const uint32_t attenuation = static_cast<uint32_t>(-x);
+	const unsigned shift = attenuation >> LOG_SHIFT;
+	if (shift >= 16) { return 0; }
+	const uint32_t fraction = attenuation & (LOG_ONE - 1);
+	const unsigned index = fraction >> (LOG_SHIFT - TABLE_BITS);
+	const int32_t interp = (fraction >> (LOG_SHIFT - TABLE_BITS - 8)) & 0xFF;
+	const int32_t a = EXP2_TABLE.values[index];
+	const int32_t b = EXP2_TABLE.values[index+1];
+	const int32_t gain = (a - (((a - b) * interp) >> 8)) >> (15 + shift);
+	return (gain < 32767) ? gain : 32767;
+}
+
+AudioEffectDynamics::AudioEffectDynamics(float maxLookaheadMs)
+: AudioStream(1, m_inputQueueArray)
+{
+	m_maxLookaheadSamples = calcAudioSamples(maxLookaheadMs);
+	if (m_maxLookaheadSamples > 0) {
+		m_lookahead = new AudioDelayT<AudioDelayBackend::INTERNAL_FLAT>(m_maxLookaheadSamples);
+	}
+	attackTime(5.0f);
+	releaseTime(100.0f);
+}
+
+AudioEffectDynamics::~AudioEffectDynamics()
+{
+	if (m_lookahead) delete m_lookahead;
+}
+
+int32_t AudioEffectDynamics::m_calcCoeff(float milliseconds)
+{
+	// One pole smoothing evaluated once per pair of samples, y += c*(x - y)
+	const float pairMs = calcAudioTimeMs(2);
+	if (milliseconds <= pairMs) { return Q31_MAX; }
+	return static_cast<int32_t>(Q31_SCALE * (1.0f - expf(-pairMs / milliseconds)));
+}
+
+void AudioEffectDynamics::makeup(float gainDb)
+{
+	if (gainDb < 0.0f) { gainDb = 0.0f; }
+	if (gainDb > MAX_MAKEUP_DB) { gainDb = MAX_MAKEUP_DB; }
+	m_makeup = powf(10.0f, gainDb / 20.0f);
+}
+
+void AudioEffectDynamics::lookahead(float milliseconds)
+{
+	size_t lookaheadSamples = calcAudioSamples(milliseconds);
+	if (lookaheadSamples > m_maxLookaheadSamples) {
+		if (Serial) { Serial.println("AudioEffectDynamics::lookahead(): limited to the maximum lookahead"); }
+		lookaheadSamples = m_maxLookaheadSamples;
+	}
+	m_lookaheadSamples = lookaheadSamples;
+}
+
+float AudioEffectDynamics::getGainReduction() const
+{
+	return DB_PER_LOG * static_cast<float>(m_gainReduction.load(std::memory_order_relaxed)) / LOG_ONE;
+}
+
+void AudioEffectDynamics::update(void)
+{
+	// Check is block is disabled
+	if (m_enable == false) {
+		// do not transmit or process any audio, return as quickly as possible.
+		return;
+	}
+
+	audio_block_t *inputAudioBlock = receiveReadOnly(); // get the next block of input samples
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if ((m_bypass == true) || (!inputAudioBlock)) {
+		// transmit the input directly
+		if (!inputAudioBlock) {
+			// create silence
+			inputAudioBlock = allocate();
+			if (!inputAudioBlock) { return; } // failed to allocate
+			else {
+				clearAudioBlock(inputAudioBlock);
+			}
+		}
+		// keep the lookahead current so leaving bypass does not replay old audio
+		if (m_lookahead) { m_lookahead->addBlock(inputAudioBlock); }
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return;
+	}
+
+	audio_block_t *blockToOutput = allocate();
+	if (!blockToOutput) {
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return; // skip this update cycle due to failure
+	}
+
+	// The detector always sees the input, only the audio the gain is applied to is delayed
+	const int16_t *audio = inputAudioBlock->data;
+	if (m_lookahead) {
+		m_lookahead->addBlock(inputAudioBlock);
+		if (m_lookaheadSamples > 0) {
+			m_lookahead->getSamples(blockToOutput->data, m_lookaheadSamples);
+			audio = blockToOutput->data;
+		}
+	}
+	m_process(blockToOutput->data, inputAudioBlock->data, audio);
+
+	transmit(blockToOutput);
+	release(blockToOutput);
+	release(inputAudioBlock);
+}
+
+void AudioEffectDynamics::m_process(int16_t *out, const int16_t *detect, const int16_t *in)
+{
+	// Convert the controls once per block
+	float thresholdDb = (m_thresholdDb > MIN_THRESHOLD_DB) ? m_thresholdDb : MIN_THRESHOLD_DB;
+	thresholdDb = (thresholdDb < 0.0f) ? thresholdDb : 0.0f;
+	const int32_t threshold = static_cast<int32_t>(thresholdDb / DB_PER_LOG * LOG_ONE) + FULL_SCALE_LOG;
+
+	float ratio = (m_ratio > 1.0f) ? m_ratio : 1.0f;
+	ratio = (ratio < MAX_RATIO) ? ratio : MAX_RATIO;
+	const bool gate = (m_mode == Mode::GATE);
+	float slope;
+	switch (m_mode) {
+	case Mode::LIMITER : slope = 1.0f; break;
+	case Mode::GATE    : slope = ratio - 1.0f; break;
+	case Mode::COMPRESSOR :
+	default            : slope = 1.0f - 1.0f / ratio; break;
+	}
+	const int32_t slopeQ16 = static_cast<int32_t>(slope * 65536.0f);
+
+	// The makeup gain and volume share one Q15 multiply, shifted up for gains above 1.0
+	float outputGain = m_makeup * m_volume;
+	int outputShift = 0;
+	while (((outputGain >= 1.0f) || (outputGain <= -1.0f)) && (outputShift < MAX_MAKEUP_SHIFT)) {
+		outputGain *= 0.5f;
+		outputShift++;
+	}
+	const int32_t outputScale = static_cast<int32_t>(outputGain * 32767.0f);
+
+	const bool rms = (m_detector == Detector::RMS);
+	const int32_t attackCoeff = m_attackCoeff;
+	const int32_t releaseCoeff = m_releaseCoeff;
+	int64_t meanSquare = m_meanSquare;
+	int32_t gain = m_gain;
+
+	// The gain is computed once per pair of samples
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i+=2) {
+		const int32_t samples = simd::load2(&detect[i]);
+		const int32_t a = simd::unpackLow(samples);
+		const int32_t b = simd::unpackHigh(samples);
+
+		int32_t level;
+		if (rms) {
+			// the mean square carries 16 fractional bits so quiet signals do not stall
+			meanSquare += (((static_cast<int64_t>(a*a) << 16) - meanSquare) * RMS_COEFF) >> 15;
+			meanSquare += (((static_cast<int64_t>(b*b) << 16) - meanSquare) * RMS_COEFF) >> 15;
+			level = log2Lookup(static_cast<uint32_t>(meanSquare >> 16)) >> 1;
+		} else {
+			const uint32_t absA = (a < 0) ? -a : a;
+			const uint32_t absB = (b < 0) ? -b : b;
+			level = log2Lookup((absA > absB) ? absA : absB);
+		}
+
+		// Static gain curve in the log domain
+		const int32_t over = level - threshold;
+		int32_t target = 0;
+		if (gate) {
+			if (over < 0) {
+				const int64_t reduction = (static_cast<int64_t>(over) * slopeQ16) >> 16;
+				target = (reduction > GAIN_FLOOR) ? static_cast<int32_t>(reduction) : GAIN_FLOOR;
+			}
+		} else if (over > 0) {
+			target = -static_cast<int32_t>((static_cast<int64_t>(over) * slopeQ16) >> 16);
+		}
+
+		// Attack when the level is rising, i.e. the compressor reduces or the gate opens
+		const bool rising = gate ? (target > gain) : (target < gain);
+		const int32_t coeff = rising ? attackCoeff : releaseCoeff;
+		gain += static_cast<int32_t>((static_cast<int64_t>(target - gain) * coeff) >> 31);
+
+		const int32_t pairGain = (exp2Lookup(gain) * outputScale) >> 15;
+		simd::store2(&out[i], simd::scale16(simd::load2(&in[i]), pairGain, 15 - outputShift));
+	}
+
+	m_meanSquare = meanSquare;
+	m_gain = gain;
+	m_gainReduction.store(gain, std::memory_order_relaxed);
+}
+
+void AudioEffectDynamics::processMidi(int channel, int control, int value)
+{
+
+	float val = (float)value / 127.0f;
+
+	if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+		// Bypass
+		if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectDynamics::not bypassed -> ON") + value); }
+		else { bypass(true); if (Serial) Serial.println(String("AudioEffectDynamics::bypassed -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[THRESHOLD][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[THRESHOLD][MIDI_CONTROL] == control)) {
+		// Threshold
+		const float thresholdDb = -60.0f * (1.0f - val);
+		if (Serial) { Serial.println(String("AudioEffectDynamics::threshold (dB): ") + thresholdDb); }
+		threshold(thresholdDb);
+		return;
+	}
+
+	if ((m_midiConfig[RATIO][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[RATIO][MIDI_CONTROL] == control)) {
+		// Ratio
+		const float ratioVal = 1.0f + 19.0f * val;
+		if (Serial) { Serial.println(String("AudioEffectDynamics::ratio: ") + ratioVal + String(":1")); }
+		ratio(ratioVal);
+		return;
+	}
+
+	if ((m_midiConfig[ATTACK][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[ATTACK][MIDI_CONTROL] == control)) {
+		// Attack
+		const float attackMs = 50.0f * val;
+		if (Serial) { Serial.println(String("AudioEffectDynamics::attackTime (ms): ") + attackMs); }
+		attackTime(attackMs);
+		return;
+	}
+
+	if ((m_midiConfig[RELEASE][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[RELEASE][MIDI_CONTROL] == control)) {
+		// Release
+		const float releaseMs = 5.0f + 995.0f * val;
+		if (Serial) { Serial.println(String("AudioEffectDynamics::releaseTime (ms): ") + releaseMs); }
+		releaseTime(releaseMs);
+		return;
+	}
+
+	if ((m_midiConfig[MAKEUP][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[MAKEUP][MIDI_CONTROL] == control)) {
+		// Makeup
+		const float makeupDb = 24.0f * val;
+		if (Serial) { Serial.println(String("AudioEffectDynamics::makeup (dB): ") + makeupDb); }
+		makeup(makeupDb);
+		return;
+	}
+
+	if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+		// Volume
+		if (Serial) { Serial.println(String("AudioEffectDynamics::volume: ") + 100*val + String("%")); }
+		volume(val);
+		return;
+	}
+
+}
+
+void AudioEffectDynamics::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+	if (parameter >= NUM_CONTROLS) {
+		return ; // Invalid midi parameter
+	}
+	m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+	m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+}
@@ -0,0 +1,426 @@
+/*
+ * AudioEffectFdnReverb.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include "AudioEffectFdnReverb.h"
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+constexpr unsigned NUM_LINES = AudioEffectFdnReverb::NUM_LINES;
+constexpr unsigned NUM_DIFFUSERS = AudioEffectFdnReverb::NUM_DIFFUSERS;
+static_assert(NUM_LINES <= ExtMemSlot::MAX_SLOT_BATCH_READS, "every line must be read in a single batch");
+
+// Line lengths of the largest room at a scale of 1.0, spread so the modes don't line up
+constexpr float BASE_LINE_MS[NUM_LINES] = {31.3f, 37.1f, 41.9f, 46.7f, 53.1f, 59.3f, 67.1f, 73.7f};
+constexpr unsigned DIFFUSER_SAMPLES[NUM_DIFFUSERS] = {142, 107, 379, 277};
+
+constexpr float MAX_SCALE = 3.0f;       ///< largest room scale, about 1.3 seconds of memory
+constexpr float MIN_SIZE_SCALE = 0.25f; ///< the smallest room relative to the largest
+constexpr float MIN_DECAY_S = 0.2f;
+constexpr float MAX_DECAY_S = 10.0f;
+constexpr float INPUT_GAIN = 0.35f;     ///< about 1/sqrt(NUM_LINES) so the total input power is unity
+constexpr float SAMPLES_PER_MS = AUDIO_SAMPLE_RATE_EXACT / 1000.0f;
+
+static bool isPrime(size_t value)
+{
+	if (value < 2) { return false; }
+	for (size_t divisor = 2; divisor*divisor <= value; divisor++) {
+		if ((value % divisor) == 0) { return false; }
+	}
+	return true;
+}
+
+AudioEffectFdnReverb::AudioEffectFdnReverb(ExtMemSlot *slot)
+: AudioStream(1, m_inputQueueArray), m_slot(slot)
+{
+	size_t diffuserSamples = 0;
+	for (unsigned d=0; d<NUM_DIFFUSERS; d++) { diffuserSamples += DIFFUSER_SAMPLES[d]; }
+	m_diffuserBuffer = new int16_t[diffuserSamples]();
+
+	m_size = 0.5f;
+	m_decay = 2.0f;
+	damping(0.4f);
+	diffusion(0.7f);
+}
+
+AudioEffectFdnReverb::~AudioEffectFdnReverb()
+{
+	if (m_diffuserBuffer) delete [] m_diffuserBuffer;
+}
+
+// The slot is usually given its memory in setup(), after this effect is constructed,
+// so the lines are laid out here.
+void AudioEffectFdnReverb::enable(void)
+{
+	m_enable = false;
+	if (!m_slot->isEnabled()) { m_slot->enable(); }
+
+	// Fit the largest room into the slot, allowing for rounding each line up to whole
+	// blocks and for its guard block.
+	const size_t slotSamples = m_slot->size() / sizeof(int16_t);
+	const size_t reservedSamples = 2*NUM_LINES*AUDIO_BLOCK_SAMPLES;
+	float baseSamples = 0.0f;
+	for (unsigned k=0; k<NUM_LINES; k++) { baseSamples += BASE_LINE_MS[k] * SAMPLES_PER_MS; }
+	m_maxScale = (slotSamples > reservedSamples) ? (slotSamples - reservedSamples) / baseSamples : 0.0f;
+	if (m_maxScale > MAX_SCALE) { m_maxScale = MAX_SCALE; }
+
+	size_t base = 0;
+	for (unsigned k=0; k<NUM_LINES; k++) {
+		const size_t maxLength = static_cast<size_t>(BASE_LINE_MS[k] * SAMPLES_PER_MS * m_maxScale);
+		m_lineBuffer[k] = ((maxLength + AUDIO_BLOCK_SAMPLES - 1) / AUDIO_BLOCK_SAMPLES) * AUDIO_BLOCK_SAMPLES;
+		m_lineBase[k] = base;
+		m_lineWrite[k] = 0;
+		m_lowpass[k] = 0;
+		base += m_lineBuffer[k] + AUDIO_BLOCK_SAMPLES;
+	}
+
+	// Block processing needs every line to be at least one block long
+	m_valid = (m_maxScale * MIN_SIZE_SCALE * BASE_LINE_MS[0] * SAMPLES_PER_MS >= AUDIO_BLOCK_SAMPLES) &&
+	          (base <= slotSamples);
+	if (!m_valid) {
+		if (Serial) { Serial.println("AudioEffectFdnReverb: ExtMemSlot is too small, reverb is bypassed"); }
+		m_enable = true;
+		return;
+	}
+
+#if defined(__IMXRT1062__)
+	// KLUGE! The Teensy Audio Library doesn't support DMA buffers correctly on the T4.0.
+	setSpiDmaCopyBuffer(m_slot);
+#endif
+
+	m_slot->clear();
+	m_updateLines();
+	if (Serial) { Serial.println(String("AudioEffectFdnReverb: enabled with room scale ") + m_maxScale); }
+	m_enable = true;
+}
+
+void AudioEffectFdnReverb::update(void)
+{
+	// Check is block is disabled
+	if (m_enable == false) {
+		// do not transmit or process any audio, return as quickly as possible.
+		return;
+	}
+
+	audio_block_t *inputAudioBlock = receiveReadOnly(); // get the next block of input samples
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if ((m_bypass == true) || (!m_valid)) {
+		// transmit the input directly
+		if (!inputAudioBlock) {
+			// create silence
+			inputAudioBlock = allocate();
+			if (!inputAudioBlock) { return; } // failed to allocate
+			else {
+				clearAudioBlock(inputAudioBlock);
+			}
+		}
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return;
+	}
+
+	audio_block_t *blockToOutput = allocate();
+	if (!blockToOutput) {
+		if (inputAudioBlock) {
+			transmit(inputAudioBlock, 0);
+			release(inputAudioBlock);
+		}
+		return; // skip this update cycle due to failure
+	}
+
+	// Read all the delay lines in one batch, then diffuse the input while it runs.
+	// A missing input block is silence so the tail keeps ringing.
+	m_requestReads();
+	int16_t diffused[AUDIO_BLOCK_SAMPLES];
+	m_diffuse(diffused, inputAudioBlock ? inputAudioBlock->data : nullptr);
+	while (m_slot->isReadBusy()) {}
+
+	int32_t wet[AUDIO_BLOCK_SAMPLES];
+	m_processLines(diffused, wet);
+	m_writeLines();
+
+	// Mix and set the output volume in one pass
+	const int32_t dryGain = static_cast<int32_t>(m_volume * (1.0f - m_mix) * 32767.0f);
+	const int32_t wetGain = static_cast<int32_t>(m_volume * m_mix * 32767.0f / sqrtf(NUM_LINES));
+	int16_t *out = blockToOutput->data;
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		const int32_t dry = inputAudioBlock ? inputAudioBlock->data[i] : 0;
+		const int64_t acc = static_cast<int64_t>(dryGain) * dry + static_cast<int64_t>(wetGain) * wet[i];
+		out[i] = simd::saturate16(static_cast<int32_t>(acc >> 15));
+	}
+
+	transmit(blockToOutput);
+	release(blockToOutput);
+	if (inputAudioBlock) { release(inputAudioBlock); }
+}
+
+void AudioEffectFdnReverb::size(float size)
+{
+	m_size = size;
+	m_updateLines();
+}
+
+void AudioEffectFdnReverb::decay(float seconds)
+{
+	m_decay = (seconds > MIN_DECAY_S) ? seconds : MIN_DECAY_S;
+	m_updateLines();
+}
+
+void AudioEffectFdnReverb::damping(float damping)
+{
+	m_damping = damping;
+	m_dampingCoeff = static_cast<int32_t>((1.0f - 0.9f * damping) * 32767.0f);
+}
+
+void AudioEffectFdnReverb::diffusion(float diffusion)
+{
+	m_diffusion = diffusion;
+	m_diffusionCoeff = static_cast<int32_t>(0.75f * diffusion * 32767.0f);
+}
+
+void AudioEffectFdnReverb::setMixing(Mixing mixing)
+{
+	m_mixing = mixing;
+	m_updateLines();
+}
+
+void AudioEffectFdnReverb::processMidi(int channel, int control, int value)
+{
+
+	float val = (float)value / 127.0f;
+
+	if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+		// Bypass
+		if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectFdnReverb::not bypassed -> ON") + value); }
+		else { bypass(true); if (Serial) Serial.println(String("AudioEffectFdnReverb::bypassed -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[SIZE][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[SIZE][MIDI_CONTROL] == control)) {
+		// Size
+		if (Serial) { Serial.println(String("AudioEffectFdnReverb::size: ") + 100*val + String("%")); }
+		size(val);
+		return;
+	}
+
+	if ((m_midiConfig[DECAY][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DECAY][MIDI_CONTROL] == control)) {
+		// Decay
+		decay(MIN_DECAY_S + val * (MAX_DECAY_S - MIN_DECAY_S));
+		if (Serial) { Serial.println(String("AudioEffectFdnReverb::decay (s): ") + m_decay); }
+		return;
+	}
+
+	if ((m_midiConfig[DAMPING][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DAMPING][MIDI_CONTROL] == control)) {
+		// Damping
+		if (Serial) { Serial.println(String("AudioEffectFdnReverb::damping: ") + 100*val + String("%")); }
+		damping(val);
+		return;
+	}
+
+	if ((m_midiConfig[DIFFUSION][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DIFFUSION][MIDI_CONTROL] == control)) {
+		// Diffusion
+		if (Serial) { Serial.println(String("AudioEffectFdnReverb::diffusion: ") + 100*val + String("%")); }
+		diffusion(val);
+		return;
+	}
+
+	if ((m_midiConfig[MIX][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[MIX][MIDI_CONTROL] == control)) {
+		// Mix
+		if (Serial) { Serial.println(String("AudioEffectFdnReverb::mix: Dry: ") + 100*(1-val) + String("% Wet: ") + 100*val ); }
+		mix(val);
+		return;
+	}
+
+	if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+		// Volume
+		if (Serial) { Serial.println(String("AudioEffectFdnReverb::volume: ") + 100*val + String("%")); }
+		volume(val);
+		return;
+	}
+
+}
+
+void AudioEffectFdnReverb::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+	if (parameter >= NUM_CONTROLS) {
+		return ; // Invalid midi parameter
+	}
+	m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+	m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+//////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////
+
+// Set the length of each line from the size, then its gain for the decay time.
+void AudioEffectFdnReverb::m_updateLines()
+{
+	if (!m_valid) { return; }
+
+	const float scale = m_maxScale * (MIN_SIZE_SCALE + (1.0f - MIN_SIZE_SCALE) * m_size);
+	// The Hadamard transform has a gain of sqrt(N), normalize it here instead of in the matrix
+	const float matrixScale = (m_mixing == Mixing::HADAMARD) ? (1.0f / sqrtf(NUM_LINES)) : 1.0f;
+
+	for (unsigned k=0; k<NUM_LINES; k++) {
+		size_t length = static_cast<size_t>(BASE_LINE_MS[k] * SAMPLES_PER_MS * scale);
+		if (length > m_lineBuffer[k]) { length = m_lineBuffer[k]; }
+		// prime lengths keep the echoes of different lines from coinciding
+		while ((length > AUDIO_BLOCK_SAMPLES) && !isPrime(length)) { length--; }
+		if (length < AUDIO_BLOCK_SAMPLES) { length = AUDIO_BLOCK_SAMPLES; }
+
+		// -60 dB after m_decay seconds
+		const float gain = powf(10.0f, -3.0f * length / (m_decay * AUDIO_SAMPLE_RATE_EXACT));
+		m_lineGain[k] = static_cast<int16_t>(gain * matrixScale * 32767.0f);
+		m_lineLength[k] = length;
+	}
+}
+
+void AudioEffectFdnReverb::m_requestReads()
+{
+	size_t offsetWords[NUM_LINES];
+	int16_t *dest[NUM_LINES];
+	size_t numWords[NUM_LINES];
+
+	// The newest block is about to be written at the write position, read the block that
+	// is the line length older. The guard after the line means it never wraps.
+	for (unsigned k=0; k<NUM_LINES; k++) {
+		const size_t write = m_lineWrite[k];
+		const size_t length = m_lineLength[k];
+		const size_t read = (write >= length) ? (write - length) : (write + m_lineBuffer[k] - length);
+		offsetWords[k] = m_lineBase[k] + read;
+		dest[k] = m_lineOut[k];
+		numWords[k] = AUDIO_BLOCK_SAMPLES;
+	}
+	m_slot->readBatch16(offsetWords, dest, numWords, NUM_LINES);
+}
+
+// A chain of Schroeder allpasses, v[n] = x[n] + g*v[n-D], y[n] = v[n-D] - g*v[n]
+void AudioEffectFdnReverb::m_diffuse(int16_t *out, const int16_t *in)
+{
+	if (in) { memcpy(out, in, sizeof(int16_t)*AUDIO_BLOCK_SAMPLES); }
+	else    { memset(out, 0, sizeof(int16_t)*AUDIO_BLOCK_SAMPLES); }
+
+	const int32_t coeff = m_diffusionCoeff;
+	int16_t *buffer = m_diffuserBuffer;
+	for (unsigned d=0; d<NUM_DIFFUSERS; d++) {
+		const unsigned length = DIFFUSER_SAMPLES[d];
+		unsigned index = m_diffuserIndex[d];
+		for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+			const int32_t delayed = buffer[index];
+			const int16_t v = simd::saturate16(out[i] + ((coeff * delayed) >> 15));
+			buffer[index] = v;
+			out[i] = simd::saturate16(delayed - ((coeff * v) >> 15));
+			if (++index >= length) { index = 0; }
+		}
+		m_diffuserIndex[d] = index;
+		buffer += length;
+	}
+}
+
+// Damp and decay each line, mix them with the feedback matrix then add the input
+void AudioEffectFdnReverb::m_processLines(const int16_t *in, int32_t *wet)
+{
+	const int32_t coeff = m_dampingCoeff;
+	memset(wet, 0, sizeof(int32_t)*AUDIO_BLOCK_SAMPLES);
+
+	for (unsigned k=0; k<NUM_LINES; k++) {
+		const int16_t *y = m_lineOut[k];
+		int32_t *z = m_work[k];
+		const int32_t gain = m_lineGain[k];
+		int32_t lowpass = m_lowpass[k];
+		// Truncate toward zero. Rounding down biases the recirculating signal and rounding
+		// to nearest has a deadband, either leaves a low level limit cycle in the tail.
+		for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+			lowpass += (coeff * (y[i] - lowpass)) / 32768;
+			z[i] = (gain * lowpass) / 32768;
+		}
+		m_lowpass[k] = lowpass;
+
+		// alternate the signs of the output taps to decorrelate them
+		if (k & 0x1) { for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) { wet[i] -= y[i]; } }
+		else         { for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) { wet[i] += y[i]; } }
+	}
+
+	if (m_mixing == Mixing::HADAMARD) {
+		// Fast Walsh-Hadamard transform, log2(N) stages of add/subtract butterflies
+		// across whole blocks. The 1/sqrt(N) normalization is in the line gains.
+		for (unsigned span=1; span<NUM_LINES; span <<= 1) {
+			for (unsigned k=0; k<NUM_LINES; k += 2*span) {
+				for (unsigned j=k; j<k+span; j++) {
+					int32_t *a = m_work[j];
+					int32_t *b = m_work[j+span];
+					for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+						const int32_t sum = a[i] + b[i];
+						b[i] = a[i] - b[i];
+						a[i] = sum;
+					}
+				}
+			}
+		}
+	} else {
+		// Householder reflection, z = z - (2/N)*sum(z)
+		for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+			int32_t sum = 0;
+			for (unsigned k=0; k<NUM_LINES; k++) { sum += m_work[k][i]; }
+			const int32_t reflect = (2*sum) / static_cast<int32_t>(NUM_LINES);
+			for (unsigned k=0; k<NUM_LINES; k++) { m_work[k][i] -= reflect; }
+		}
+	}
+
+	// add the diffused input with alternating signs
+	const int32_t inputGain = static_cast<int32_t>(INPUT_GAIN * 32767.0f);
+	int32_t input[AUDIO_BLOCK_SAMPLES];
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) { input[i] = (inputGain * in[i]) >> 15; }
+	for (unsigned k=0; k<NUM_LINES; k++) {
+		const int32_t *z = m_work[k];
+		int16_t *x = m_lineIn[k];
+		if (k & 0x1) { for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) { x[i] = simd::saturate16(z[i] - input[i]); } }
+		else         { for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) { x[i] = simd::saturate16(z[i] + input[i]); } }
+	}
+}
+
+void AudioEffectFdnReverb::m_writeLines()
+{
+	for (unsigned k=0; k<NUM_LINES; k++) {
+		m_slot->write16(m_lineBase[k] + m_lineWrite[k], m_lineIn[k], AUDIO_BLOCK_SAMPLES);
+		if (m_lineWrite[k] == 0) {
+			// the guard after the line repeats its first block
+			m_slot->write16(m_lineBase[k] + m_lineBuffer[k], m_lineIn[k], AUDIO_BLOCK_SAMPLES);
+		}
+		m_lineWrite[k] += AUDIO_BLOCK_SAMPLES;
+		if (m_lineWrite[k] >= m_lineBuffer[k]) { m_lineWrite[k] = 0; }
+	}
+}
+
+}
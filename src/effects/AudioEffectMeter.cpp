@@ -0,0 +1,182 @@
+/*
+ * AudioEffectMeter.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include "LibBasicFunctions.h"
+#include "AudioEffectMeter.h"
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr float PEAK_SCALE = 1.0f / 32768.0f;
+constexpr float MEAN_SQUARE_SCALE = 1.0f / (32768.0f * 32768.0f * AUDIO_BLOCK_SAMPLES);
+constexpr float SILENCE_DB = -200.0f;
+
+AudioEffectMeter::AudioEffectMeter(float fastMs, float slowMs, float slidingMs)
+: AudioStream(1, m_inputQueueArray)
+{
+	setTimeConstant(Window::FAST, fastMs);
+	setTimeConstant(Window::SLOW, slowMs);
+
+	size_t slidingBlocks = calcAudioSamples(slidingMs) / AUDIO_BLOCK_SAMPLES;
+	m_slidingBlocks = (slidingBlocks > 0) ? slidingBlocks : 1;
+	m_slidingSums  = new int64_t[m_slidingBlocks]();
+	m_slidingPeaks = new int32_t[m_slidingBlocks]();
+
+	memset(&m_levels, 0, sizeof(m_levels));
+}
+
+AudioEffectMeter::~AudioEffectMeter()
+{
+	if (m_slidingSums)  delete [] m_slidingSums;
+	if (m_slidingPeaks) delete [] m_slidingPeaks;
+}
+
+void AudioEffectMeter::setTimeConstant(Window window, float milliseconds)
+{
+	const unsigned index = static_cast<unsigned>(window);
+	if (index >= NUM_EXP_WINDOWS) { return; }
+
+	// One pole smoothing evaluated once per block, y += c*(x - y)
+	const float blockMs = calcAudioTimeMs(AUDIO_BLOCK_SAMPLES);
+	m_expCoeff[index] = (milliseconds > blockMs) ? (1.0f - expf(-blockMs / milliseconds)) : 1.0f;
+}
+
+void AudioEffectMeter::update(void)
+{
+	audio_block_t *inputAudioBlock = receiveReadOnly(); // get the next block of input samples
+
+	// Check is block is disabled
+	if (m_enable == false) {
+		// do not transmit or process any audio, return as quickly as possible.
+		if (inputAudioBlock) release(inputAudioBlock);
+		return;
+	}
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if (m_bypass == true) {
+		// transmit the input directly
+		if (!inputAudioBlock) {
+			// create silence
+			inputAudioBlock = allocate();
+			if (!inputAudioBlock) { return; } // failed to allocate
+			else {
+				clearAudioBlock(inputAudioBlock);
+			}
+		}
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return;
+	}
+
+	if (inputAudioBlock) {
+		m_measure(inputAudioBlock->data);
+		transmit(inputAudioBlock);
+		release(inputAudioBlock);
+	} else {
+		// no input is silence
+		int16_t silence[AUDIO_BLOCK_SAMPLES] = {};
+		m_measure(silence);
+	}
+}
+
+void AudioEffectMeter::m_measure(const int16_t *samples)
+{
+	int32_t blockPeak;
+	int64_t blockSum;
+	measureSamples(samples, AUDIO_BLOCK_SAMPLES, &blockPeak, &blockSum);
+
+	const float peak = PEAK_SCALE * blockPeak;
+	const float meanSquare = MEAN_SQUARE_SCALE * static_cast<float>(blockSum);
+	Levels levels;
+
+	// Exponential windows, the peak decays with the same time constant
+	for (unsigned i=0; i<NUM_EXP_WINDOWS; i++) {
+		m_expMeanSquare[i] += m_expCoeff[i] * (meanSquare - m_expMeanSquare[i]);
+		const float decayedPeak = m_expPeak[i] * (1.0f - m_expCoeff[i]);
+		m_expPeak[i] = (peak > decayedPeak) ? peak : decayedPeak;
+
+		levels.peak[i] = m_expPeak[i];
+		levels.meanSquare[i] = m_expMeanSquare[i];
+	}
+
+	// Sliding window, the oldest block is replaced with the new one
+	m_slidingSum += blockSum - m_slidingSums[m_slidingIndex];
+	m_slidingSums[m_slidingIndex] = blockSum;
+	m_slidingPeaks[m_slidingIndex] = blockPeak;
+	m_slidingIndex = (m_slidingIndex + 1 < m_slidingBlocks) ? m_slidingIndex + 1 : 0;
+
+	int32_t slidingPeak = 0;
+	for (unsigned i=0; i<m_slidingBlocks; i++) {
+		slidingPeak = (m_slidingPeaks[i] > slidingPeak) ? m_slidingPeaks[i] : slidingPeak;
+	}
+	const unsigned sliding = static_cast<unsigned>(Window::SLIDING);
+	levels.peak[sliding] = PEAK_SCALE * slidingPeak;
+	levels.meanSquare[sliding] = MEAN_SQUARE_SCALE * static_cast<float>(m_slidingSum) / static_cast<float>(m_slidingBlocks);
+
+	m_publish(levels);
+}
+
+// Publish with a sequence lock. Only the audio interrupt writes so it never waits,
+// readers retry if the interrupt updated the levels while they were copying.
+void AudioEffectMeter::m_publish(const Levels &levels)
+{
+	const uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_levels = levels;
+	m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void AudioEffectMeter::getReadings(Reading *readings) const
+{
+	if (!readings) { return; }
+
+	Levels levels;
+	uint32_t before, after;
+	do {
+		before = m_sequence.load(std::memory_order_acquire);
+		levels = m_levels;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = m_sequence.load(std::memory_order_relaxed);
+	} while ((before != after) || (before & 0x1));
+
+	for (unsigned i=0; i<NUM_WINDOWS; i++) {
+		readings[i].peak = levels.peak[i];
+		readings[i].rms = sqrtf(levels.meanSquare[i]);
+		readings[i].crest = (readings[i].rms > 0.0f) ? (readings[i].peak / readings[i].rms) : 0.0f;
+	}
+}
+
+AudioEffectMeter::Reading AudioEffectMeter::getReading(Window window) const
+{
+	Reading readings[NUM_WINDOWS];
+	getReadings(readings);
+	const unsigned index = static_cast<unsigned>(window);
+	return (index < NUM_WINDOWS) ? readings[index] : Reading();
+}
+
+float AudioEffectMeter::toDb(float level)
+{
+	if (level <= 0.0f) { return SILENCE_DB; }
+	return 20.0f * log10f(level);
+}
+
+}
@@ -0,0 +1,333 @@
+/*
+ * AudioEffectModulatedDelay.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AudioEffectModulatedDelay.h"
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+constexpr float MAX_RATE_HZ = 10.0f;
+constexpr float MAX_DEPTH_MS = 10.0f;
+constexpr float SAMPLES_PER_MS = AUDIO_SAMPLE_RATE_EXACT / 1000.0f;
+constexpr float Q16_SCALE = 65536.0f;
+
+AudioEffectModulatedDelay::AudioEffectModulatedDelay(float maxDelayMs)
+: AudioStream(1, m_inputQueueArray)
+{
+	// one extra sample for the older half of the interpolated pair
+	const size_t maxDelaySamples = calcAudioSamples(maxDelayMs) + 1;
+	m_memory = new DelayLine(maxDelaySamples);
+	m_maxSweep = static_cast<uint32_t>(maxDelaySamples - 1) << 16;
+
+	// allocate the LFO outputs for every voice now, voices() only changes the phases
+	const float phases[MAX_VOICES] = {};
+	m_osc.setPhaseOffsets(MAX_VOICES, phases);
+	setPreset(Preset::CHORUS);
+}
+
+AudioEffectModulatedDelay::~AudioEffectModulatedDelay()
+{
+	if (m_memory) delete m_memory;
+}
+
+void AudioEffectModulatedDelay::update(void)
+{
+	// Check is block is disabled
+	if (m_enable == false) {
+		// do not transmit or process any audio, return as quickly as possible.
+		return;
+	}
+
+	audio_block_t *inputAudioBlock = receiveReadOnly(); // get the next block of input samples
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if ((m_bypass == true) || (!inputAudioBlock)) {
+		// transmit the input directly
+		if (!inputAudioBlock) {
+			// create silence
+			inputAudioBlock = allocate();
+			if (!inputAudioBlock) { return; } // failed to allocate
+			else {
+				clearAudioBlock(inputAudioBlock);
+			}
+		}
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return;
+	}
+
+	audio_block_t *blockToOutput = allocate();
+	if (!blockToOutput) {
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return; // skip this update cycle due to failure
+	}
+
+	// Spread the voices evenly around the LFO cycle. The number of outputs doesn't
+	// change so this never allocates.
+	const unsigned numVoices = m_numVoices;
+	if (m_activeVoices != numVoices) {
+		float phases[MAX_VOICES];
+		for (unsigned voice=0; voice<MAX_VOICES; voice++) {
+			phases[voice] = (360.0f * voice) / numVoices;
+		}
+		m_osc.setPhaseOffsets(MAX_VOICES, phases);
+		m_activeVoices = numVoices;
+	}
+	int16_t * const *lfo = m_osc.getNextVectors();
+
+	uint32_t delays[AUDIO_BLOCK_SAMPLES];
+	int16_t  wet[AUDIO_BLOCK_SAMPLES];
+	int32_t  wetSum[AUDIO_BLOCK_SAMPLES];
+
+	// The first voice writes the input to the delay line along with its feedback
+	m_calcDelays(delays, lfo[0]);
+	m_memory->addBlockModulated(inputAudioBlock->data, delays, m_feedback, wet);
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		wetSum[i] = wet[i];
+	}
+
+	// The other voices only read the delay line
+	for (unsigned voice=1; voice<numVoices; voice++) {
+		m_calcDelays(delays, lfo[voice]);
+		m_memory->getSamplesModulated(wet, delays);
+		for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+			wetSum[i] += wet[i];
+		}
+	}
+
+	// Mix and set the output volume in one pass, the voices are averaged
+	const int32_t dryGain = static_cast<int32_t>(m_volume * (1.0f - m_mix) * 32767.0f);
+	const int32_t wetGain = static_cast<int32_t>(m_volume * m_mix * 32767.0f / numVoices);
+	const int16_t *dry = inputAudioBlock->data;
+	int16_t *out = blockToOutput->data;
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		out[i] = simd::saturate16(simd::qadd(dryGain * dry[i], wetGain * wetSum[i]) >> 15);
+	}
+
+	transmit(blockToOutput);
+	release(blockToOutput);
+	release(inputAudioBlock);
+}
+
+void AudioEffectModulatedDelay::setPreset(Preset preset)
+{
+	switch(preset) {
+	case Preset::FLANGER :
+		voices(1);
+		delay(1.0f);
+		depth(3.0f);
+		rate(0.2f);
+		feedback(0.6f);
+		mix(0.5f);
+		setWaveform(Waveform::TRIANGLE);
+		break;
+	case Preset::VIBRATO :
+		voices(1);
+		delay(5.0f);
+		depth(2.0f);
+		rate(5.0f);
+		feedback(0.0f);
+		mix(1.0f);
+		setWaveform(Waveform::SINE);
+		break;
+	case Preset::CHORUS :
+	default :
+		voices(3);
+		delay(15.0f);
+		depth(4.0f);
+		rate(0.8f);
+		feedback(0.0f);
+		mix(0.5f);
+		setWaveform(Waveform::SINE);
+		break;
+	}
+}
+
+void AudioEffectModulatedDelay::rate(float rateHz)
+{
+	m_rate = rateHz;
+	m_osc.setRateAudio(rateHz);
+}
+
+void AudioEffectModulatedDelay::depth(float milliseconds)
+{
+	m_depthMs = milliseconds;
+	m_updateSweep();
+}
+
+void AudioEffectModulatedDelay::delay(float milliseconds)
+{
+	m_delayMs = milliseconds;
+	m_updateSweep();
+}
+
+void AudioEffectModulatedDelay::voices(unsigned numVoices)
+{
+	if (numVoices < 1) { numVoices = 1; }
+	if (numVoices > MAX_VOICES) { numVoices = MAX_VOICES; }
+	m_numVoices = numVoices;
+}
+
+void AudioEffectModulatedDelay::setWaveform(Waveform waveform)
+{
+	m_waveform = waveform;
+	m_osc.setWaveform(waveform);
+}
+
+void AudioEffectModulatedDelay::processMidi(int channel, int control, int value)
+{
+
+	float val = (float)value / 127.0f;
+
+	if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+		// Bypass
+		if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectModulatedDelay::not bypassed -> ON") + value); }
+		else { bypass(true); if (Serial) Serial.println(String("AudioEffectModulatedDelay::bypassed -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[RATE][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[RATE][MIDI_CONTROL] == control)) {
+		// Rate
+		rate(val * MAX_RATE_HZ);
+		if (Serial) { Serial.println(String("AudioEffectModulatedDelay::rate (Hz): ") + m_rate); }
+		return;
+	}
+
+	if ((m_midiConfig[DEPTH][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DEPTH][MIDI_CONTROL] == control)) {
+		// Depth
+		depth(val * MAX_DEPTH_MS);
+		if (Serial) { Serial.println(String("AudioEffectModulatedDelay::depth (ms): ") + m_depthMs); }
+		return;
+	}
+
+	if ((m_midiConfig[DELAY][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DELAY][MIDI_CONTROL] == control)) {
+		// Delay
+		delay(val * (m_maxSweep / Q16_SCALE) / SAMPLES_PER_MS);
+		if (Serial) { Serial.println(String("AudioEffectModulatedDelay::delay (ms): ") + m_delayMs); }
+		return;
+	}
+
+	if ((m_midiConfig[FEEDBACK][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[FEEDBACK][MIDI_CONTROL] == control)) {
+		// Feedback
+		if (Serial) { Serial.println(String("AudioEffectModulatedDelay::feedback: ") + 100*val + String("%")); }
+		feedback(val);
+		return;
+	}
+
+	if ((m_midiConfig[MIX][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[MIX][MIDI_CONTROL] == control)) {
+		// Mix
+		if (Serial) { Serial.println(String("AudioEffectModulatedDelay::mix: Dry: ") + 100*(1-val) + String("% Wet: ") + 100*val ); }
+		mix(val);
+		return;
+	}
+
+	if ((m_midiConfig[VOICES][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOICES][MIDI_CONTROL] == control)) {
+		// Voices, the CC range is split evenly
+		voices(1 + (value * MAX_VOICES) / 128);
+		if (Serial) { Serial.println(String("AudioEffectModulatedDelay::voices: ") + m_numVoices); }
+		return;
+	}
+
+	if ((m_midiConfig[WAVEFORM][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[WAVEFORM][MIDI_CONTROL] == control)) {
+		// Waveform
+		if (value < 16) {
+			setWaveform(Waveform::SINE);
+		} else if (value < 32) {
+			setWaveform(Waveform::TRIANGLE);
+		} else if (value < 48) {
+			setWaveform(Waveform::SQUARE);
+		} else if (value < 64) {
+			setWaveform(Waveform::SAWTOOTH);
+		} else if (value < 80) {
+			setWaveform(Waveform::RANDOM);
+		}
+
+		if (Serial) { Serial.println(String("AudioEffectModulatedDelay::waveform: ") + static_cast<unsigned>(m_waveform)); }
+		return;
+	}
+
+	if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+		// Volume
+		if (Serial) { Serial.println(String("AudioEffectModulatedDelay::volume: ") + 100*val + String("%")); }
+		volume(val);
+		return;
+	}
+
+}
+
+void AudioEffectModulatedDelay::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+	if (parameter >= NUM_CONTROLS) {
+		return ; // Invalid midi parameter
+	}
+	m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+	m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+//////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////
+
+// Convert the delay and depth to Q16.16 samples, limited so the sweep stays within
+// one sample and the end of the delay line.
+void AudioEffectModulatedDelay::m_updateSweep()
+{
+	const float maxSweep = m_maxSweep / Q16_SCALE;
+
+	float delaySamples = m_delayMs * SAMPLES_PER_MS;
+	if (delaySamples < 1.0f) { delaySamples = 1.0f; }
+	if (delaySamples > maxSweep) { delaySamples = maxSweep; }
+
+	float depthSamples = m_depthMs * SAMPLES_PER_MS;
+	if (depthSamples < 0.0f) { depthSamples = 0.0f; }
+	if (delaySamples + depthSamples > maxSweep) { depthSamples = maxSweep - delaySamples; }
+
+	m_delayQ16 = static_cast<uint32_t>(delaySamples * Q16_SCALE);
+	m_depthQ16 = static_cast<uint32_t>(depthSamples * Q16_SCALE);
+}
+
+// delay = delay() + depth()*(lfo+1)/2 in Q16.16 samples
+void AudioEffectModulatedDelay::m_calcDelays(uint32_t *delays, const int16_t *lfo)
+{
+	const uint32_t delayQ16 = m_delayQ16;
+	const uint64_t depthQ16 = m_depthQ16;
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		// signed so an lfo of -32768 can't wrap, clamped to 0 to 32767
+		const int32_t position = (static_cast<int32_t>(lfo[i]) + 32767) >> 1;
+		const uint32_t unipolar = (position > 0) ? static_cast<uint32_t>(position) : 0;
+		delays[i] = delayQ16 + static_cast<uint32_t>((depthQ16 * unipolar) >> 15);
+	}
+}
+
+}
@@ -0,0 +1,336 @@
+/*
+ * AudioEffectPitchShift.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include "AudioEffectPitchShift.h"
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+constexpr float MAX_SEMITONES = 12.0f;
+constexpr float Q16_SCALE = 65536.0f;
+
+// The splice search evaluates LAGS_PER_BLOCK jumps each block, then the heads are
+// crossfaded. The head must not leave the delay line before that finishes, so the
+// search starts TRIGGER_SAMPLES from the end. The head moves at most one sample per
+// sample when shifting up an octave.
+constexpr unsigned LAGS_PER_BLOCK   = 256;
+constexpr unsigned SEARCH_BLOCKS    = 2;   // MAX_LAG / LAGS_PER_BLOCK
+constexpr unsigned CROSSFADE_SHIFT  = 8;
+constexpr unsigned CROSSFADE_SAMPLES = 1 << CROSSFADE_SHIFT;
+constexpr unsigned TRIGGER_SAMPLES  = (SEARCH_BLOCKS + 1) * AUDIO_BLOCK_SAMPLES + CROSSFADE_SAMPLES;
+
+// The heads stay between MIN_DELAY and MAX_DELAY samples, a splice jumps between
+// WINDOW - MAX_LAG and WINDOW samples.
+constexpr int     WINDOW    = 1024;
+constexpr int64_t MIN_DELAY = 2;
+constexpr int64_t MAX_DELAY = MIN_DELAY + TRIGGER_SAMPLES + WINDOW;
+
+AudioEffectPitchShift::AudioEffectPitchShift()
+: AudioStream(1, m_inputQueueArray)
+{
+	// the up shift search reads the candidates one block past the longest delay
+	m_memory = new DelayLine(MAX_DELAY + AUDIO_BLOCK_SAMPLES);
+
+	for (unsigned voice=0; voice<MAX_VOICES; voice++) {
+		m_voices[voice].delay = ((MIN_DELAY + MAX_DELAY) / 2) << 16;
+	}
+	shift(0, 12.0f);
+	shift(1, 7.0f);
+}
+
+AudioEffectPitchShift::~AudioEffectPitchShift()
+{
+	if (m_memory) delete m_memory;
+}
+
+void AudioEffectPitchShift::update(void)
+{
+	// Check is block is disabled
+	if (m_enable == false) {
+		// do not transmit or process any audio, return as quickly as possible.
+		return;
+	}
+
+	audio_block_t *inputAudioBlock = receiveReadOnly(); // get the next block of input samples
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if ((m_bypass == true) || (!inputAudioBlock)) {
+		// transmit the input directly
+		if (!inputAudioBlock) {
+			// create silence
+			inputAudioBlock = allocate();
+			if (!inputAudioBlock) { return; } // failed to allocate
+			else {
+				clearAudioBlock(inputAudioBlock);
+			}
+		}
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return;
+	}
+
+	audio_block_t *blockToOutput = allocate();
+	if (!blockToOutput) {
+		transmit(inputAudioBlock, 0);
+		release(inputAudioBlock);
+		return; // skip this update cycle due to failure
+	}
+
+	m_memory->addBlock(inputAudioBlock);
+
+	const unsigned numVoices = m_numVoices;
+	int16_t wet[AUDIO_BLOCK_SAMPLES];
+	int32_t wetSum[AUDIO_BLOCK_SAMPLES] = {};
+	for (unsigned voice=0; voice<numVoices; voice++) {
+		m_processVoice(m_voices[voice], wet);
+		for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+			wetSum[i] += wet[i];
+		}
+	}
+
+	// Mix and set the output volume in one pass, the voices are averaged
+	const int32_t dryGain = static_cast<int32_t>(m_volume * (1.0f - m_mix) * 32767.0f);
+	const int32_t wetGain = static_cast<int32_t>(m_volume * m_mix * 32767.0f / numVoices);
+	const int16_t *dry = inputAudioBlock->data;
+	int16_t *out = blockToOutput->data;
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		out[i] = simd::saturate16(simd::qadd(dryGain * dry[i], wetGain * wetSum[i]) >> 15);
+	}
+
+	transmit(blockToOutput);
+	release(blockToOutput);
+	release(inputAudioBlock);
+}
+
+void AudioEffectPitchShift::shift(unsigned voice, float semitones)
+{
+	if (voice >= MAX_VOICES) { return; }
+	if (semitones >  MAX_SEMITONES) { semitones =  MAX_SEMITONES; }
+	if (semitones < -MAX_SEMITONES) { semitones = -MAX_SEMITONES; }
+
+	// the delay changes by 1 - ratio samples every sample
+	const float ratio = powf(2.0f, semitones / 12.0f);
+	m_voices[voice].semitones = semitones;
+	m_voices[voice].step = static_cast<int32_t>((1.0f - ratio) * Q16_SCALE);
+}
+
+void AudioEffectPitchShift::voices(unsigned numVoices)
+{
+	if (numVoices < 1) { numVoices = 1; }
+	if (numVoices > MAX_VOICES) { numVoices = MAX_VOICES; }
+	m_numVoices = numVoices;
+}
+
+void AudioEffectPitchShift::processMidi(int channel, int control, int value)
+{
+
+	float val = (float)value / 127.0f;
+
+	if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+		// Bypass
+		if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectPitchShift::not bypassed -> ON") + value); }
+		else { bypass(true); if (Serial) Serial.println(String("AudioEffectPitchShift::bypassed -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[SHIFT_1][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[SHIFT_1][MIDI_CONTROL] == control)) {
+		// Shift, in whole semitones
+		shift(0, roundf((2.0f * val - 1.0f) * MAX_SEMITONES));
+		if (Serial) { Serial.println(String("AudioEffectPitchShift::shift 1 (semitones): ") + m_voices[0].semitones); }
+		return;
+	}
+
+	if ((m_midiConfig[SHIFT_2][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[SHIFT_2][MIDI_CONTROL] == control)) {
+		// Shift, in whole semitones
+		shift(1, roundf((2.0f * val - 1.0f) * MAX_SEMITONES));
+		if (Serial) { Serial.println(String("AudioEffectPitchShift::shift 2 (semitones): ") + m_voices[1].semitones); }
+		return;
+	}
+
+	if ((m_midiConfig[VOICES][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOICES][MIDI_CONTROL] == control)) {
+		// Voices, the CC range is split evenly
+		voices(1 + (value * MAX_VOICES) / 128);
+		if (Serial) { Serial.println(String("AudioEffectPitchShift::voices: ") + m_numVoices); }
+		return;
+	}
+
+	if ((m_midiConfig[MIX][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[MIX][MIDI_CONTROL] == control)) {
+		// Mix
+		if (Serial) { Serial.println(String("AudioEffectPitchShift::mix: Dry: ") + 100*(1-val) + String("% Wet: ") + 100*val ); }
+		mix(val);
+		return;
+	}
+
+	if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+		// Volume
+		if (Serial) { Serial.println(String("AudioEffectPitchShift::volume: ") + 100*val + String("%")); }
+		volume(val);
+		return;
+	}
+
+}
+
+void AudioEffectPitchShift::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+	if (parameter >= NUM_CONTROLS) {
+		return ; // Invalid midi parameter
+	}
+	m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+	m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+///////////////////////////////////////////////////////////////////////////////
+
+void AudioEffectPitchShift::m_processVoice(Voice &voice, int16_t *out)
+{
+	const int32_t step = voice.step; // may be changed by shift() during the block
+
+	switch (voice.state) {
+	case State::RUNNING :
+		// Shifting up the delay shrinks so the head jumps back, shifting down it jumps forward
+		if ((step < 0) && (voice.delay <= ((MIN_DELAY + TRIGGER_SAMPLES) << 16))) {
+			m_startSearch(voice, WINDOW - MAX_LAG);
+		} else if ((step > 0) && (voice.delay >= ((MAX_DELAY - TRIGGER_SAMPLES) << 16))) {
+			m_startSearch(voice, -WINDOW);
+		}
+		break;
+	case State::SEARCH :
+		if ((voice.jumpLow > 0) != (step < 0)) {
+			voice.state = State::RUNNING; // the direction changed, the search is no longer valid
+		} else {
+			m_searchSplice(voice);
+		}
+		break;
+	default :
+		break;
+	}
+
+	// Play the active head
+	uint32_t delays[AUDIO_BLOCK_SAMPLES];
+	voice.delay = m_calcDelays(delays, voice.delay, step);
+	m_memory->getSamplesModulated(out, delays);
+
+	if (voice.state == State::CROSSFADE) {
+		// Fade in the new head with a linear crossfade
+		int16_t next[AUDIO_BLOCK_SAMPLES];
+		voice.nextDelay = m_calcDelays(delays, voice.nextDelay, step);
+		m_memory->getSamplesModulated(next, delays);
+
+		for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+			const int32_t fadeOut = ((CROSSFADE_SAMPLES - voice.fade - i) * 32767) >> CROSSFADE_SHIFT;
+			const int32_t gains = simd::pack16(fadeOut, 32767 - fadeOut);
+			out[i] = static_cast<int16_t>(simd::smlad(simd::pack16(out[i], next[i]), gains, 1 << 14) >> 15);
+		}
+
+		voice.fade += AUDIO_BLOCK_SAMPLES;
+		if (voice.fade >= CROSSFADE_SAMPLES) {
+			voice.delay = voice.nextDelay;
+			voice.state = State::RUNNING;
+		}
+	}
+}
+
+// Ramp the delay of a head across the block. When the shift changes direction the
+// head can be near the wrong end of the delay line, it holds there until it is spliced.
+int64_t AudioEffectPitchShift::m_calcDelays(uint32_t *delays, int64_t delay, int32_t step)
+{
+	constexpr int64_t minDelay = MIN_DELAY << 16;
+	constexpr int64_t maxDelay = MAX_DELAY << 16;
+	for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		delay = (delay < minDelay) ? minDelay : ((delay > maxDelay) ? maxDelay : delay);
+		delays[i] = static_cast<uint32_t>(delay);
+		delay += step;
+	}
+	return (delay < minDelay) ? minDelay : ((delay > maxDelay) ? maxDelay : delay);
+}
+
+// Copy the audio at the active head and at every candidate jump. For lag L the jump
+// is jumpLow + L samples, and the audio at the jump starts at candidates[MAX_LAG - L].
+void AudioEffectPitchShift::m_startSearch(Voice &voice, int jumpLow)
+{
+	const int delay = static_cast<int>(voice.delay >> 16);
+	m_memory->getSamples(voice.reference, delay, CORR_SAMPLES);
+	m_memory->getSamples(voice.candidates, delay + jumpLow, CORR_SAMPLES + MAX_LAG);
+
+	int64_t energy = 0;
+	const int16_t *candidate = voice.candidates + MAX_LAG;
+	for (unsigned i=0; i<CORR_SAMPLES; i++) {
+		energy += candidate[i] * candidate[i];
+	}
+
+	voice.jumpLow = jumpLow;
+	voice.lag = 0;
+	voice.bestLag = 0;
+	voice.bestScore = -1.0e30f;
+	voice.energy = energy;
+	voice.state = State::SEARCH;
+	m_searchSplice(voice);
+}
+
+// Evaluate the next LAGS_PER_BLOCK lags. The score is the correlation normalized by the
+// candidate energy, keeping the sign so only in phase splices are chosen. The energy
+// slides with the lag so it costs two multiplies per lag.
+void AudioEffectPitchShift::m_searchSplice(Voice &voice)
+{
+	unsigned lag = voice.lag;
+	const unsigned lastLag = (lag + LAGS_PER_BLOCK < MAX_LAG) ? lag + LAGS_PER_BLOCK : MAX_LAG;
+	int64_t energy = voice.energy;
+
+	for (; lag < lastLag; lag++) {
+		const int16_t *candidate = voice.candidates + MAX_LAG - lag;
+		int64_t corr = 0;
+		for (unsigned i=0; i<CORR_SAMPLES; i+=2) {
+			corr = simd::smlald(simd::load2(voice.reference + i), simd::load2(candidate + i), corr);
+		}
+
+		const float fcorr = static_cast<float>(corr);
+		const float score = ((fcorr < 0.0f) ? -fcorr * fcorr : fcorr * fcorr) / static_cast<float>(energy + 1);
+		if (score > voice.bestScore) {
+			voice.bestScore = score;
+			voice.bestLag = lag;
+		}
+
+		if (lag + 1 < MAX_LAG) {
+			energy += candidate[-1] * candidate[-1] - candidate[CORR_SAMPLES-1] * candidate[CORR_SAMPLES-1];
+		}
+	}
+	voice.lag = lag;
+	voice.energy = energy;
+
+	if (lag >= MAX_LAG) {
+		voice.nextDelay = voice.delay + static_cast<int64_t>(voice.jumpLow + static_cast<int>(voice.bestLag)) * 65536;
+		voice.fade = 0;
+		voice.state = State::CROSSFADE;
+	}
+}
+
+}
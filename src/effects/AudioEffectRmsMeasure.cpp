@@ -73,14 +73,8 @@ void AudioEffectRmsMeasure::update(void)
 
 	// First create the square sum of the input audio block and add it to the accumulator
 	int64_t dotProduct = 0;
-	//arm_dot_prod_q15(inputAudioBlock->data, inputAudioBlock->data, AUDIO_BLOCK_SAMPLES, &dotProduct);
-	for (int i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
-	    dotProduct += ((int64_t)inputAudioBlock->data[i] * (int64_t)inputAudioBlock->data[i]);
-	    if (dotProduct < 0) {
-	        if (Serial) { Serial.println("DOT ERROR!"); Serial.println(inputAudioBlock->data[i], HEX); }
-	    }
-	}
-	m_sum += (int64_t)(dotProduct);
+	measureSamples(inputAudioBlock->data, AUDIO_BLOCK_SAMPLES, nullptr, &dotProduct);
+	m_sum += dotProduct;
 
 	m_accumulatorCount++;
 
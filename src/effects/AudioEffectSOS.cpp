@@ -20,6 +20,7 @@
 
 #include "AudioEffectSOS.h"
 #include "LibBasicFunctions.h"
+#include "LibBlockOps.h"
 
 using namespace BALibrary;
 
@@ -51,6 +52,14 @@ AudioEffectSOS::AudioEffectSOS(size_t numSamples)
     m_externalMemory = false;
 }
 
+AudioEffectSOS::AudioEffectSOS(AudioDelayBackend backend, size_t numSamples)
+: AudioStream(1, m_inputQueueArray)
+{
+    m_memory = new AudioDelay(backend, numSamples);
+    m_maxDelaySamples = numSamples;
+    m_externalMemory = false;
+}
+
 AudioEffectSOS::AudioEffectSOS(ExtMemSlot *slot)
 : AudioStream(1, m_inputQueueArray)
 {
@@ -61,6 +70,7 @@ AudioEffectSOS::AudioEffectSOS(ExtMemSlot *slot)
 AudioEffectSOS::~AudioEffectSOS()
 {
     if (m_memory) delete m_memory;
+    if (m_layerData) delete [] m_layerData;
 }
 
 void AudioEffectSOS::setGateLedGpio(int pinId)
@@ -98,8 +108,8 @@ void AudioEffectSOS::update(void)
         if (m_previousBlock) {
             release(m_previousBlock); m_previousBlock = nullptr;
         }
-        if (!m_externalMemory) {
-            // when using internal memory we have to release all references in the ring buffer
+        if (m_memory->getRingBuffer()) {
+            // when using an internal ring we have to release all references in the ring buffer
             while (m_memory->getRingBuffer()->size() > 0) {
                 audio_block_t *releaseBlock = m_memory->getRingBuffer()->front();
                 m_memory->getRingBuffer()->pop_front();
@@ -129,6 +139,18 @@ void AudioEffectSOS::update(void)
 
     if (!inputAudioBlock) return;
 
+    if (m_numRegions) {
+        // Layered looper, release the blocks still held by the normal processing
+        if (m_previousBlock) {
+            release(m_previousBlock); m_previousBlock = nullptr;
+        }
+        if (m_blockToRelease) {
+            release(m_blockToRelease); m_blockToRelease = nullptr;
+        }
+        m_updateLayers(inputAudioBlock);
+        return;
+    }
+
     // Otherwise perform normal processing
     // In order to make use of the SPI DMA, we need to request the read from memory first,
     // then do other processing while it fills in the back.
@@ -136,29 +158,28 @@ void AudioEffectSOS::update(void)
     blockToOutput = allocate();
     if (!blockToOutput) return; // skip this update cycle due to failure
 
-    // get the data. If using external memory with DMA, this won't be filled until
-    // later.
-    m_memory->getSamples(blockToOutput, m_delaySamples);
-    // if (Serial) { Serial.println(String("Delay samples:") + m_delaySamples); }
-    // if (Serial) { Serial.println(String("Use dma: ") + m_memory->getSlot()->isUseDma()); }
-
-    // If using DMA, we need something else to do while that read executes, so
-    // move on to input preprocessing
+    // The memory accesses are compiled for each backend so there are no further
+    // checks on the memory type during the block.
+    audio_block_t *blockToRelease = m_memory->visit([&](auto *memory) {
+        // get the data. If using external memory with DMA, this won't be filled until
+        // later.
+        memory->getSamples(blockToOutput->data, m_delaySamples);
 
-    // Preprocessing
-    audio_block_t *preProcessed = allocate();
-    // mix the input with the feedback path in the pre-processing stage
-    m_preProcessing(preProcessed, inputAudioBlock, m_previousBlock);
+        // If using DMA, we need something else to do while that read executes, so
+        // move on to input preprocessing
 
-    audio_block_t *blockToRelease = m_memory->addBlock(preProcessed);
+        // Preprocessing
+        audio_block_t *preProcessed = allocate();
+        // mix the input with the feedback path in the pre-processing stage
+        m_preProcessing(preProcessed, inputAudioBlock, m_previousBlock);
 
+        audio_block_t *releaseBlock = memory->addBlock(preProcessed);
 
-    // BACK TO OUTPUT PROCESSING
-    // Check if external DMA, if so, we need to be sure the read is completed
-    if (m_externalMemory && m_memory->getSlot()->isUseDma()) {
-        // Using DMA
-        while (m_memory->getSlot()->isReadBusy()) {}
-    }
+        // BACK TO OUTPUT PROCESSING
+        // If using DMA, we need to be sure the read is completed
+        memory->waitForRead();
+        return releaseBlock;
+    });
 
     // perform the wet/dry mix mix
     m_postProcessing(blockToOutput, blockToOutput);
@@ -191,6 +212,241 @@ void AudioEffectSOS::gateCloseTime(float milliseconds)
     m_inputGateAuto.setupParameter(GATE_CLOSE_STAGE, 1.0f, 0.0f, m_closeTimeMs, ParameterAutomation<float>::Function::EXPONENTIAL);
 }
 
+////////////////////////////////////////////////////////////////////////
+// LAYERED LOOPER
+////////////////////////////////////////////////////////////////////////
+bool AudioEffectSOS::setLayers(unsigned numLayers)
+{
+    if (numLayers == 0) {
+        m_numRegions = 0;
+        return true;
+    }
+
+    if (!m_externalMemory) {
+        if (Serial) { Serial.println("AudioEffectSOS::setLayers(): layers require EXTERNAL memory"); }
+        return false;
+    }
+    if ((numLayers < 2) || (numLayers > MAX_LAYERS)) {
+        if (Serial) { Serial.println(String("AudioEffectSOS::setLayers(): numLayers must be from 2 to ") + MAX_LAYERS); }
+        return false;
+    }
+
+    // one region for the base plus one for each layer, each a whole number of audio blocks
+    ExtMemSlot *slot = m_memory->getSlot();
+    size_t regionSamples = (slot->size() / sizeof(int16_t)) / (numLayers+1);
+    regionSamples -= regionSamples % AUDIO_BLOCK_SAMPLES;
+    if (regionSamples == 0) {
+        if (Serial) { Serial.println("AudioEffectSOS::setLayers(): ExtMemSlot is too small"); }
+        return false;
+    }
+
+    if (!m_layerData) { m_layerData = new int16_t[(MAX_LAYERS+1)*AUDIO_BLOCK_SAMPLES]; }
+    if (!slot->isEnabled()) { slot->enable(); }
+#if defined(__IMXRT1062__)
+    setSpiDmaCopyBuffer(slot);
+#endif
+
+    __disable_irq();
+    m_regionSamples = regionSamples;
+    m_numRegions = numLayers+1;
+    m_clearRequest = true;
+    __enable_irq();
+
+    if (Serial) { Serial.println(String("AudioEffectSOS: max loop length ") + calcAudioTimeMs(regionSamples) + String(" ms")); }
+    return true;
+}
+
+bool AudioEffectSOS::m_isLayerActiveAt(unsigned layer, size_t position) const
+{
+    // layers recorded part way through the loop only play where they were recorded
+    size_t relativePosition = (position + m_loopLength - m_layerStart[layer]) % m_loopLength;
+    return relativePosition < m_layerLength[layer];
+}
+
+// Requests from the API are applied at block boundaries so the layer state only
+// changes inside update().
+void AudioEffectSOS::m_processLayerRequests(void)
+{
+    if (m_clearRequest) {
+        m_clearRequest = false;
+        m_recordRequest = m_stopRequest = m_undoRequest = m_redoRequest = false;
+        m_numLayers = 0;
+        m_numActiveLayers = 0;
+        m_loopLength = 0;
+        m_loopPosition = 0;
+        m_recording = false;
+        m_baseValid = false;
+        m_flattenRemaining = 0;
+        return;
+    }
+
+    const bool undoTake = m_undoRequest && m_recording;
+    if (undoTake) {
+        // undo while recording stops the current take, then undoes it
+        m_stopRequest = true;
+    }
+
+    if (m_stopRequest) {
+        m_stopRequest = false;
+        if (m_recording) {
+            m_recording = false;
+            unsigned layer = m_numLayers-1;
+            if (m_loopLength == 0) {
+                // the first layer sets the loop length and the loop starts over
+                m_loopLength = m_layerLength[layer];
+                m_loopPosition = 0;
+            }
+            if (m_layerLength[layer] == 0) {
+                // nothing was recorded, an undo of this take is already done
+                m_numLayers--;
+                m_numActiveLayers--;
+                if (undoTake) { m_undoRequest = false; }
+            } else if ((m_numLayers == m_numRegions-1) && (m_flattenRemaining == 0)) {
+                // all regions are used, flatten the oldest layer into the base over the next loop pass
+                m_flattenRemaining = m_loopLength;
+            }
+        }
+    }
+
+    if (m_undoRequest) {
+        m_undoRequest = false;
+        unsigned minActive = (m_flattenRemaining > 0) ? 1 : 0; // the layer being flattened can't be undone
+        if (m_numActiveLayers > minActive) { m_numActiveLayers--; }
+    }
+
+    if (m_redoRequest) {
+        m_redoRequest = false;
+        if (m_numActiveLayers < m_numLayers) { m_numActiveLayers++; }
+    }
+
+    if (m_recordRequest) {
+        m_recordRequest = false;
+        if (m_recording) { return; }
+
+        m_numLayers = m_numActiveLayers; // discard any undone layers
+        if (m_numLayers >= m_numRegions-1) {
+            if (Serial) { Serial.println("AudioEffectSOS: no free layer, wait for the flatten to finish"); }
+            return;
+        }
+
+        // find a free region, region 0 is the base
+        unsigned region;
+        for (region = 1; region < m_numRegions; region++) {
+            bool used = false;
+            for (unsigned i=0; i<m_numLayers; i++) {
+                if (m_layerRegion[i] == region) { used = true; break; }
+            }
+            if (!used) { break; }
+        }
+
+        if (m_loopLength == 0) { m_loopPosition = 0; }
+        m_layerRegion[m_numLayers] = region;
+        m_layerStart[m_numLayers] = m_loopPosition;
+        m_layerLength[m_numLayers] = 0;
+        m_numLayers++;
+        m_numActiveLayers++;
+        m_recording = true;
+    }
+}
+
+void AudioEffectSOS::m_updateLayers(audio_block_t *input)
+{
+    m_processLayerRequests();
+
+    audio_block_t *blockToOutput = allocate();
+    if (!blockToOutput) {
+        transmit(input, 0);
+        release(input);
+        return;
+    }
+
+    ExtMemSlot *slot = m_memory->getSlot();
+    size_t position = m_loopPosition;
+    unsigned recordLayer = m_numLayers-1;
+
+    // Queue the record write and the reads for every layer playing at this position. The
+    // reads are issued as one batch so they go out back-to-back on the SPI bus.
+    if (m_recording) {
+        memcpy(m_recordBuffer, input->data, sizeof(int16_t)*AUDIO_BLOCK_SAMPLES);
+        slot->write16(m_layerRegion[recordLayer]*m_regionSamples + position, m_recordBuffer, AUDIO_BLOCK_SAMPLES);
+    }
+
+    size_t offsetWords[ExtMemSlot::MAX_SLOT_BATCH_READS];
+    int16_t *dest[ExtMemSlot::MAX_SLOT_BATCH_READS];
+    size_t numWords[ExtMemSlot::MAX_SLOT_BATCH_READS];
+    unsigned numReads = 0;
+    int16_t *baseData = nullptr;
+    int16_t *oldestData = nullptr;
+
+    if (m_loopLength > 0) {
+        if (m_baseValid) {
+            baseData = m_layerData;
+            offsetWords[numReads] = position;
+            dest[numReads] = baseData;
+            numWords[numReads++] = AUDIO_BLOCK_SAMPLES;
+        }
+        for (unsigned layer=0; layer<m_numActiveLayers; layer++) {
+            if (!m_isLayerActiveAt(layer, position)) { continue; }
+            int16_t *layerData = m_layerData + (layer+1)*AUDIO_BLOCK_SAMPLES;
+            if (layer == 0) { oldestData = layerData; }
+            offsetWords[numReads] = m_layerRegion[layer]*m_regionSamples + position;
+            dest[numReads] = layerData;
+            numWords[numReads++] = AUDIO_BLOCK_SAMPLES;
+        }
+        if (numReads) { slot->readBatch16(offsetWords, dest, numWords, numReads); }
+    }
+
+    // start with the dry signal while the reads are in progress
+    memcpy(blockToOutput->data, input->data, sizeof(int16_t)*AUDIO_BLOCK_SAMPLES);
+    while (slot->isReadBusy()) {}
+
+    for (unsigned i=0; i<numReads; i++) {
+        addSamples(blockToOutput->data, dest[i], blockToOutput->data, AUDIO_BLOCK_SAMPLES);
+    }
+
+    if (m_flattenRemaining > 0) {
+        // Merge the oldest layer into the base at this position. Each position is visited once
+        // per pass, so until the pass is done the oldest layer is still played on its own.
+        if (!m_baseValid || oldestData) {
+            if (baseData) { memcpy(m_flattenBuffer, baseData, sizeof(int16_t)*AUDIO_BLOCK_SAMPLES); }
+            else          { memset(m_flattenBuffer, 0, sizeof(int16_t)*AUDIO_BLOCK_SAMPLES); }
+            if (oldestData) { addSamples(m_flattenBuffer, oldestData, m_flattenBuffer, AUDIO_BLOCK_SAMPLES); }
+            slot->write16(position, m_flattenBuffer, AUDIO_BLOCK_SAMPLES);
+        }
+
+        m_flattenRemaining -= AUDIO_BLOCK_SAMPLES;
+        if (m_flattenRemaining == 0) {
+            // the oldest layer is now part of the base, free its region
+            for (unsigned i=1; i<m_numLayers; i++) {
+                m_layerRegion[i-1] = m_layerRegion[i];
+                m_layerStart[i-1]  = m_layerStart[i];
+                m_layerLength[i-1] = m_layerLength[i];
+            }
+            m_numLayers--;
+            m_numActiveLayers--;
+            m_baseValid = true;
+        }
+    }
+
+    // advance the loop
+    position += AUDIO_BLOCK_SAMPLES;
+    if (m_recording) { m_layerLength[m_numLayers-1] += AUDIO_BLOCK_SAMPLES; }
+    if (m_loopLength == 0) {
+        // recording the first layer, stop when the region is full
+        if (m_recording && (position >= m_regionSamples)) { m_stopRequest = true; }
+    } else {
+        if (position >= m_loopLength) { position = 0; }
+        // overdubs stop after one full pass
+        if (m_recording && (m_layerLength[m_numLayers-1] >= m_loopLength)) { m_stopRequest = true; }
+    }
+    m_loopPosition = position;
+
+    m_postProcessing(blockToOutput, blockToOutput);
+    transmit(blockToOutput);
+    release(blockToOutput);
+    release(input);
+}
+
 ////////////////////////////////////////////////////////////////////////
 // MIDI PROCESSING
 ////////////////////////////////////////////////////////////////////////
@@ -247,6 +503,30 @@ void AudioEffectSOS::processMidi(int channel, int control, int value)
         return;
     }
 
+    if ((m_midiConfig[RECORD][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[RECORD][MIDI_CONTROL] == control)) {
+        // Record
+        if (value >= 65) { record(); if (Serial) Serial.println(String("AudioEffectSOS::record -> ON") + value); }
+        else { stopRecording(); if (Serial) Serial.println(String("AudioEffectSOS::record -> OFF") + value); }
+        return;
+    }
+
+    if ((m_midiConfig[UNDO][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[UNDO][MIDI_CONTROL] == control)) {
+        // Undo is triggered by any value
+        if (Serial) { Serial.println(String("AudioEffectSOS::Undo")); }
+        undo();
+        return;
+    }
+
+    if ((m_midiConfig[REDO][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[REDO][MIDI_CONTROL] == control)) {
+        // Redo is triggered by any value
+        if (Serial) { Serial.println(String("AudioEffectSOS::Redo")); }
+        redo();
+        return;
+    }
+
     if ((m_midiConfig[CLEAR_FEEDBACK_TRIGGER][MIDI_CHANNEL] == channel) &&
         (m_midiConfig[CLEAR_FEEDBACK_TRIGGER][MIDI_CONTROL] == control)) {
         // The gate is triggered by any value
@@ -275,13 +555,20 @@ void AudioEffectSOS::m_preProcessing (audio_block_t *out, audio_block_t *input,
         // Multiply the delayed signal by the user set feedback value
         // Then combine the two
 
-        float gateVol     = m_inputGateAuto.getNextValue();
-        float feedbackAdjust = m_clearFeedbackAuto.getNextValue();
-        audio_block_t tempAudioBuffer;
+        // The automations are evaluated per sample so fast gate ramps do not zipper
+        float gateVol[AUDIO_BLOCK_SAMPLES];
+        float feedbackAdjust[AUDIO_BLOCK_SAMPLES];
+        m_inputGateAuto.getNextVector(gateVol);
+        m_clearFeedbackAuto.getNextVector(feedbackAdjust);
+
+        int16_t gateGain[AUDIO_BLOCK_SAMPLES];
+        int16_t feedbackGain[AUDIO_BLOCK_SAMPLES];
+        for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+            gateGain[i]     = blockOps::toQ15Gain(gateVol[i]);
+            feedbackGain[i] = blockOps::toQ15Gain(m_feedback*feedbackAdjust[i]);
+        }
 
-        gainAdjust(out, input, gateVol, 0); // last paremeter is coeff shift, 0 bits
-        gainAdjust(&tempAudioBuffer, delayedSignal, m_feedback*feedbackAdjust, 0); // last parameter is coeff shift, 0 bits
-        combine(out, out, &tempAudioBuffer);
+        blockOps::evaluate(out, blockOps::scale(input, gateGain) + blockOps::scale(delayedSignal, feedbackGain));
 
     } else if (input) {
         memcpy(out->data, input->data, sizeof(int16_t) * AUDIO_BLOCK_SAMPLES);
@@ -0,0 +1,271 @@
+/*
+ * AudioEffectSOSF32.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: blackaddr
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AudioEffectSOSF32.h"
+
+#if BALIBRARY_F32
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+constexpr float MAX_GATE_OPEN_TIME_MS = 3000.0f;
+constexpr float MAX_GATE_CLOSE_TIME_MS = 1000.0f;
+
+constexpr int GATE_OPEN_STAGE = 0;
+constexpr int GATE_HOLD_STAGE = 1;
+constexpr int GATE_CLOSE_STAGE = 2;
+
+AudioEffectSOSF32::AudioEffectSOSF32(float maxDelayMs)
+: AudioStream_F32(1, m_inputQueueArray)
+{
+    m_memory = new AudioDelayF32(maxDelayMs);
+    m_maxDelaySamples = m_memory->getMaxDelaySamples();
+    m_externalMemory = false;
+}
+
+AudioEffectSOSF32::AudioEffectSOSF32(size_t numSamples)
+: AudioStream_F32(1, m_inputQueueArray)
+{
+    m_memory = new AudioDelayF32(numSamples);
+    m_maxDelaySamples = numSamples;
+    m_externalMemory = false;
+}
+
+AudioEffectSOSF32::AudioEffectSOSF32(ExtMemSlot *slot)
+: AudioStream_F32(1, m_inputQueueArray)
+{
+    m_memory = new AudioDelayF32(slot);
+    m_externalMemory = true;
+}
+
+AudioEffectSOSF32::~AudioEffectSOSF32()
+{
+    if (m_memory) delete m_memory;
+}
+
+void AudioEffectSOSF32::setGateLedGpio(int pinId)
+{
+    m_gateLedPinId = pinId;
+    pinMode(static_cast<uint8_t>(m_gateLedPinId), OUTPUT);
+}
+
+void AudioEffectSOSF32::enable(void)
+{
+    m_enable = true;
+    if (m_externalMemory) {
+        ExtMemSlot *slot = m_memory->getSlot();
+        if (!slot->isEnabled()) { slot->enable(); }
+        m_maxDelaySamples = m_memory->getMaxDelaySamples();
+        if (Serial) { Serial.println(String("SOS Enabled with delay length ") + m_maxDelaySamples + String(" samples")); }
+    }
+    m_delaySamples = m_maxDelaySamples;
+    m_inputGateAuto.setupParameter(GATE_OPEN_STAGE, 0.0f, 1.0f, 1000.0f, ParameterAutomation<float>::Function::EXPONENTIAL);
+    m_inputGateAuto.setupParameter(GATE_HOLD_STAGE, 1.0f, 1.0f, m_delaySamples, ParameterAutomation<float>::Function::HOLD);
+    m_inputGateAuto.setupParameter(GATE_CLOSE_STAGE, 1.0f, 0.0f, 1000.0f, ParameterAutomation<float>::Function::EXPONENTIAL);
+
+    m_clearFeedbackAuto.setupParameter(GATE_OPEN_STAGE, 1.0f, 0.0f, 1000.0f, ParameterAutomation<float>::Function::EXPONENTIAL);
+    m_clearFeedbackAuto.setupParameter(GATE_HOLD_STAGE, 0.0f, 0.0f, m_delaySamples, ParameterAutomation<float>::Function::HOLD);
+    m_clearFeedbackAuto.setupParameter(GATE_CLOSE_STAGE, 0.0f, 1.0f, 1000.0f, ParameterAutomation<float>::Function::EXPONENTIAL);
+}
+
+void AudioEffectSOSF32::update(void)
+{
+
+    // Check is block is disabled
+    if (m_enable == false) {
+        // do not transmit or process any audio, return as quickly as possible.
+        // the feedback starts from silence when enabled again, as in AudioEffectSOS
+        memset(m_previousOutput, 0, sizeof(float) * AUDIO_BLOCK_SAMPLES);
+        // release the pending input so it is not held in the queue
+        audio_block_f32_t *inputAudioBlock = receiveReadOnly_f32();
+        if (inputAudioBlock) { AudioStream_F32::release(inputAudioBlock); }
+        return;
+    }
+
+    audio_block_f32_t *inputAudioBlock = receiveReadOnly_f32(); // get the next block of input samples
+
+    // Check is block is bypassed, if so either transmit input directly or create silence
+    if ( (m_bypass == true) || (!inputAudioBlock) ) {
+        // transmit the input directly
+        if (!inputAudioBlock) {
+            // create silence
+            inputAudioBlock = allocate_f32();
+            if (!inputAudioBlock) { return; } // failed to allocate
+            else {
+                memset(inputAudioBlock->data, 0, sizeof(float) * AUDIO_BLOCK_SAMPLES);
+            }
+        }
+        AudioStream_F32::transmit(inputAudioBlock, 0);
+        AudioStream_F32::release(inputAudioBlock);
+        return;
+    }
+
+    audio_block_f32_t *blockToOutput = allocate_f32(); // this will hold the output audio
+    if (!blockToOutput) {
+        AudioStream_F32::release(inputAudioBlock);
+        return; // skip this update cycle due to failure
+    }
+
+    // Request the read first so a DMA read from external memory runs while the
+    // input is processed.
+    m_memory->getSamples(blockToOutput->data, m_delaySamples);
+
+    // mix the input with the feedback path in the pre-processing stage
+    m_preProcessing(m_preProcessed, inputAudioBlock->data, m_previousOutput);
+    m_memory->addBlock(m_preProcessed);
+
+    // BACK TO OUTPUT PROCESSING
+    m_memory->waitForRead();
+
+    // Set the output volume
+    float *out = blockToOutput->data;
+    for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+        out[i] *= m_volume;
+    }
+
+    // the output is fed back, the same as AudioEffectSOS
+    memcpy(m_previousOutput, blockToOutput->data, sizeof(float) * AUDIO_BLOCK_SAMPLES);
+    AudioStream_F32::transmit(blockToOutput);
+
+    AudioStream_F32::release(blockToOutput);
+    AudioStream_F32::release(inputAudioBlock);
+}
+
+
+void AudioEffectSOSF32::gateOpenTime(float milliseconds)
+{
+    m_openTimeMs = milliseconds;
+    m_inputGateAuto.setupParameter(GATE_OPEN_STAGE, 0.0f, 1.0f, m_openTimeMs, ParameterAutomation<float>::Function::EXPONENTIAL);
+}
+
+void AudioEffectSOSF32::gateCloseTime(float milliseconds)
+{
+    m_closeTimeMs = milliseconds;
+    m_inputGateAuto.setupParameter(GATE_CLOSE_STAGE, 1.0f, 0.0f, m_closeTimeMs, ParameterAutomation<float>::Function::EXPONENTIAL);
+}
+
+////////////////////////////////////////////////////////////////////////
+// MIDI PROCESSING
+////////////////////////////////////////////////////////////////////////
+void AudioEffectSOSF32::processMidi(int channel, int control, int value)
+{
+
+    float val = (float)value / 127.0f;
+
+    if ((m_midiConfig[GATE_OPEN_TIME][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[GATE_OPEN_TIME][MIDI_CONTROL] == control)) {
+        // Gate Open Time
+        gateOpenTime(val * MAX_GATE_OPEN_TIME_MS);
+        if (Serial) { Serial.println(String("AudioEffectSOSF32::gate open time (ms): ") + m_openTimeMs); }
+        return;
+    }
+
+    if ((m_midiConfig[GATE_CLOSE_TIME][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[GATE_CLOSE_TIME][MIDI_CONTROL] == control)) {
+        // Gate Close Time
+        gateCloseTime(val * MAX_GATE_CLOSE_TIME_MS);
+        if (Serial) { Serial.println(String("AudioEffectSOSF32::gate close time (ms): ") + m_closeTimeMs); }
+        return;
+    }
+
+    if ((m_midiConfig[FEEDBACK][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[FEEDBACK][MIDI_CONTROL] == control)) {
+        // Feedback
+        if (Serial) { Serial.println(String("AudioEffectSOSF32::feedback: ") + 100*val + String("%")); }
+        feedback(val);
+        return;
+    }
+
+    if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+        // Volume
+        if (Serial) { Serial.println(String("AudioEffectSOSF32::volume: ") + 100*val + String("%")); }
+        volume(val);
+        return;
+    }
+
+    if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+        // Bypass
+        if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectSOSF32::not bypassed -> ON") + value); }
+        else { bypass(true); if (Serial) Serial.println(String("AudioEffectSOSF32::bypassed -> OFF") + value); }
+        return;
+    }
+
+    if ((m_midiConfig[GATE_TRIGGER][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[GATE_TRIGGER][MIDI_CONTROL] == control)) {
+        // The gate is triggered by any value
+        if (Serial) { Serial.println(String("AudioEffectSOSF32::Gate Triggered!")); }
+        m_inputGateAuto.trigger();
+        return;
+    }
+
+    if ((m_midiConfig[CLEAR_FEEDBACK_TRIGGER][MIDI_CHANNEL] == channel) &&
+        (m_midiConfig[CLEAR_FEEDBACK_TRIGGER][MIDI_CONTROL] == control)) {
+        // The gate is triggered by any value
+        if (Serial) { Serial.println(String("AudioEffectSOSF32::Clear feedback Triggered!")); }
+        m_clearFeedbackAuto.trigger();
+        return;
+    }
+}
+
+void AudioEffectSOSF32::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+    if (parameter >= NUM_CONTROLS) {
+        return ; // Invalid midi parameter
+    }
+    m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+    m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+//////////////////////////////////////////////////////////////////////
+// PRIVATE FUNCTIONS
+//////////////////////////////////////////////////////////////////////
+void AudioEffectSOSF32::m_preProcessing (float *out, const float *input, const float *delayedSignal)
+{
+    // Multiply the input signal by the automated gate value
+    // Multiply the delayed signal by the user set feedback value
+    // Then combine the two, the automations are evaluated per sample
+    float gateVol[AUDIO_BLOCK_SAMPLES];
+    float feedbackAdjust[AUDIO_BLOCK_SAMPLES];
+    m_inputGateAuto.getNextVector(gateVol);
+    m_clearFeedbackAuto.getNextVector(feedbackAdjust);
+
+    for (unsigned i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+        out[i] = gateVol[i]*input[i] + m_feedback*feedbackAdjust[i]*delayedSignal[i];
+    }
+
+    // Update the gate LED
+    if (m_gateLedPinId >= 0) {
+        if (m_inputGateAuto.isFinished() && m_clearFeedbackAuto.isFinished()) {
+            digitalWriteFast(m_gateLedPinId, 0x0);
+        } else {
+            digitalWriteFast(m_gateLedPinId, 0x1);
+        }
+    }
+}
+
+} // namespace BAEffects
+
+#endif /* BALIBRARY_F32 */
@@ -18,7 +18,6 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <cmath> // std::roundf
 #include "AudioEffectTremolo.h"
 
 using namespace BALibrary;
@@ -67,15 +66,17 @@ void AudioEffectTremolo::update(void)
 	}
 
 	// DO PROCESSING
-	// apply modulation wave
-	float *mod = m_osc.getNextVector();
+	// Remap the LFO to a gain of volume*((1-depth) + depth*(lfo+1)/2) in Q15,
+	// then apply it with a single multiply pass.
+	const int32_t gainOffset = static_cast<int32_t>(m_volume * (1.0f - m_depth) * 32767.0f);
+	const int32_t gainDepth  = static_cast<int32_t>(m_volume * m_depth * 32767.0f);
+
+	int16_t *mod = m_osc.getNextVector();
 	for (auto i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
-		mod[i] = (mod[i] + 1.0f) / 2.0f;
-		mod[i] = (1.0f - m_depth) + mod[i]*m_depth;
-		mod[i] = m_volume * mod[i];
-		float sample = std::roundf(mod[i] * (float)inputAudioBlock->data[i]);
-		inputAudioBlock->data[i] = (int16_t)sample;
+		const int32_t unipolar = (mod[i] + 32767) >> 1; // 0 to 32767
+		mod[i] = static_cast<int16_t>(gainOffset + ((gainDepth * unipolar) >> 15));
 	}
+	modulateSamples(inputAudioBlock->data, inputAudioBlock->data, mod, AUDIO_BLOCK_SAMPLES);
 
 	transmit(inputAudioBlock);
 	release(inputAudioBlock);
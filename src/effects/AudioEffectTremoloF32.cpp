@@ -0,0 +1,167 @@
+/*
+ * AudioEffectTremoloF32.cpp
+ *
+ *  Created on: October 18, 2026
+ *      Author: slascos
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.*
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AudioEffectTremoloF32.h"
+
+#if BALIBRARY_F32
+
+using namespace BALibrary;
+
+namespace BAEffects {
+
+constexpr int MIDI_CHANNEL = 0;
+constexpr int MIDI_CONTROL = 1;
+
+constexpr float MAX_RATE_HZ = 20.0f;
+
+AudioEffectTremoloF32::AudioEffectTremoloF32()
+: AudioStream_F32(1, m_inputQueueArray)
+{
+	m_osc.setWaveform(m_waveform);
+}
+
+AudioEffectTremoloF32::~AudioEffectTremoloF32()
+{
+}
+
+void AudioEffectTremoloF32::update(void)
+{
+	// Check is block is disabled
+	if (m_enable == false) {
+		// do not transmit or process any audio, return as quickly as possible.
+		return;
+	}
+
+	audio_block_f32_t *inputAudioBlock = receiveWritable_f32(); // get the next block of input samples
+
+	// Check is block is bypassed, if so either transmit input directly or create silence
+	if ((m_bypass == true) || (!inputAudioBlock)) {
+		// transmit the input directly
+		if (!inputAudioBlock) {
+			// create silence
+			inputAudioBlock = allocate_f32();
+			if (!inputAudioBlock) { return; } // failed to allocate
+			else {
+				memset(inputAudioBlock->data, 0, sizeof(float) * AUDIO_BLOCK_SAMPLES);
+			}
+		}
+		AudioStream_F32::transmit(inputAudioBlock, 0);
+		AudioStream_F32::release(inputAudioBlock);
+		return;
+	}
+
+	// DO PROCESSING
+	// gain = volume*((1-depth) + depth*(lfo+1)/2)
+	const float gainOffset = m_volume * (1.0f - 0.5f*m_depth);
+	const float gainDepth  = 0.5f * m_volume * m_depth;
+
+	const float *mod = m_osc.getNextVector();
+	float *data = inputAudioBlock->data;
+	for (auto i=0; i<AUDIO_BLOCK_SAMPLES; i++) {
+		data[i] *= gainOffset + gainDepth*mod[i];
+	}
+
+	AudioStream_F32::transmit(inputAudioBlock);
+	AudioStream_F32::release(inputAudioBlock);
+}
+
+void AudioEffectTremoloF32::rate(float rateValue)
+{
+	m_rate = rateValue;
+	float rateAudioBlock = rateValue * MAX_RATE_HZ;
+	m_osc.setRateAudio(rateAudioBlock);
+}
+
+void AudioEffectTremoloF32::setWaveform(Waveform waveform)
+{
+	m_waveform = waveform;
+	m_osc.setWaveform(waveform);
+}
+
+void AudioEffectTremoloF32::processMidi(int channel, int control, int value)
+{
+
+	float val = (float)value / 127.0f;
+
+	if ((m_midiConfig[BYPASS][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[BYPASS][MIDI_CONTROL] == control)) {
+		// Bypass
+		if (value >= 65) { bypass(false); if (Serial) Serial.println(String("AudioEffectTremoloF32::not bypassed -> ON") + value); }
+		else { bypass(true); if (Serial) Serial.println(String("AudioEffectTremoloF32::bypassed -> OFF") + value); }
+		return;
+	}
+
+	if ((m_midiConfig[RATE][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[RATE][MIDI_CONTROL] == control)) {
+		// Rate
+		rate(val);
+		if (Serial) { Serial.println(String("AudioEffectTremoloF32::rate: ") + m_rate); }
+		return;
+	}
+
+	if ((m_midiConfig[DEPTH][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[DEPTH][MIDI_CONTROL] == control)) {
+		// Depth
+		depth(val);
+		if (Serial) { Serial.println(String("AudioEffectTremoloF32::depth: ") + m_depth); }
+		return;
+	}
+
+	if ((m_midiConfig[WAVEFORM][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[WAVEFORM][MIDI_CONTROL] == control)) {
+		// Waveform
+		if (value < 16) {
+			setWaveform(Waveform::SINE);
+		} else if (value < 32) {
+			setWaveform(Waveform::TRIANGLE);
+		} else if (value < 48) {
+			setWaveform(Waveform::SQUARE);
+		} else if (value < 64) {
+			setWaveform(Waveform::SAWTOOTH);
+		} else if (value < 80) {
+			setWaveform(Waveform::RANDOM);
+		}
+
+		if (Serial) { Serial.println(String("AudioEffectTremoloF32::waveform: ") + static_cast<unsigned>(m_waveform)); }
+		return;
+	}
+
+	if ((m_midiConfig[VOLUME][MIDI_CHANNEL] == channel) &&
+		(m_midiConfig[VOLUME][MIDI_CONTROL] == control)) {
+		// Volume
+		if (Serial) { Serial.println(String("AudioEffectTremoloF32::volume: ") + 100*val + String("%")); }
+		volume(val);
+		return;
+	}
+
+}
+
+void AudioEffectTremoloF32::mapMidiControl(int parameter, int midiCC, int midiChannel)
+{
+	if (parameter >= NUM_CONTROLS) {
+		return ; // Invalid midi parameter
+	}
+	m_midiConfig[parameter][MIDI_CHANNEL] = midiChannel;
+	m_midiConfig[parameter][MIDI_CONTROL] = midiCC;
+}
+
+}
+
+#endif /* BALIBRARY_F32 */
@@ -36,6 +36,7 @@ constexpr int SPI_ADDR_0_MASK = 0x0000FF;
 
 constexpr int CMD_ADDRESS_SIZE = 4;
 constexpr int MAX_DMA_XFER_SIZE = 0x400;
+constexpr unsigned MAX_DMA_BATCH_XFERS = 2*MAX_SPI_MEM_BATCH_READS; // batch read CMD/data transfer pairs
 
 constexpr size_t MEM_ALIGNED_ALLOC = 32; // number of bytes to align DMA buffer to
 
@@ -228,6 +229,15 @@ void BASpiMemory::read16(size_t address, uint16_t *dest, size_t numWords)
     }
 }
 
+bool BASpiMemory::readBatch16(const SpiMemReadRequest *requests, unsigned numRequests)
+{
+    if (numRequests > MAX_SPI_MEM_BATCH_READS) { return false; }
+    for (unsigned i=0; i<numRequests; i++) {
+        read16(requests[i].address, requests[i].dest, requests[i].numWords);
+    }
+    return true;
+}
+
 // PRIVATE FUNCTIONS
 size_t BASpiMemory::m_bytesToXfer(size_t address, size_t numBytes)
 {
@@ -369,6 +379,8 @@ BASpiMemoryDMA::~BASpiMemoryDMA()
 	if (m_rxTransfer) delete [] m_rxTransfer;
 	if (m_txCommandBuffer) delete [] m_txCommandBuffer;
 	if (m_rxCommandBuffer) delete [] m_txCommandBuffer;
+	if (m_batchTransfer) delete [] m_batchTransfer;
+	if (m_batchCommandBuffer) delete [] m_batchCommandBuffer;
 }
 
 void BASpiMemoryDMA::m_setSpiCmdAddr(int command, size_t address, uint8_t *dest)
@@ -402,6 +414,8 @@ void BASpiMemoryDMA::begin(void)
 	m_rxCommandBuffer = new uint8_t[CMD_ADDRESS_SIZE];
 	m_txTransfer = new DmaSpi::Transfer[2];
 	m_rxTransfer = new DmaSpi::Transfer[2];
+	m_batchCommandBuffer = new uint8_t[CMD_ADDRESS_SIZE*MAX_DMA_BATCH_XFERS];
+	m_batchTransfer = new DmaSpi::Transfer[2*MAX_DMA_BATCH_XFERS];
 
 
 	switch (m_memDeviceId) {
@@ -556,6 +570,56 @@ void BASpiMemoryDMA::read16(size_t address, uint16_t *dest, size_t numWords)
 }
 
 
+// Every read in the batch gets its own CMD/address and data transfer pair. All pairs are registered
+// with the DMA queue at once so the reads run back-to-back. The intermediate buffer can be shared by
+// all of them since the DMA ISR copies it out to the destination when each transfer completes.
+bool BASpiMemoryDMA::readBatch16(const SpiMemReadRequest *requests, unsigned numRequests)
+{
+	if (numRequests > MAX_SPI_MEM_BATCH_READS) { return false; }
+
+	volatile uint8_t *intermediateBuffer = nullptr;
+	size_t maxXferSize = MAX_DMA_XFER_SIZE;
+
+	// Check for intermediate buffer use
+	if (m_dmaCopyBufferSize) {
+		intermediateBuffer = m_dmaReadCopyBuffer;
+		if (m_dmaCopyBufferSize < maxXferSize) { maxXferSize = m_dmaCopyBufferSize; }
+	}
+
+	while (isReadBusy()) { yield(); } // the transfers can't be reused until the previous batch is done
+	m_batchXferCount = 0;
+
+	for (unsigned i=0; i<numRequests; i++) {
+		size_t bytesRemaining = requests[i].numWords * sizeof(uint16_t);
+		uint8_t *destPtr = reinterpret_cast<uint8_t*>(requests[i].dest);
+		size_t nextAddress = requests[i].address;
+
+		while (bytesRemaining > 0) {
+			if (m_batchXferCount >= MAX_DMA_BATCH_XFERS) {
+				// out of transfer pairs, wait for the queued ones to finish before starting over
+				while (isReadBusy()) { yield(); }
+				m_batchXferCount = 0;
+			}
+
+			size_t xferCount = m_bytesToXfer(nextAddress, min(bytesRemaining, maxXferSize)); // check for die boundary
+			uint8_t *commandBuffer = &m_batchCommandBuffer[CMD_ADDRESS_SIZE*m_batchXferCount];
+			DmaSpi::Transfer *xfer = &m_batchTransfer[2*m_batchXferCount];
+
+			m_setSpiCmdAddr(SPI_READ_CMD, nextAddress, commandBuffer);
+			xfer[0] = DmaSpi::Transfer(commandBuffer, CMD_ADDRESS_SIZE, nullptr, 0, m_cs, TransferType::NO_END_CS);
+			m_spiDma->registerTransfer(xfer[0]);
+			xfer[1] = DmaSpi::Transfer(nullptr, xferCount, destPtr, 0, m_cs, TransferType::NO_START_CS, nullptr, intermediateBuffer);
+			m_spiDma->registerTransfer(xfer[1]);
+			m_batchXferCount++;
+
+			bytesRemaining -= xferCount;
+			destPtr += xferCount;
+			nextAddress += xferCount;
+		}
+	}
+	return true;
+}
+
 bool BASpiMemoryDMA::isWriteBusy(void) const
 {
 	return (m_txTransfer[0].busy() or m_txTransfer[1].busy());
@@ -563,7 +627,11 @@ bool BASpiMemoryDMA::isWriteBusy(void) const
 
 bool BASpiMemoryDMA::isReadBusy(void) const
 {
-	return (m_rxTransfer[0].busy() or m_rxTransfer[1].busy());
+	if (m_rxTransfer[0].busy() or m_rxTransfer[1].busy()) { return true; }
+	for (unsigned i=0; i<2*m_batchXferCount; i++) {
+		if (m_batchTransfer[i].busy()) { return true; }
+	}
+	return false;
 }
 
 bool BASpiMemoryDMA::setDmaCopyBufferSize(size_t numBytes)